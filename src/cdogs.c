@@ -55,8 +55,10 @@
 #include <SDL.h>
 
 #include <cdogs/ai.h>
+#include <cdogs/ai_coop.h>
 #include <cdogs/campaigns.h>
 #include <cdogs/config.h>
+#include <cdogs/demo.h>
 #include <cdogs/draw.h>
 #include <cdogs/files.h>
 #include <cdogs/font.h>
@@ -75,6 +77,8 @@
 #include <cdogs/pic_manager.h>
 #include <cdogs/pics.h>
 #include <cdogs/player_template.h>
+#include <cdogs/rng.h>
+#include <cdogs/sim_checksum.h>
 #include <cdogs/sounds.h>
 #include <cdogs/triggers.h>
 #include <cdogs/utils.h>
@@ -795,8 +799,8 @@ static void PlaceActor(TActor * actor)
 	Vec2i pos;
 	do
 	{
-		pos.x = ((rand() % (gMap.Size.x * TILE_WIDTH)) << 8);
-		pos.y = ((rand() % (gMap.Size.y * TILE_HEIGHT)) << 8);
+		pos.x = RngInt(&gRngSim, gMap.Size.x * TILE_WIDTH) << 8;
+		pos.y = RngInt(&gRngSim, gMap.Size.y * TILE_HEIGHT) << 8;
 	}
 	while (!MapIsFullPosOKforPlayer(&gMap, pos, false) ||
 		!TryMoveActor(actor, pos));
@@ -876,6 +880,13 @@ static void CleanupMission(void)
 	}
 }
 
+// Seed the game streams for a mission, and record it if recording a demo
+static void MissionSeedGame(const CampaignOptions *co, const unsigned int seed)
+{
+	RngSeedGame(seed);
+	DemoRecordMission(&gDemo, co, seed);
+}
+
 static void InitPlayers(int numPlayers, int maxHealth, int mission)
 {
 	int i;
@@ -971,7 +982,7 @@ int Game(GraphicsDevice *graphics, CampaignOptions *co)
 		if (PlayerEquip(gOptions.numPlayers, graphics))
 		{
 			MapLoad(&gMap, &gMission, &co->Setting.characters);
-			srand((unsigned int)time(NULL));
+			MissionSeedGame(co, (unsigned int)time(NULL));
 			InitializeBadGuys();
 			const int maxHealth = 200 * gConfig.Game.PlayerHP / 100;
 			InitPlayers(gOptions.numPlayers, maxHealth, co->MissionIndex);
@@ -1087,7 +1098,7 @@ void DogFight(GraphicsDevice *graphicsDevice, CampaignOptions *co)
 		if (PlayerEquip(gOptions.numPlayers, graphicsDevice))
 		{
 			MapLoad(&gMap, &gMission, &co->Setting.characters);
-			srand((unsigned int)time(NULL));
+			MissionSeedGame(co, (unsigned int)time(NULL));
 			InitPlayers(gOptions.numPlayers, 500, 0);
 			PlayGameSong();
 			run = gameloop();
@@ -1126,6 +1137,92 @@ void DogFight(GraphicsDevice *graphicsDevice, CampaignOptions *co)
 	}
 }
 
+// Play the loaded campaign without menus or drawing, all players AI
+static void HeadlessGame(CampaignOptions *co)
+{
+	int i;
+	for (i = 0; i < MAX_PLAYERS; i++)
+	{
+		InitData(&gPlayerDatas[i]);
+		gPlayerDatas[i].inputDevice = INPUT_DEVICE_AI;
+	}
+	if (gOptions.numPlayers == 0)
+	{
+		gOptions.numPlayers = 1;
+	}
+	co->MissionIndex = 0;
+
+	bool run = false;
+	bool gameOver = true;
+	do
+	{
+		CampaignAndMissionSetup(1, co, &gMission);
+		printf("Headless: mission %d\n", co->MissionIndex + 1);
+		for (i = 0; i < gOptions.numPlayers; i++)
+		{
+			gPlayerDatas[i].weapons[0] = AICoopSelectWeapon(
+				i, &gMission.missionData->Weapons);
+			gPlayerDatas[i].weaponCount = 1;
+		}
+		MapLoad(&gMap, &gMission, &co->Setting.characters);
+		// Seed from the campaign, so that runs with the same seed
+		// play out the same
+		MissionSeedGame(co, 10 * co->MissionIndex + co->seed);
+		InitializeBadGuys();
+		const int maxHealth = 200 * gConfig.Game.PlayerHP / 100;
+		InitPlayers(gOptions.numPlayers, maxHealth, co->MissionIndex);
+		CreateEnemies();
+		run = gameloop();
+
+		gameOver = GetNumPlayersAlive() == 0 ||
+			co->MissionIndex == (int)gCampaign.Setting.Missions.size - 1;
+
+		CleanupMission();
+		MissionOptionsTerminate(&gMission);
+		co->MissionIndex++;
+	}
+	while (run && !gameOver);
+}
+
+// Play back a recorded demo; headless if that is enabled too
+static void ReplayGame(CampaignOptions *co)
+{
+	int i;
+	for (i = 0; i < MAX_PLAYERS; i++)
+	{
+		InitData(&gPlayerDatas[i]);
+	}
+	gOptions.numPlayers = gDemo.NumPlayers;
+	const bool isDogfight = co->Entry.Mode == CAMPAIGN_MODE_DOGFIGHT;
+	gOptions.badGuys = !isDogfight;
+
+	unsigned int seed;
+	while (!gEventHandlers.HasQuit &&
+		DemoReplayMission(&gDemo, &co->MissionIndex, &seed))
+	{
+		CampaignAndMissionSetup(1, co, &gMission);
+		printf("Replay: mission %d\n", co->MissionIndex + 1);
+		MapLoad(&gMap, &gMission, &co->Setting.characters);
+		RngSeedGame(seed);
+		if (isDogfight)
+		{
+			InitPlayers(gOptions.numPlayers, 500, 0);
+		}
+		else
+		{
+			InitializeBadGuys();
+			const int maxHealth = 200 * gConfig.Game.PlayerHP / 100;
+			InitPlayers(gOptions.numPlayers, maxHealth, co->MissionIndex);
+			CreateEnemies();
+		}
+		gameloop();
+
+		CleanupMission();
+		MissionOptionsTerminate(&gMission);
+	}
+	gOptions.badGuys = 1;
+}
+
 void MainLoop(credits_displayer_t *creditsDisplayer, custom_campaigns_t *campaigns)
 {
 	while (
@@ -1169,6 +1266,8 @@ void MainLoop(credits_displayer_t *creditsDisplayer, custom_campaigns_t *campaig
 			DisplayTodaysHighScores(&gGraphicsDevice);
 		}
 		gCampaign.IsLoaded = false;
+		// Demos only hold one campaign
+		DemoTerminate(&gDemo);
 	}
 	debug(D_NORMAL, ">> Leaving Main Game Loop\n");
 }
@@ -1218,6 +1317,17 @@ static void PrintHelp(void)
 	printf("%s\n",
 		"Other:\n"
 		"    --connect=host   (Experimental) connect to a game server\n"
+		"    --headless       Run the campaign given on the command line with\n"
+		"                       AI players, no video or sound, as fast as\n"
+		"                       possible, and print simulation timings.\n"
+		"    --ticks=n        In headless mode, end each mission after n ticks.\n"
+		"    --record=file    Record the next campaign played to a demo file.\n"
+		"    --replay=file    Play back a demo file; use with --headless to\n"
+		"                       replay it as fast as possible.\n"
+		"    --checksum=file  Write checksums of the game state every tick.\n"
+		"    --checksumdiff=file1 file2\n"
+		"                     Compare two checksum files and report the first\n"
+		"                       tick and part of the game that differ.\n"
 		);
 
 	printf("%s\n",
@@ -1239,6 +1349,7 @@ int main(int argc, char *argv[])
 	int forceResolution = 0;
 	int err = 0;
 	const char *loadCampaign = NULL;
+	const char *checksumDiff = NULL;
 	ENetAddress connectAddr;
 	memset(&connectAddr, 0, sizeof connectAddr);
 
@@ -1276,12 +1387,18 @@ int main(int argc, char *argv[])
 			{"wait",		no_argument,		NULL,	'w'},
 			{"shakemult",	required_argument,	NULL,	'm'},
 			{"connect",		required_argument,	NULL,	'x'},
+			{"headless",	no_argument,		NULL,	'l'},
+			{"ticks",		required_argument,	NULL,	't'},
+			{"record",		required_argument,	NULL,	'r'},
+			{"replay",		required_argument,	NULL,	'p'},
+			{"checksum",	required_argument,	NULL,	'k'},
+			{"checksumdiff",	required_argument,	NULL,	'd'},
 			{"help",		no_argument,		NULL,	'h'},
 			{0,				0,					NULL,	0}
 		};
 		int opt = 0;
 		int idx = 0;
-		while ((opt = getopt_long(argc, argv,"fs:c:onjwm:xh", longopts, &idx)) != -1)
+		while ((opt = getopt_long(argc, argv,"fs:c:onjwm:xhlt:r:p:k:d:", longopts, &idx)) != -1)
 		{
 			switch (opt)
 			{
@@ -1324,6 +1441,41 @@ int main(int argc, char *argv[])
 					printf("Shake multiplier: %d\n", gConfig.Graphics.ShakeMultiplier);
 				}
 				break;
+			case 'l':
+				gHeadless.Enabled = true;
+				snd_flag = 0;
+				isSoundEnabled = 0;
+				js_flag = 0;
+				break;
+			case 't':
+				gHeadless.MaxTicks = MAX(atoi(optarg), 0);
+				break;
+			case 'r':
+				if (!DemoRecordStart(&gDemo, optarg))
+				{
+					err = EXIT_FAILURE;
+					goto bail;
+				}
+				break;
+			case 'p':
+				// Read the header now so that its config applies to
+				// the video setup too
+				if (!DemoReplayStart(&gDemo, optarg))
+				{
+					err = EXIT_FAILURE;
+					goto bail;
+				}
+				break;
+			case 'k':
+				if (!SimChecksumsStart(&gSimChecksums, optarg))
+				{
+					err = EXIT_FAILURE;
+					goto bail;
+				}
+				break;
+			case 'd':
+				checksumDiff = optarg;
+				break;
 			case 'h':
 				PrintHelp();
 				goto bail;
@@ -1354,6 +1506,33 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (checksumDiff != NULL)
+	{
+		// Tool mode; compare and quit
+		if (loadCampaign == NULL)
+		{
+			printf("Error: need two checksum files to compare\n");
+			err = EXIT_FAILURE;
+		}
+		else if (!SimChecksumsDiff(checksumDiff, loadCampaign))
+		{
+			err = EXIT_FAILURE;
+		}
+		goto bail;
+	}
+
+	if (gHeadless.Enabled)
+	{
+		if (loadCampaign == NULL && gDemo.Mode != DEMO_MODE_REPLAY)
+		{
+			printf("Error: headless mode needs a campaign file\n");
+			err = EXIT_FAILURE;
+			goto bail;
+		}
+		// Don't open a window
+		SDL_putenv("SDL_VIDEODRIVER=dummy");
+	}
+
 	debug(D_NORMAL, "Initialising SDL...\n");
 	if (SDL_Init(SDL_INIT_TIMER | snd_flag | SDL_INIT_VIDEO | js_flag) != 0)
 	{
@@ -1454,7 +1633,7 @@ int main(int argc, char *argv[])
 
 		debug(D_NORMAL, ">> Entering main loop\n");
 		// Attempt to pre-load campaign if requested
-		if (loadCampaign != NULL)
+		if (loadCampaign != NULL && gDemo.Mode != DEMO_MODE_REPLAY)
 		{
 			CampaignEntry entry;
 			if (CampaignEntryTryLoad(
@@ -1503,7 +1682,33 @@ int main(int argc, char *argv[])
 				}
 			}
 		}
-		MainLoop(&creditsDisplayer, &campaigns);
+		if (gDemo.Mode == DEMO_MODE_REPLAY)
+		{
+			if (DemoReplayLoadCampaign(&gDemo, &gCampaign))
+			{
+				ReplayGame(&gCampaign);
+			}
+			else
+			{
+				err = EXIT_FAILURE;
+			}
+		}
+		else if (gHeadless.Enabled)
+		{
+			if (gCampaign.IsLoaded)
+			{
+				HeadlessGame(&gCampaign);
+			}
+			else
+			{
+				printf("Error: cannot load campaign %s\n", loadCampaign);
+				err = EXIT_FAILURE;
+			}
+		}
+		else
+		{
+			MainLoop(&creditsDisplayer, &campaigns);
+		}
 	}
 
 bail:
@@ -1521,7 +1726,13 @@ bail:
 	PicManagerTerminate(&gPicManager);
 	AutosaveSave(&gAutosave, GetConfigFilePath(AUTOSAVE_FILE));
 	AutosaveTerminate(&gAutosave);
-	ConfigSave(&gConfig, GetConfigFilePath(CONFIG_FILE));
+	// Replays overwrite the game config with the demo's
+	if (gDemo.Mode != DEMO_MODE_REPLAY)
+	{
+		ConfigSave(&gConfig, GetConfigFilePath(CONFIG_FILE));
+	}
+	DemoTerminate(&gDemo);
+	SimChecksumsTerminate(&gSimChecksums);
 	SavePlayerTemplates(gPlayerTemplates, PLAYER_TEMPLATE_FILE);
 	FreeSongs(&gMenuSongs);
 	FreeSongs(&gGameSongs);
@@ -0,0 +1,104 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "activity.h"
+
+#include <stdlib.h>
+
+#include "actors.h"
+#include "config.h"
+#include "tile.h"
+#include "utils.h"
+
+Activity gActivity;
+
+
+static void SetCenters(Activity *a);
+void ActivityUpdate(Activity *a, const int ticks)
+{
+	a->Range = Vec2iNew(
+		gConfig.Game.ActivityRange * TILE_WIDTH << 8,
+		gConfig.Game.ActivityRange * TILE_HEIGHT << 8);
+	SetCenters(a);
+	a->Bucket = (a->Bucket + 1) % ACTIVITY_BUCKETS;
+	for (int i = 0; i < (int)gActors.size; i++)
+	{
+		TActor *actor = CArrayGet(&gActors, i);
+		if (!actor->isInUse)
+		{
+			continue;
+		}
+		// Players, and actors that are dying, always run at full rate
+		if (actor->pData != NULL || actor->health <= 0 ||
+			ActivityIsActive(a, actor->Pos))
+		{
+			actor->activityTicks = ticks + actor->activitySkipped;
+			actor->activitySkipped = 0;
+			continue;
+		}
+		actor->activitySkipped += ticks;
+		if (i % ACTIVITY_BUCKETS == a->Bucket)
+		{
+			actor->activityTicks = actor->activitySkipped;
+			actor->activitySkipped = 0;
+		}
+		else
+		{
+			actor->activityTicks = 0;
+		}
+	}
+}
+static void SetCenters(Activity *a)
+{
+	a->NumCenters = 0;
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (!IsPlayerAlive(i))
+		{
+			continue;
+		}
+		const TActor *player = CArrayGet(&gActors, gPlayerIds[i]);
+		a->Centers[a->NumCenters] = player->Pos;
+		a->NumCenters++;
+	}
+}
+
+bool ActivityIsActive(const Activity *a, const Vec2i fullPos)
+{
+	// With no players left, keep everything running until the game ends
+	if (a->Range.x == 0 || a->NumCenters == 0)
+	{
+		return true;
+	}
+	for (int i = 0; i < a->NumCenters; i++)
+	{
+		if (abs(fullPos.x - a->Centers[i].x) < a->Range.x &&
+			abs(fullPos.y - a->Centers[i].y) < a->Range.y)
+		{
+			return true;
+		}
+	}
+	return false;
+}
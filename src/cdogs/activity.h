@@ -0,0 +1,57 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __ACTIVITY
+#define __ACTIVITY
+
+#include <stdbool.h>
+
+#include "character.h"
+#include "vector.h"
+
+// Activity regions; only things near the players are simulated every tick.
+// Actors outside every player's region are split into buckets, and each
+// tick one bucket is simulated for all the ticks it missed, so that the
+// cost per tick follows what's near the players, not what's on the map.
+// Actors catch up on any missed ticks as soon as they come back in range.
+#define ACTIVITY_BUCKETS 4
+
+typedef struct
+{
+	// Half-size of each player's region in full coordinates, from the range
+	// in tiles; 0 if everything is active
+	Vec2i Range;
+	int NumCenters;
+	Vec2i Centers[MAX_PLAYERS];	// of the players, in full coordinates
+	int Bucket;	// bucket that catches up this tick
+} Activity;
+extern Activity gActivity;
+
+// Work out the regions from the players' positions, and how many ticks
+// each actor is to be simulated for this tick (TActor.activityTicks)
+void ActivityUpdate(Activity *a, const int ticks);
+bool ActivityIsActive(const Activity *a, const Vec2i fullPos);
+
+#endif
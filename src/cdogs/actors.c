@@ -60,6 +60,7 @@
 #include "drawtools.h"
 #include "game_events.h"
 #include "pic_manager.h"
+#include "rng.h"
 #include "sounds.h"
 #include "defs.h"
 #include "objs.h"
@@ -118,7 +119,7 @@ static int delayTable[STATE_COUNT] = {
 // Initialise the actor post-placement
 void ActorInit(TActor *actor)
 {
-	actor->direction = rand() % DIRECTION_COUNT;
+	actor->direction = RngInt(&gRngSim, DIRECTION_COUNT);
 
 	actor->health = (actor->health * gConfig.Game.NonPlayerHP) / 100;
 	if (actor->health <= 0)
@@ -380,6 +381,7 @@ void UpdateActorState(TActor * actor, int ticks)
 		actor->dead++;
 		actor->stateCounter = 4;
 		actor->tileItem.flags = 0;
+		MapUpdateTileItem(&gMap, &actor->tileItem);
 		return;
 	}
 
@@ -400,7 +402,7 @@ void UpdateActorState(TActor * actor, int ticks)
 	}
 
 	if (actor->state == STATE_IDLE && !actor->petrified)
-		SetStateForActor(actor, ((rand() & 1) != 0 ?
+		SetStateForActor(actor, (RngInt(&gRngSim, 2) != 0 ?
 					 STATE_IDLELEFT :
 					 STATE_IDLERIGHT));
 	else
@@ -413,11 +415,11 @@ void UpdateActorState(TActor * actor, int ticks)
 
 static void CheckTrigger(const Vec2i tilePos)
 {
-	const Tile *t = MapGetTile(&gMap, tilePos);
+	const CArray *triggers = MapGetTileTriggers(&gMap, tilePos);
 	int i;
-	for (i = 0; i < (int)t->triggers.size; i++)
+	for (i = 0; i < (int)triggers->size; i++)
 	{
-		Trigger **tp = CArrayGet(&t->triggers, i);
+		Trigger **tp = CArrayGet(triggers, i);
 		if (TriggerCanActivate(*tp, gMission.flags))
 		{
 			GameEvent e;
@@ -554,6 +556,7 @@ bool TryMoveActor(TActor *actor, Vec2i pos)
 			    && (otherCharacter->flags & FLAGS_PRISONER) !=
 			    0) {
 				otherCharacter->flags &= ~FLAGS_PRISONER;
+				MapUpdateTileItem(&gMap, &otherCharacter->tileItem);
 				UpdateMissionObjective(
 					&gMission,
 					otherCharacter->tileItem.flags,
@@ -568,7 +571,7 @@ bool TryMoveActor(TActor *actor, Vec2i pos)
 		if (!gun->Gun->CanShoot && actor->health > 0)
 		{
 			object = target->kind == KIND_OBJECT ?
-				CArrayGet(&gObjs, target->id) : NULL;
+				CPoolGet(&gObjs, target->id) : NULL;
 			if (!object || (object->flags & OBJFLAG_DANGEROUS) == 0)
 			{
 				// Knife hit sound
@@ -639,7 +642,7 @@ bool TryMoveActor(TActor *actor, Vec2i pos)
 			isDogfight);
 		if (target && target->kind == KIND_OBJECT)
 		{
-			PickupObject(actor, CArrayGet(&gObjs, target->id));
+			PickupObject(actor, CPoolGet(&gObjs, target->id));
 		}
 	}
 
@@ -866,63 +869,105 @@ void SlideActor(TActor *actor, int cmd)
 }
 
 static void ActorUpdatePosition(TActor *actor, int ticks);
-void UpdateAllActors(int ticks)
+static void RepelAllies(void);
+void UpdateAllActors(void)
 {
 	for (int i = 0; i < (int)gActors.size; i++)
 	{
 		TActor *actor = CArrayGet(&gActors, i);
-		if (!actor->isInUse)
+		if (!actor->isInUse || actor->activityTicks == 0)
 		{
 			continue;
 		}
-		ActorUpdatePosition(actor, ticks);
-		UpdateActorState(actor, ticks);
+		ActorUpdatePosition(actor, actor->activityTicks);
+		UpdateActorState(actor, actor->activityTicks);
 		if (actor->dead > DEATH_MAX)
 		{
-			AddObjectOld(
-				actor->Pos.x, actor->Pos.y,
-				Vec2iZero(),
-				&cBloodPics[rand() % BLOOD_MAX],
-				OBJ_NONE,
-				TILEITEM_IS_WRECK);
+			AddDecalOld(
+				Vec2iFull2Real(actor->Pos),
+				&cBloodPics[RngInt(&gRngCosmetic, BLOOD_MAX)]);
 			ActorDestroy(i);
 		}
-		else
+	}
+	// Find actors that are on the same team and colliding,
+	// and repel them
+	if (gConfig.Game.AllyCollision == ALLYCOLLISION_REPEL)
+	{
+		RepelAllies();
+	}
+}
+// Scratch space for batched collision queries
+static CArray sRepelQueries;	// of SpatialQuery
+static CArray sRepelActors;	// of int
+static CArray sRepelResults;	// of ThingId
+static void RepelAllies(void)
+{
+	if (sRepelQueries.elemSize == 0)
+	{
+		CArrayInit(&sRepelQueries, sizeof(SpatialQuery));
+		CArrayInit(&sRepelActors, sizeof(int));
+		CArrayInit(&sRepelResults, sizeof(ThingId));
+	}
+	CArrayClear(&sRepelQueries);
+	CArrayClear(&sRepelActors);
+	const bool isDogfight = gCampaign.Entry.Mode == CAMPAIGN_MODE_DOGFIGHT;
+	for (int i = 0; i < (int)gActors.size; i++)
+	{
+		const TActor *actor = CArrayGet(&gActors, i);
+		if (!actor->isInUse)
 		{
-			// Find actors that are on the same team and colliding,
-			// and repel them
-			if (gConfig.Game.AllyCollision == ALLYCOLLISION_REPEL)
-			{
-				Vec2i realPos = Vec2iFull2Real(actor->Pos);
-				TTileItem *collidingItem = GetItemOnTileInCollision(
-					&actor->tileItem, realPos, TILEITEM_IMPASSABLE,
-					COLLISIONTEAM_NONE,
-					gCampaign.Entry.Mode == CAMPAIGN_MODE_DOGFIGHT);
-				if (collidingItem && collidingItem->kind == KIND_CHARACTER)
-				{
-					TActor *collidingActor = CArrayGet(
-						&gActors, collidingItem->id);
-					if (CalcCollisionTeam(1, collidingActor) ==
-						CalcCollisionTeam(1, actor))
-					{
-						Vec2i v = Vec2iMinus(actor->Pos, collidingActor->Pos);
-						if (Vec2iIsZero(v))
-						{
-							v = Vec2iNew(1, 0);
-						}
-						v = Vec2iScale(Vec2iNorm(v), REPEL_STRENGTH);
-						GameEvent e;
-						e.Type = GAME_EVENT_ACTOR_IMPULSE;
-						e.u.ActorImpulse.Id = actor->tileItem.id;
-						e.u.ActorImpulse.Vel = v;
-						GameEventsEnqueue(&gGameEvents, e);
-						e.u.ActorImpulse.Id = collidingActor->tileItem.id;
-						e.u.ActorImpulse.Vel = Vec2iScale(v, -1);
-						GameEventsEnqueue(&gGameEvents, e);
-					}
-				}
-			}
+			continue;
 		}
+		SpatialQuery q;
+		q.Item = &actor->tileItem;
+		q.Pos = Vec2iFull2Real(actor->Pos);
+		q.Mask = TILEITEM_IMPASSABLE;
+		q.Team = COLLISIONTEAM_NONE;
+		q.IsDogfight = isDogfight;
+		CArrayPushBack(&sRepelQueries, &q);
+		CArrayPushBack(&sRepelActors, &i);
+	}
+	if (sRepelQueries.size == 0)
+	{
+		return;
+	}
+	// Make room for one result per query
+	CArrayClear(&sRepelResults);
+	CArrayReserve(&sRepelResults, sRepelQueries.size);
+	sRepelResults.size = sRepelQueries.size;
+	SpatialHashGetFirstBatch(
+		&gMap.Broadphase, sRepelQueries.data, (int)sRepelQueries.size,
+		sRepelResults.data);
+
+	for (int i = 0; i < (int)sRepelResults.size; i++)
+	{
+		const ThingId *tid = CArrayGet(&sRepelResults, i);
+		if (tid->Id < 0 || tid->Kind != KIND_CHARACTER)
+		{
+			continue;
+		}
+		const int actorId = *(int *)CArrayGet(&sRepelActors, i);
+		TActor *actor = CArrayGet(&gActors, actorId);
+		TActor *collidingActor = CArrayGet(&gActors, tid->Id);
+		if (CalcCollisionTeam(1, collidingActor) !=
+			CalcCollisionTeam(1, actor))
+		{
+			continue;
+		}
+		Vec2i v = Vec2iMinus(actor->Pos, collidingActor->Pos);
+		if (Vec2iIsZero(v))
+		{
+			v = Vec2iNew(1, 0);
+		}
+		v = Vec2iScale(Vec2iNorm(v), REPEL_STRENGTH);
+		GameEvent e;
+		e.Type = GAME_EVENT_ACTOR_IMPULSE;
+		e.u.ActorImpulse.Id = actor->tileItem.id;
+		e.u.ActorImpulse.Vel = v;
+		GameEventsEnqueue(&gGameEvents, e);
+		e.u.ActorImpulse.Id = collidingActor->tileItem.id;
+		e.u.ActorImpulse.Vel = Vec2iScale(v, -1);
+		GameEventsEnqueue(&gGameEvents, e);
 	}
 }
 static void ActorUpdatePosition(TActor *actor, int ticks)
@@ -1004,6 +1049,8 @@ int ActorAdd(Character *c, struct PlayerData *p)
 		actor = CArrayGet(&gActors, i);
 	}
 	memset(actor, 0, sizeof *actor);
+	// Run normally until the activity regions are next updated
+	actor->activityTicks = 1;
 	CArrayInit(&actor->guns, sizeof(Weapon));
 	if (p != NULL)
 	{
@@ -138,6 +138,11 @@ typedef struct Actor
 	
 	int slideLock;
 
+	// Ticks to simulate this tick, and ticks skipped while out of range;
+	// see activity.h
+	int activityTicks;
+	int activitySkipped;
+
 	// Signals to other AIs what this actor is doing
 	ActorAction action;
 	AIContext *aiContext;
@@ -179,7 +184,7 @@ void UpdateActorState(TActor * actor, int ticks);
 bool TryMoveActor(TActor *actor, Vec2i pos);
 void CommandActor(TActor *actor, int cmd, int ticks);
 void SlideActor(TActor *actor, int cmd);
-void UpdateAllActors(int ticks);
+void UpdateAllActors(void);
 TActor *ActorList(void);
 void BuildTranslationTables(const TPalette palette);
 void Score(struct PlayerData *p, int points);
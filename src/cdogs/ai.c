@@ -59,6 +59,7 @@
 #include "gamedata.h"
 #include "mission.h"
 #include "sys_specifics.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 static int gBaddieCount = 0;
@@ -137,18 +138,16 @@ static bool CanSeeAPlayer(const TActor *a)
 		const TActor *player = CArrayGet(&gActors, gPlayerIds[i]);
 		const Vec2i playerRealPos = Vec2iFull2Real(player->Pos);
 		// Can see player if:
-		// - Clear line of sight, and
-		// - If they are close, or if facing and they are not too far
-		if (!AIHasClearShot(realPos, playerRealPos))
-		{
-			continue;
-		}
+		// - If they are close, or if facing and they are not too far, and
+		// - Clear line of sight
+		// Check the line of sight last as it is by far the most expensive
 		const int distance = CHEBYSHEV_DISTANCE(
 			realPos.x, realPos.y, playerRealPos.x, playerRealPos.y);
 		const bool isClose = distance < 16 * 4;
 		const bool isNotTooFar = distance < 16 * 30;
-		if (isClose ||
-			(isNotTooFar && IsFacing(realPos, playerRealPos, a->direction)))
+		if ((isClose ||
+			(isNotTooFar && IsFacing(realPos, playerRealPos, a->direction))) &&
+			AIHasClearShot(realPos, playerRealPos))
 		{
 			return true;
 		}
@@ -213,16 +212,16 @@ static bool IsDirectionOK(TActor *a, int dir)
 }
 
 
-static int BrightWalk(TActor * actor, int roll)
+static int BrightWalk(TActor * actor, int *flags, int roll)
 {
 	const CharBot *bot = actor->character->bot;
-	if (!!(actor->flags & FLAGS_VISIBLE) && roll < bot->probabilityToTrack)
+	if (!!(*flags & FLAGS_VISIBLE) && roll < bot->probabilityToTrack)
 	{
-		actor->flags &= ~FLAGS_DETOURING;
+		*flags &= ~FLAGS_DETOURING;
 		return AIHuntClosest(actor);
 	}
 
-	if (actor->flags & FLAGS_TRYRIGHT)
+	if (*flags & FLAGS_TRYRIGHT)
 	{
 		if (IsDirectionOK(actor, (actor->direction + 7) % 8))
 		{
@@ -230,7 +229,7 @@ static int BrightWalk(TActor * actor, int roll)
 			actor->turns--;
 			if (actor->turns == 0)
 			{
-				actor->flags &= ~FLAGS_DETOURING;
+				*flags &= ~FLAGS_DETOURING;
 			}
 		}
 		else if (!IsDirectionOK(actor, actor->direction))
@@ -238,7 +237,7 @@ static int BrightWalk(TActor * actor, int roll)
 			actor->direction = (actor->direction + 1) % 8;
 			actor->turns++;
 			if (actor->turns == 4) {
-				actor->flags &=
+				*flags &=
 				    ~(FLAGS_DETOURING | FLAGS_TRYRIGHT);
 				actor->turns = 0;
 			}
@@ -251,14 +250,14 @@ static int BrightWalk(TActor * actor, int roll)
 			actor->direction = (actor->direction + 1) % 8;
 			actor->turns--;
 			if (actor->turns == 0)
-				actor->flags &= ~FLAGS_DETOURING;
+				*flags &= ~FLAGS_DETOURING;
 		}
 		else if (!IsDirectionOK(actor, actor->direction))
 		{
 			actor->direction = (actor->direction + 7) % 8;
 			actor->turns++;
 			if (actor->turns == 4) {
-				actor->flags &=
+				*flags &=
 				    ~(FLAGS_DETOURING | FLAGS_TRYRIGHT);
 				actor->turns = 0;
 			}
@@ -288,11 +287,11 @@ static int WillFire(TActor * actor, int roll)
 	return 0;
 }
 
-void Detour(TActor * actor)
+static void Detour(TActor * actor, int *flags)
 {
-	actor->flags |= FLAGS_DETOURING;
+	*flags |= FLAGS_DETOURING;
 	actor->turns = 1;
-	if (actor->flags & FLAGS_TRYRIGHT)
+	if (*flags & FLAGS_TRYRIGHT)
 		actor->direction =
 		    (CmdToDirection(actor->lastCmd) + 1) % 8;
 	else
@@ -314,8 +313,8 @@ static void PlaceBaddie(TActor *actor)
 	for (i = 0; i < 100; i++)	// Don't try forever trying to place baddie
 	{
 		// Try spawning out of players' sights
-		actor->Pos.x = (rand() % (gMap.Size.x * TILE_WIDTH)) << 8;
-		actor->Pos.y = (rand() % (gMap.Size.y * TILE_HEIGHT)) << 8;
+		actor->Pos.x = RngInt(&gRngSim, gMap.Size.x * TILE_WIDTH) << 8;
+		actor->Pos.y = RngInt(&gRngSim, gMap.Size.y * TILE_HEIGHT) << 8;
 		TActor *closestPlayer = AIGetClosestPlayer(actor->Pos);
 		if (closestPlayer && CHEBYSHEV_DISTANCE(
 			actor->Pos.x, actor->Pos.y,
@@ -329,8 +328,8 @@ static void PlaceBaddie(TActor *actor)
 	// Keep trying, but this time try spawning anywhere, even close to player
 	while (!hasPlaced)
 	{
-		actor->Pos.x = (rand() % (gMap.Size.x * TILE_WIDTH)) << 8;
-		actor->Pos.y = (rand() % (gMap.Size.y * TILE_HEIGHT)) << 8;
+		actor->Pos.x = RngInt(&gRngSim, gMap.Size.x * TILE_WIDTH) << 8;
+		actor->Pos.y = RngInt(&gRngSim, gMap.Size.y * TILE_HEIGHT) << 8;
 		if (IsActorPositionValid(actor))
 		{
 			hasPlaced = 1;
@@ -340,7 +339,7 @@ static void PlaceBaddie(TActor *actor)
 
 	ActorInit(actor);
 	if (!(actor->flags & FLAGS_SLEEPALWAYS) &&
-		rand() % 100 < gBaddieCount)
+		RngInt(&gRngSim, 100) < gBaddieCount)
 	{
 		actor->flags &= ~FLAGS_SLEEPING;
 	}
@@ -352,8 +351,8 @@ static void PlacePrisoner(TActor *actor)
 	{
 		do
 		{
-			actor->Pos.x = ((rand() % (gMap.Size.x * TILE_WIDTH)) << 8);
-			actor->Pos.y = ((rand() % (gMap.Size.y * TILE_HEIGHT)) << 8);
+			actor->Pos.x = RngInt(&gRngSim, gMap.Size.x * TILE_WIDTH) << 8;
+			actor->Pos.y = RngInt(&gRngSim, gMap.Size.y * TILE_HEIGHT) << 8;
 		}
 		while (!MapPosIsHighAccess(
 			&gMap, actor->Pos.x >> 8, actor->Pos.y >> 8));
@@ -375,209 +374,320 @@ static bool DidPlayerShoot(void)
 	return 0;
 }
 
-void CommandBadGuys(int ticks)
+// Enemy AIs decide what to do in parallel, then carry out their commands
+// one by one in actor order, so that the results are the same however many
+// threads are used. While deciding, an AI only changes its own actor's
+// state (direction, AI context and so on) and otherwise only reads the
+// world, which stays as it was at the start of the tick.
+// Other AIs read actors' flags while deciding, so an AI's own flag changes
+// are decided into a copy and only written back when it is commanded.
+#define AI_DECIDE_FLAGS (FLAGS_DETOURING | FLAGS_TRYRIGHT | FLAGS_SLEEPING)
+static ThreadPool sThreadPool;
+static CArray sScratches;	// of AIScratch, one per thread
+static CArray sCmds;	// of int, one per actor
+static CArray sFlags;	// of int, one per actor
+void AIThreadsInit(void)
+{
+	ThreadPoolInit(
+		&sThreadPool, ThreadPoolNumThreads(gConfig.Game.AIThreads));
+	CArrayInit(&sScratches, sizeof(AIScratch));
+	for (int i = 0; i < sThreadPool.NumThreads; i++)
+	{
+		AIScratch s;
+		AIScratchInit(&s);
+		CArrayPushBack(&sScratches, &s);
+	}
+	CArrayInit(&sCmds, sizeof(int));
+	CArrayInit(&sFlags, sizeof(int));
+}
+void AIThreadsTerminate(void)
+{
+	ThreadPoolTerminate(&sThreadPool);
+	for (int i = 0; i < (int)sScratches.size; i++)
+	{
+		AIScratchTerminate(CArrayGet(&sScratches, i));
+	}
+	CArrayTerminate(&sScratches);
+	CArrayTerminate(&sCmds);
+	CArrayTerminate(&sFlags);
+}
+
+static bool IsEnemyAI(const TActor *actor)
+{
+	return actor->isInUse &&
+		!(actor->pData || (actor->flags & FLAGS_PRISONER));
+}
+
+typedef struct
+{
+	int DelayModifier;
+	int RollLimit;
+} DecideData;
+static int Decide(TActor *actor, int *flags, const DecideData *d);
+static void DecideForActor(void *data, const int index, const int worker)
+{
+	TActor *actor = CArrayGet(&gActors, index);
+	int *cmd = CArrayGet(&sCmds, index);
+	int *flags = CArrayGet(&sFlags, index);
+	*cmd = 0;
+	*flags = actor->flags;
+	// Actors out of range only decide when their bucket catches up
+	if (!IsEnemyAI(actor) || actor->activityTicks == 0)
+	{
+		return;
+	}
+	actor->aiContext->Scratch = CArrayGet(&sScratches, worker);
+	*cmd = Decide(actor, flags, data);
+	actor->aiContext->Scratch = NULL;
+}
+void CommandBadGuys(void)
 {
 	int count = 0;
-	int delayModifier;
-	int rollLimit;
+	DecideData d;
 
 	switch (gConfig.Game.Difficulty)
 	{
 	case DIFFICULTY_VERYEASY:
-		delayModifier = 4;
-		rollLimit = 300;
+		d.DelayModifier = 4;
+		d.RollLimit = 300;
 		break;
 	case DIFFICULTY_EASY:
-		delayModifier = 2;
-		rollLimit = 200;
+		d.DelayModifier = 2;
+		d.RollLimit = 200;
 		break;
 	case DIFFICULTY_HARD:
-		delayModifier = 1;
-		rollLimit = 75;
+		d.DelayModifier = 1;
+		d.RollLimit = 75;
 		break;
 	case DIFFICULTY_VERYHARD:
-		delayModifier = 1;
-		rollLimit = 50;
+		d.DelayModifier = 1;
+		d.RollLimit = 50;
 		break;
 	default:
-		delayModifier = 1;
-		rollLimit = 100;
+		d.DelayModifier = 1;
+		d.RollLimit = 100;
 		break;
 	}
 
+	// Update everything the AIs share before they start deciding
+	AIFlowFieldsUpdate();
+	MapUpdateRoomGraph(&gMap);
 	for (int i = 0; i < (int)gActors.size; i++)
+	{
+		const TActor *actor = CArrayGet(&gActors, i);
+		if (!IsEnemyAI(actor))
+		{
+			continue;
+		}
+		if ((actor->flags & (FLAGS_VICTIM | FLAGS_GOOD_GUY)) != 0)
+		{
+			gAreGoodGuysPresent = 1;
+		}
+		count++;
+	}
+
+	const int numActors = (int)gActors.size;
+	CArrayReserve(&sCmds, MAX(numActors, 1));
+	sCmds.size = numActors;
+	CArrayReserve(&sFlags, MAX(numActors, 1));
+	sFlags.size = numActors;
+	// Without path grids, pathfinding falls back to the generic A*, which
+	// is only run on the main thread
+	bool hasPathGrids = true;
+	for (int i = 0; i < (int)sScratches.size; i++)
+	{
+		hasPathGrids =
+			AIScratchSetupPathGrid(CArrayGet(&sScratches, i), &gMap) &&
+			hasPathGrids;
+	}
+	if (hasPathGrids)
+	{
+		ThreadPoolRun(&sThreadPool, numActors, DecideForActor, &d);
+	}
+	else
+	{
+		for (int i = 0; i < numActors; i++)
+		{
+			DecideForActor(&d, i, 0);
+		}
+	}
+
+	for (int i = 0; i < numActors; i++)
 	{
 		TActor *actor = CArrayGet(&gActors, i);
-		if (!actor->isInUse)
+		if (!actor->isInUse || actor->activityTicks == 0)
 		{
 			continue;
 		}
-		const CharBot *bot = actor->character->bot;
-		if (!(actor->pData || (actor->flags & FLAGS_PRISONER)))
+		if (IsEnemyAI(actor))
 		{
-			if ((actor->flags & (FLAGS_VICTIM | FLAGS_GOOD_GUY)) != 0)
-			{
-				gAreGoodGuysPresent = 1;
-			}
+			const int flags = *(int *)CArrayGet(&sFlags, i);
+			actor->flags =
+				(actor->flags & ~AI_DECIDE_FLAGS) | (flags & AI_DECIDE_FLAGS);
+			CommandActor(
+				actor, *(int *)CArrayGet(&sCmds, i), actor->activityTicks);
+		}
+		else if (actor->flags & FLAGS_PRISONER)
+		{
+			CommandActor(actor, 0, actor->activityTicks);
+		}
+	}
+	if (gMission.missionData->Enemies.size > 0 &&
+		gMission.missionData->EnemyDensity > 0 &&
+		count < MAX(1, (gMission.missionData->EnemyDensity * gConfig.Game.EnemyDensity) / 100))
+	{
+		Character *character = CharacterStoreGetRandomBaddie(
+			&gCampaign.Setting.characters);
+		TActor *baddie = CArrayGet(&gActors, ActorAdd(character, NULL));
+		PlaceBaddie(baddie);
+		gBaddieCount++;
+	}
+}
+static int Decide(TActor *actor, int *flags, const DecideData *d)
+{
+	const CharBot *bot = actor->character->bot;
+	Rng *rng = &actor->aiContext->Rng;
+	int cmd = 0;
 
-			count++;
-			int cmd = 0;
+	// Wake up if it can see a player
+	if ((*flags & FLAGS_SLEEPING) &&
+		actor->aiContext->Delay == 0)
+	{
+		if (CanSeeAPlayer(actor))
+		{
+			*flags &= ~FLAGS_SLEEPING;
+			AIContextSetState(actor->aiContext, AI_STATE_NONE);
+		}
+		actor->aiContext->Delay = bot->actionDelay * d->DelayModifier;
+		// Randomly change direction
+		int newDir = (int)actor->direction + (RngInt(rng, 2) * 2 - 1);
+		if (newDir < (int)DIRECTION_UP)
+		{
+			newDir = (int)DIRECTION_UPLEFT;
+		}
+		if (newDir == (int)DIRECTION_COUNT)
+		{
+			newDir = (int)DIRECTION_UP;
+		}
+		cmd = DirectionToCmd((int)newDir);
+	}
+	// Go to sleep if the player's too far away
+	if (!(*flags & FLAGS_SLEEPING) &&
+		actor->aiContext->Delay == 0 &&
+		!(*flags & FLAGS_AWAKEALWAYS))
+	{
+		if (!IsCloseToPlayer(actor->Pos, (40 * 16) << 8))
+		{
+			*flags |= FLAGS_SLEEPING;
+			AIContextSetState(actor->aiContext, AI_STATE_IDLE);
+		}
+	}
 
-			// Wake up if it can see a player
-			if ((actor->flags & FLAGS_SLEEPING) &&
-				actor->aiContext->Delay == 0)
+	if (!actor->dead && !(*flags & FLAGS_SLEEPING))
+	{
+		bool bypass = false;
+		const int roll = RngInt(rng, d->RollLimit);
+		if (*flags & FLAGS_FOLLOWER)
+		{
+			if (IsCloseToPlayer(actor->Pos, 32 << 8))
 			{
-				if (CanSeeAPlayer(actor))
-				{
-					actor->flags &= ~FLAGS_SLEEPING;
-					AIContextSetState(actor->aiContext, AI_STATE_NONE);
-				}
-				actor->aiContext->Delay = bot->actionDelay * delayModifier;
-				// Randomly change direction
-				int newDir = (int)actor->direction + ((rand() % 2) * 2 - 1);
-				if (newDir < (int)DIRECTION_UP)
-				{
-					newDir = (int)DIRECTION_UPLEFT;
-				}
-				if (newDir == (int)DIRECTION_COUNT)
-				{
-					newDir = (int)DIRECTION_UP;
-				}
-				cmd = DirectionToCmd((int)newDir);
+				cmd = 0;
+				AIContextSetState(actor->aiContext, AI_STATE_IDLE);
 			}
-			// Go to sleep if the player's too far away
-			if (!(actor->flags & FLAGS_SLEEPING) &&
-				actor->aiContext->Delay == 0 &&
-				!(actor->flags & FLAGS_AWAKEALWAYS))
+			else
 			{
-				if (!IsCloseToPlayer(actor->Pos, (40 * 16) << 8))
-				{
-					actor->flags |= FLAGS_SLEEPING;
-					AIContextSetState(actor->aiContext, AI_STATE_IDLE);
-				}
+				cmd = AIGoto(
+					actor, AIGetClosestPlayerPos(actor->Pos), true);
+				AIContextSetState(actor->aiContext, AI_STATE_FOLLOW);
 			}
-
-			if (!actor->dead && !(actor->flags & FLAGS_SLEEPING))
+		}
+		else if (!!(*flags & FLAGS_SNEAKY) &&
+			!!(*flags & FLAGS_VISIBLE) &&
+			DidPlayerShoot())
+		{
+			cmd = AIHuntClosest(actor) | CMD_BUTTON1;
+			if (*flags & FLAGS_RUNS_AWAY)
 			{
-				bool bypass = false;
-				const int roll = rand() % rollLimit;
-				if (actor->flags & FLAGS_FOLLOWER)
-				{
-					if (IsCloseToPlayer(actor->Pos, 32 << 8))
-					{
-						cmd = 0;
-						AIContextSetState(actor->aiContext, AI_STATE_IDLE);
-					}
-					else
-					{
-						cmd = AIGoto(
-							actor, AIGetClosestPlayerPos(actor->Pos), true);
-						AIContextSetState(actor->aiContext, AI_STATE_FOLLOW);
-					}
-				}
-				else if (!!(actor->flags & FLAGS_SNEAKY) &&
-					!!(actor->flags & FLAGS_VISIBLE) &&
-					DidPlayerShoot())
+				// Turn back and shoot for running away characters
+				cmd = AIReverseDirection(cmd);
+			}
+			bypass = 1;
+			AIContextSetState(actor->aiContext, AI_STATE_HUNT);
+		}
+		else if (*flags & FLAGS_DETOURING)
+		{
+			cmd = BrightWalk(actor, flags, roll);
+			AIContextSetState(actor->aiContext, AI_STATE_TRACK);
+		}
+		else if (actor->aiContext->Delay > 0)
+		{
+			cmd = actor->lastCmd & ~CMD_BUTTON1;
+		}
+		else
+		{
+			if (roll < bot->probabilityToTrack)
+			{
+				cmd = AIHuntClosest(actor);
+				AIContextSetState(actor->aiContext, AI_STATE_HUNT);
+			}
+			else if (roll < bot->probabilityToMove)
+			{
+				cmd = DirectionToCmd(RngInt(rng, 8));
+				AIContextSetState(actor->aiContext, AI_STATE_TRACK);
+			}
+			else
+			{
+				cmd = 0;
+			}
+			actor->aiContext->Delay = bot->actionDelay * d->DelayModifier;
+		}
+		if (!bypass)
+		{
+			if (WillFire(actor, roll))
+			{
+				cmd |= CMD_BUTTON1;
+				if (!!(*flags & FLAGS_FOLLOWER) &&
+					(*flags & FLAGS_GOOD_GUY))
 				{
-					cmd = AIHuntClosest(actor) | CMD_BUTTON1;
-					if (actor->flags & FLAGS_RUNS_AWAY)
+					// Shoot in a random direction away
+					for (int j = 0; j < 10; j++)
 					{
-						// Turn back and shoot for running away characters
-						cmd = AIReverseDirection(cmd);
+						direction_e dir =
+							(direction_e)RngInt(rng, DIRECTION_COUNT);
+						if (!IsFacingPlayer(actor, dir))
+						{
+							cmd = DirectionToCmd(dir) | CMD_BUTTON1;
+							break;
+						}
 					}
-					bypass = 1;
-					AIContextSetState(actor->aiContext, AI_STATE_HUNT);
-				}
-				else if (actor->flags & FLAGS_DETOURING)
-				{
-					cmd = BrightWalk(actor, roll);
-					AIContextSetState(actor->aiContext, AI_STATE_TRACK);
 				}
-				else if (actor->aiContext->Delay > 0)
+				if (*flags & FLAGS_RUNS_AWAY)
 				{
-					cmd = actor->lastCmd & ~CMD_BUTTON1;
+					// Turn back and shoot for running away characters
+					cmd |= AIReverseDirection(AIHuntClosest(actor));
 				}
-				else
+				AIContextSetState(actor->aiContext, AI_STATE_HUNT);
+			}
+			else
+			{
+				if ((*flags & FLAGS_VISIBLE) == 0)
 				{
-					if (roll < bot->probabilityToTrack)
-					{
-						cmd = AIHuntClosest(actor);
-						AIContextSetState(actor->aiContext, AI_STATE_HUNT);
-					}
-					else if (roll < bot->probabilityToMove)
-					{
-						cmd = DirectionToCmd(rand() & 7);
-						AIContextSetState(actor->aiContext, AI_STATE_TRACK);
-					}
-					else
-					{
-						cmd = 0;
-					}
-					actor->aiContext->Delay = bot->actionDelay * delayModifier;
+					// I think this is some hack to make sure invisible enemies don't fire so much
+					ActorGetGun(actor)->lock = 40;
 				}
-				if (!bypass)
+				if (cmd && !IsDirectionOK(actor, CmdToDirection(cmd)) &&
+					(*flags & FLAGS_DETOURING) == 0)
 				{
-					if (WillFire(actor, roll))
-					{
-						cmd |= CMD_BUTTON1;
-						if (!!(actor->flags & FLAGS_FOLLOWER) &&
-							(actor->flags & FLAGS_GOOD_GUY))
-						{
-							// Shoot in a random direction away
-							for (int j = 0; j < 10; j++)
-							{
-								direction_e d =
-									(direction_e)(rand() % DIRECTION_COUNT);
-								if (!IsFacingPlayer(actor, d))
-								{
-									cmd = DirectionToCmd(d) | CMD_BUTTON1;
-									break;
-								}
-							}
-						}
-						if (actor->flags & FLAGS_RUNS_AWAY)
-						{
-							// Turn back and shoot for running away characters
-							cmd |= AIReverseDirection(AIHuntClosest(actor));
-						}
-						AIContextSetState(actor->aiContext, AI_STATE_HUNT);
-					}
-					else
-					{
-						if ((actor->flags & FLAGS_VISIBLE) == 0)
-						{
-							// I think this is some hack to make sure invisible enemies don't fire so much
-							ActorGetGun(actor)->lock = 40;
-						}
-						if (cmd && !IsDirectionOK(actor, CmdToDirection(cmd)) &&
-							(actor->flags & FLAGS_DETOURING) == 0)
-						{
-							Detour(actor);
-							cmd = 0;
-							AIContextSetState(actor->aiContext, AI_STATE_TRACK);
-						}
-					}
+					Detour(actor, flags);
+					cmd = 0;
+					AIContextSetState(actor->aiContext, AI_STATE_TRACK);
 				}
 			}
-			actor->aiContext->Delay =
-				MAX(0, actor->aiContext->Delay - ticks);
-			CommandActor(actor, cmd, ticks);
-		}
-		else if ((actor->flags & FLAGS_PRISONER) != 0)
-		{
-			CommandActor(actor, 0, ticks);
 		}
 	}
-	if (gMission.missionData->Enemies.size > 0 &&
-		gMission.missionData->EnemyDensity > 0 &&
-		count < MAX(1, (gMission.missionData->EnemyDensity * gConfig.Game.EnemyDensity) / 100))
-	{
-		Character *character = CharacterStoreGetRandomBaddie(
-			&gCampaign.Setting.characters);
-		TActor *baddie = CArrayGet(&gActors, ActorAdd(character, NULL));
-		PlaceBaddie(baddie);
-		gBaddieCount++;
-	}
+	actor->aiContext->Delay =
+		MAX(0, actor->aiContext->Delay - actor->activityTicks);
+	return cmd;
 }
 
 void InitializeBadGuys(void)
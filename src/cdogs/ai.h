@@ -53,6 +53,10 @@
 
 void InitializeBadGuys(void);
 void CreateEnemies(void);
-void CommandBadGuys(int ticks);
+void CommandBadGuys(void);
+
+// Threads for commanding bad guys; init per game, after the map is loaded
+void AIThreadsInit(void);
+void AIThreadsTerminate(void);
 
 #endif
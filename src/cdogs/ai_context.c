@@ -31,13 +31,15 @@ AIContext *AIContextNew(void)
 {
 	AIContext *c;
 	CCALLOC(c, sizeof *c);
+	CArrayInit(&c->Goto.Path, sizeof(Vec2i));
+	RngSeedFrom(&c->Rng, &gRngAI);
 	return c;
 }
 void AIContextDestroy(AIContext *c)
 {
 	if (c)
 	{
-		ASPathDestroy(c->Goto.Path);
+		CArrayTerminate(&c->Goto.Path);
 	}
 	CFREE(c);
 }
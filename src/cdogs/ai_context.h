@@ -28,9 +28,10 @@
 #ifndef __AI_CONTEXT
 #define __AI_CONTEXT
 
-#include "AStar.h"
+#include "c_array.h"
 #include "config.h"
 #include "mission.h"
+#include "rng.h"
 #include "vector.h"
 
 // State data for various AI routines
@@ -79,7 +80,7 @@ typedef struct
 typedef struct
 {
 	Vec2i Goal;
-	ASPath Path;
+	CArray Path;	// of Vec2i
 	int PathIndex;
 	bool IsFollowing;
 } AIGotoContext;
@@ -98,6 +99,12 @@ typedef struct
 	Vec2i LastTile;
 	bool IsStuckTooLong;
 	AIGotoContext Goto;
+	// The AI's own random numbers, so that they don't depend on which
+	// thread runs it, or on what other AIs do
+	Rng Rng;
+	// Pathfinding scratch of the thread deciding for this actor;
+	// NULL for the main thread's
+	struct AIScratch *Scratch;
 } AIContext;
 
 AIContext *AIContextNew(void);
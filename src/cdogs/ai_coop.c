@@ -62,7 +62,7 @@ int AICoopGetCmd(TActor *actor, const int ticks)
 		{
 			actor->aiContext->Delay =
 				CONFUSION_STATE_TICKS_MIN +
-				(rand() % CONFUSION_STATE_TICKS_RANGE);
+				RngInt(&actor->aiContext->Rng, CONFUSION_STATE_TICKS_RANGE);
 			if (s->Type == AI_CONFUSION_CONFUSED)
 			{
 				s->Type = AI_CONFUSION_CORRECT;
@@ -72,7 +72,7 @@ int AICoopGetCmd(TActor *actor, const int ticks)
 				AIContextSetState(actor->aiContext, AI_STATE_CONFUSED);
 				s->Type = AI_CONFUSION_CONFUSED;
 				// Generate the confused action
-				s->Cmd = rand() &
+				s->Cmd = (int)RngNext(&actor->aiContext->Rng) &
 					(CMD_LEFT | CMD_RIGHT | CMD_UP | CMD_DOWN |
 					CMD_BUTTON1 | CMD_BUTTON2);
 			}
@@ -359,13 +359,9 @@ static void FindObjectivesSortedByDistance(
 	CArrayInit(objectives, sizeof(ClosestObjective));
 
 	// Look for pickups and destructibles
-	for (int i = 0; i < (int)gObjs.size; i++)
+	for (int i = 0; i < CPoolLiveCount(&gObjs); i++)
 	{
-		const TObject *o = CArrayGet(&gObjs, i);
-		if (!o->isInUse)
-		{
-			continue;
-		}
+		const TObject *o = CPoolGetLive(&gObjs, i);
 		ClosestObjective co;
 		memset(&co, 0, sizeof co);
 		co.Pos = Vec2iNew(o->tileItem.x, o->tileItem.y);
@@ -50,20 +50,24 @@
 
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 
+#include "AStar.h"
 #include "algorithms.h"
 #include "collision.h"
+#include "flow_field.h"
 #include "map.h"
 #include "objs.h"
+#include "proximity.h"
 #include "weapon.h"
 
 
-TActor *AIGetClosestPlayer(Vec2i fullpos)
+// Returns the player index, or -1 if no players are alive
+static int GetClosestPlayerIndex(Vec2i fullpos)
 {
-	int i;
 	int minDistance = -1;
-	TActor *closestPlayer = NULL;
-	for (i = 0; i < gOptions.numPlayers; i++)
+	int closest = -1;
+	for (int i = 0; i < gOptions.numPlayers; i++)
 	{
 		if (IsPlayerAlive(i))
 		{
@@ -71,14 +75,77 @@ TActor *AIGetClosestPlayer(Vec2i fullpos)
 			Vec2i pPos = Vec2iFull2Real(p->Pos);
 			int distance = CHEBYSHEV_DISTANCE(
 				fullpos.x, fullpos.y, pPos.x, pPos.y);
-			if (!closestPlayer || distance < minDistance)
+			if (closest < 0 || distance < minDistance)
 			{
-				closestPlayer = p;
+				closest = i;
 				minDistance = distance;
 			}
 		}
 	}
-	return closestPlayer;
+	return closest;
+}
+TActor *AIGetClosestPlayer(Vec2i fullpos)
+{
+	const int i = GetClosestPlayerIndex(fullpos);
+	if (i < 0)
+	{
+		return NULL;
+	}
+	return CArrayGet(&gActors, gPlayerIds[i]);
+}
+
+// Targetable actors on each side, as of the last update
+static ProximityGrid sGoodActors;
+static ProximityGrid sBadActors;
+#define PROXIMITY_CELL_TILES 8
+static int IsGood(TActor *a);
+static bool IsTargetable(const TActor *a)
+{
+	// Never target invulnerables or civilians
+	return a->isInUse && !a->dead &&
+		!(a->flags & (FLAGS_INVULNERABLE | FLAGS_PENALTY));
+}
+void AIProximityInit(void)
+{
+	const Vec2i size = Vec2iNew(
+		(gMap.Size.x + PROXIMITY_CELL_TILES - 1) / PROXIMITY_CELL_TILES,
+		(gMap.Size.y + PROXIMITY_CELL_TILES - 1) / PROXIMITY_CELL_TILES);
+	const Vec2i cellSize = Vec2iNew(
+		(PROXIMITY_CELL_TILES * TILE_WIDTH) << 8,
+		(PROXIMITY_CELL_TILES * TILE_HEIGHT) << 8);
+	ProximityGridInit(&sGoodActors, size, cellSize);
+	ProximityGridInit(&sBadActors, size, cellSize);
+}
+void AIProximityTerminate(void)
+{
+	ProximityGridTerminate(&sGoodActors);
+	ProximityGridTerminate(&sBadActors);
+}
+void AIProximityUpdate(void)
+{
+	for (int i = 0; i < (int)gActors.size; i++)
+	{
+		TActor *a = CArrayGet(&gActors, i);
+		if (!IsTargetable(a))
+		{
+			continue;
+		}
+		ProximityGridAdd(IsGood(a) ? &sGoodActors : &sBadActors, i, a->Pos);
+	}
+	ProximityGridBuild(&sGoodActors);
+	ProximityGridBuild(&sBadActors);
+}
+// Actors may have died or changed since the last update
+static bool IsStillTargetable(void *data, int id)
+{
+	UNUSED(data);
+	return IsTargetable(CArrayGet(&gActors, id));
+}
+static bool IsStillTargetableAndVisible(void *data, int id)
+{
+	UNUSED(data);
+	const TActor *a = CArrayGet(&gActors, id);
+	return IsTargetable(a) && (a->flags & FLAGS_VISIBLE);
 }
 
 static TActor *AIGetClosestActor(Vec2i from, int (*compFunc)(TActor *))
@@ -90,12 +157,7 @@ static TActor *AIGetClosestActor(Vec2i from, int (*compFunc)(TActor *))
 	for (int i = 0; i < (int)gActors.size; i++)
 	{
 		TActor *a = CArrayGet(&gActors, i);
-		if (!a->isInUse || a->dead)
-		{
-			continue;
-		}
-		// Never target invulnerables or civilians
-		if (a->flags & (FLAGS_INVULNERABLE | FLAGS_PENALTY))
+		if (!IsTargetable(a))
 		{
 			continue;
 		}
@@ -112,6 +174,23 @@ static TActor *AIGetClosestActor(Vec2i from, int (*compFunc)(TActor *))
 	}
 	return closest;
 }
+// Find the closest actor using the per-tick grids, or by searching all the
+// actors if they haven't been set up
+static TActor *GetClosestTarget(
+	Vec2i from, ProximityGrid *g, ProximityFilterFunc filter,
+	int (*compFunc)(TActor *))
+{
+	if (g->CellSize.x == 0)
+	{
+		return AIGetClosestActor(from, compFunc);
+	}
+	const int id = ProximityGridFindClosest(g, from, filter, NULL, NULL);
+	if (id < 0)
+	{
+		return NULL;
+	}
+	return CArrayGet(&gActors, id);
+}
 
 static int IsGood(TActor *a)
 {
@@ -126,12 +205,12 @@ TActor *AIGetClosestEnemy(Vec2i from, int flags, int isPlayer)
 	if (!isPlayer && !(flags & FLAGS_GOOD_GUY))
 	{
 		// we are bad; look for good guys
-		return AIGetClosestActor(from, IsGood);
+		return GetClosestTarget(from, &sGoodActors, IsStillTargetable, IsGood);
 	}
 	else
 	{
 		// we are good; look for bad guys
-		return AIGetClosestActor(from, IsBad);
+		return GetClosestTarget(from, &sBadActors, IsStillTargetable, IsBad);
 	}
 }
 
@@ -148,12 +227,16 @@ TActor *AIGetClosestVisibleEnemy(Vec2i from, int flags, int isPlayer)
 	if (!isPlayer && !(flags & FLAGS_GOOD_GUY))
 	{
 		// we are bad; look for good guys
-		return AIGetClosestActor(from, IsGoodAndVisible);
+		return GetClosestTarget(
+			from, &sGoodActors, IsStillTargetableAndVisible,
+			IsGoodAndVisible);
 	}
 	else
 	{
 		// we are good; look for bad guys
-		return AIGetClosestActor(from, IsBadAndVisible);
+		return GetClosestTarget(
+			from, &sBadActors, IsStillTargetableAndVisible,
+			IsBadAndVisible);
 	}
 }
 
@@ -216,16 +299,16 @@ static bool IsTileWalkable(Map *map, Vec2i pos)
 	}
 	// Check if tile has a dangerous (explosive) item on it
 	// For AI, we don't want to shoot it, so just walk around
-	Tile *t = MapGetTile(map, pos);
-	for (int i = 0; i < (int)t->things.size; i++)
+	const CArray *things = MapGetTileThings(map, pos);
+	for (int i = 0; i < (int)things->size; i++)
 	{
-		ThingId *tid = CArrayGet(&t->things, i);
+		const ThingId *tid = CArrayGet(things, i);
 		// Only look for explosive objects
 		if (tid->Kind != KIND_OBJECT)
 		{
 			continue;
 		}
-		TObject *o = CArrayGet(&gObjs, tid->Id);
+		TObject *o = CPoolGet(&gObjs, tid->Id);
 		if (o->flags & OBJFLAG_DANGEROUS)
 		{
 			return false;
@@ -244,14 +327,14 @@ static bool IsTileWalkableAroundObjects(Map *map, Vec2i pos)
 		return false;
 	}
 	// Check if tile has any item on it
-	Tile *t = MapGetTile(map, pos);
-	for (int i = 0; i < (int)t->things.size; i++)
+	const CArray *things = MapGetTileThings(map, pos);
+	for (int i = 0; i < (int)things->size; i++)
 	{
-		ThingId *tid = CArrayGet(&t->things, i);
+		const ThingId *tid = CArrayGet(things, i);
 		if (tid->Kind == KIND_OBJECT)
 		{
 			// Check that the object is not a pickup type
-			TObject *o = CArrayGet(&gObjs, tid->Id);
+			TObject *o = CPoolGet(&gObjs, tid->Id);
 			if (o->Type == OBJ_NONE && !(o->tileItem.flags & TILEITEM_IS_WRECK))
 			{
 				return false;
@@ -284,12 +367,11 @@ static bool IsPosNoWalkAroundObjects(void *data, Vec2i pos)
 }
 static bool IsTileWalkableOrOpenable(Map *map, Vec2i pos)
 {
-	int tileFlags = MapGetTile(map, pos)->flags;
-	if (!(tileFlags & MAPTILE_NO_WALK))
+	if (!BitGridGet(&map->NoWalk, pos))
 	{
 		return true;
 	}
-	if (tileFlags & MAPTILE_OFFSET_PIC)
+	if (MapGetTileFlags(map, pos) & MAPTILE_OFFSET_PIC)
 	{
 		// A door; check if we can open it
 		int keycard = MapGetDoorKeycardFlag(map, pos);
@@ -340,7 +422,8 @@ bool AIHasClearShot(const Vec2i from, const Vec2i to)
 }
 static bool IsPosNoSee(void *data, Vec2i pos)
 {
-	return MapGetTile(data, Vec2iToTile(pos))->flags & MAPTILE_NO_SEE;
+	const Map *map = data;
+	return BitGridGet(&map->NoSee, Vec2iToTile(pos));
 }
 
 TObject *AIGetObjectRunningInto(TActor *a, int cmd)
@@ -375,21 +458,73 @@ TObject *AIGetObjectRunningInto(TActor *a, int cmd)
 	{
 		return NULL;
 	}
-	return CArrayGet(&gObjs, item->id);
+	return CPoolGet(&gObjs, item->id);
 }
 
 
+void AIScratchInit(AIScratch *s)
+{
+	memset(s, 0, sizeof *s);
+	RoomGraphSearchInit(&s->RoomSearch);
+	CArrayInit(&s->AreaPath, sizeof(int));
+	CArrayInit(&s->Path, sizeof(Vec2i));
+}
+void AIScratchTerminate(AIScratch *s)
+{
+	PathGridTerminate(&s->PathGrid);
+	RoomGraphSearchTerminate(&s->RoomSearch);
+	CArrayTerminate(&s->AreaPath);
+	CArrayTerminate(&s->Path);
+	memset(s, 0, sizeof *s);
+}
+bool AIScratchSetupPathGrid(AIScratch *s, const Map *map)
+{
+	if (!PathGridIsInit(&s->PathGrid, map->Size))
+	{
+		PathGridTerminate(&s->PathGrid);
+		return PathGridInit(&s->PathGrid, map->Size);
+	}
+	return true;
+}
+// Scratch for the main thread
+static AIScratch sScratch;
+static AIScratch *GetScratch(const AIContext *c)
+{
+	if (c != NULL && c->Scratch != NULL)
+	{
+		return c->Scratch;
+	}
+	if (sScratch.Path.elemSize == 0)
+	{
+		AIScratchInit(&sScratch);
+	}
+	return &sScratch;
+}
+
 typedef struct
 {
 	Map *Map;
 	TileSelectFunc IsTileOk;
-} AStarContext;
+	AIScratch *Scratch;
+} PathContext;
+static bool IsTileOkPathGrid(void *data, Vec2i tile)
+{
+	PathContext *c = data;
+	return c->IsTileOk(c->Map, tile);
+}
+static bool IsTileOkCorridor(void *data, Vec2i tile)
+{
+	PathContext *c = data;
+	return RoomGraphIsInCorridor(
+		&c->Map->RoomGraph, &c->Scratch->RoomSearch, tile) &&
+		c->IsTileOk(c->Map, tile);
+}
 static void AddTileNeighbors(
 	ASNeighborList neighbors, void *node, void *context)
 {
 	Vec2i *v = node;
 	int y;
-	AStarContext *c = context;
+	PathContext *c = context;
 	for (y = v->y - 1; y <= v->y + 1; y++)
 	{
 		int x;
@@ -452,6 +587,53 @@ static ASPathNodeSource cPathNodeSource =
 {
 	sizeof(Vec2i), AddTileNeighbors, AStarHeuristic, NULL, NULL
 };
+// Find a path between tiles, writing it to path (of Vec2i)
+// Only reads the map, so that AIs can pathfind on several threads at once,
+// each with their own scratch; this needs the room graph to be brought up
+// to date before starting the threads, so that updating it here is a no-op
+// Falls back to the generic A* if the scratch's grid can't be set up for
+// the map; CommandBadGuys only starts the threads if all of their grids
+// could be set up, so the fallback only runs on the main thread
+static void FindPath(PathContext *pc, Vec2i from, Vec2i to, CArray *path)
+{
+	AIScratch *s = pc->Scratch;
+	MapUpdateRoomGraph(pc->Map);
+	if (!AIScratchSetupPathGrid(s, pc->Map))
+	{
+		CArrayClear(path);
+		ASPath asPath = ASPathCreate(&cPathNodeSource, pc, &from, &to);
+		for (int i = 0; i < (int)ASPathGetCount(asPath); i++)
+		{
+			CArrayPushBack(path, ASPathGetNode(asPath, i));
+		}
+		ASPathDestroy(asPath);
+		return;
+	}
+	// Plan over the room graph first, then only search the tiles
+	// in the areas along the way
+	const RoomGraph *rg = &pc->Map->RoomGraph;
+	const int fromArea = RoomGraphGetArea(rg, from);
+	const int toArea = RoomGraphGetArea(rg, to);
+	if (fromArea >= 0 && toArea >= 0 && fromArea != toArea)
+	{
+		if (!RoomGraphFind(
+			rg, &s->RoomSearch, fromArea, toArea, gMission.flags,
+			&s->AreaPath))
+		{
+			// Unreachable, even ignoring objects
+			CArrayClear(path);
+			return;
+		}
+		RoomGraphSetCorridor(rg, &s->RoomSearch, &s->AreaPath);
+		if (PathGridFind(
+			&s->PathGrid, from, to, IsTileOkCorridor, pc, path))
+		{
+			return;
+		}
+		// Objects may be blocking the corridor; search everywhere
+	}
+	PathGridFind(&s->PathGrid, from, to, IsTileOkPathGrid, pc, path);
+}
 
 // Use pathfinding to check that there is a path between
 // source and destination tiles
@@ -463,15 +645,14 @@ bool AIHasPath(const Vec2i from, const Vec2i to, const bool ignoreObjects)
 		return true;
 	}
 	// Pathfind
-	AStarContext ac;
-	ac.Map = &gMap;
-	ac.IsTileOk = ignoreObjects ? IsTileWalkable : IsTileWalkableAroundObjects;
+	PathContext pc;
+	pc.Map = &gMap;
+	pc.IsTileOk = ignoreObjects ? IsTileWalkable : IsTileWalkableAroundObjects;
+	pc.Scratch = GetScratch(NULL);
 	Vec2i fromTile = Vec2iToTile(from);
-	Vec2i toTile = MapSearchTileAround(ac.Map, Vec2iToTile(to), ac.IsTileOk);
-	ASPath path = ASPathCreate(&cPathNodeSource, &ac, &fromTile, &toTile);
-	size_t pathCount = ASPathGetCount(path);
-	ASPathDestroy(path);
-	return pathCount > 1;
+	Vec2i toTile = MapSearchTileAround(pc.Map, Vec2iToTile(to), pc.IsTileOk);
+	FindPath(&pc, fromTile, toTile, &pc.Scratch->Path);
+	return pc.Scratch->Path.size > 1;
 }
 
 static int AIGotoDirect(Vec2i a, Vec2i p)
@@ -490,7 +671,7 @@ static int AIGotoDirect(Vec2i a, Vec2i p)
 static int AStarFollow(
 	AIGotoContext *c, Vec2i currentTile, TTileItem *i, Vec2i a)
 {
-	Vec2i *pathTile = ASPathGetNode(c->Path, c->PathIndex);
+	Vec2i *pathTile = CArrayGet(&c->Path, c->PathIndex);
 	c->IsFollowing = 1;
 	// Check if we need to follow the next step in the path
 	// Note: need to make sure the actor is fully within the current tile
@@ -499,7 +680,7 @@ static int AStarFollow(
 		IsTileItemInsideTile(i, currentTile))
 	{
 		c->PathIndex++;
-		pathTile = ASPathGetNode(c->Path, c->PathIndex);
+		pathTile = CArrayGet(&c->Path, c->PathIndex);
 		c->IsFollowing = 0;
 	}
 	// Go directly to the center of the next tile
@@ -513,19 +694,19 @@ static int AStarCloseToPath(
 	Vec2i *pathTile;
 	Vec2i *pathEnd;
 	if (!c ||
-		c->PathIndex >= (int)ASPathGetCount(c->Path) - 1) // at end of path
+		c->PathIndex >= (int)c->Path.size - 1) // at end of path
 	{
 		return 0;
 	}
 	// Check if we're too far from the current start of the path
-	pathTile = ASPathGetNode(c->Path, c->PathIndex);
+	pathTile = CArrayGet(&c->Path, c->PathIndex);
 	if (CHEBYSHEV_DISTANCE(
 		currentTile.x, currentTile.y, pathTile->x, pathTile->y) > 2)
 	{
 		return 0;
 	}
 	// Check if we're too far from the end of the path
-	pathEnd = ASPathGetNode(c->Path, ASPathGetCount(c->Path) - 1);
+	pathEnd = CArrayGet(&c->Path, (int)c->Path.size - 1);
 	if (CHEBYSHEV_DISTANCE(
 		goalTile.x, goalTile.y, pathEnd->x, pathEnd->y) > 0)
 	{
@@ -565,22 +746,21 @@ int AIGoto(TActor *actor, Vec2i p, bool ignoreObjects)
 	{
 		// We need to recalculate A*
 
-		AStarContext ac;
-		ac.Map = &gMap;
-		ac.IsTileOk =
+		PathContext pc;
+		pc.Map = &gMap;
+		pc.IsTileOk =
 			ignoreObjects ? IsTileWalkable : IsTileWalkableAroundObjects;
+		pc.Scratch = GetScratch(actor->aiContext);
 		// First, if the goal tile is blocked itself,
 		// find a nearby tile that can be walked to
-		c->Goal = MapSearchTileAround(ac.Map, goalTile, ac.IsTileOk);
+		c->Goal = MapSearchTileAround(pc.Map, goalTile, pc.IsTileOk);
 
 		c->PathIndex = 1;	// start navigating to the next path node
-		ASPathDestroy(c->Path);
-		c->Path = ASPathCreate(
-			&cPathNodeSource, &ac, &currentTile, &c->Goal);
+		FindPath(&pc, currentTile, c->Goal, &c->Path);
 
 		// In case we can't calculate A* for some reason,
 		// try simple navigation again
-		if (ASPathGetCount(c->Path) <= 1)
+		if (c->Path.size <= 1)
 		{
 			debug(
 				D_MAX,
@@ -621,12 +801,16 @@ int AIHunt(TActor *actor, Vec2i targetPos)
 
 	return cmd;
 }
+static int HuntAlongFlowField(
+	TActor *actor, const int playerIndex, const int huntCmd);
 int AIHuntClosest(TActor *actor)
 {
 	Vec2i targetPos = actor->Pos;
+	int playerIndex = -1;
 	if (!(actor->pData || (actor->flags & FLAGS_GOOD_GUY)))
 	{
 		targetPos = AIGetClosestPlayerPos(actor->Pos);
+		playerIndex = GetClosestPlayerIndex(actor->Pos);
 	}
 
 	if (actor->flags & FLAGS_VISIBLE)
@@ -636,9 +820,91 @@ int AIHuntClosest(TActor *actor)
 		if (a)
 		{
 			targetPos = a->Pos;
+			playerIndex = -1;
+		}
+	}
+	const int cmd = AIHunt(actor, targetPos);
+	if (playerIndex >= 0 && !(actor->flags & FLAGS_RUNS_AWAY))
+	{
+		return HuntAlongFlowField(actor, playerIndex, cmd);
+	}
+	return cmd;
+}
+
+// Flow fields towards each player, shared by all the AIs hunting them
+static FlowField sPlayerFlowFields[MAX_PLAYERS];
+static int sFlowFieldsMissionFlags;
+static int sFlowFieldsKeyRevision;
+void AIFlowFieldsInit(void)
+{
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		FlowFieldInit(&sPlayerFlowFields[i], gMap.Size);
+	}
+	sFlowFieldsMissionFlags = gMission.flags;
+	sFlowFieldsKeyRevision = 0;
+}
+void AIFlowFieldsTerminate(void)
+{
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		FlowFieldTerminate(&sPlayerFlowFields[i]);
+	}
+}
+static bool IsTileWalkableOrOpenableFlowField(void *data, Vec2i tile)
+{
+	return IsTileWalkableOrOpenable(data, tile);
+}
+void AIFlowFieldsUpdate(void)
+{
+	// Picking up keycards changes which doors can be opened
+	if (gMission.flags != sFlowFieldsMissionFlags)
+	{
+		sFlowFieldsMissionFlags = gMission.flags;
+		sFlowFieldsKeyRevision++;
+	}
+	const int revision = gMap.TileFlagsRevision + sFlowFieldsKeyRevision;
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		FlowField *f = &sPlayerFlowFields[i];
+		if (i >= gOptions.numPlayers || !IsPlayerAlive(i))
+		{
+			FlowFieldReset(f);
+			continue;
+		}
+		const TActor *p = CArrayGet(&gActors, gPlayerIds[i]);
+		FlowFieldUpdate(
+			f, Vec2iToTile(Vec2iFull2Real(p->Pos)), revision,
+			IsTileWalkableOrOpenableFlowField, &gMap);
+	}
+}
+// Keep the direct hunting move if it also brings us closer to the player
+// along the flow field; otherwise, e.g. if there's a wall in the way,
+// take the flow field's next step
+static int HuntAlongFlowField(
+	TActor *actor, const int playerIndex, const int huntCmd)
+{
+	const FlowField *f = &sPlayerFlowFields[playerIndex];
+	const Vec2i realPos = Vec2iFull2Real(actor->Pos);
+	const Vec2i tile = Vec2iToTile(realPos);
+	Vec2i next;
+	if (!FlowFieldGetNext(f, tile, &next))
+	{
+		return huntCmd;
+	}
+	if (huntCmd != 0)
+	{
+		const Vec2i huntTile = Vec2iAdd(
+			tile, Vec2iNew(
+				(huntCmd & CMD_RIGHT) ? 1 : (huntCmd & CMD_LEFT) ? -1 : 0,
+				(huntCmd & CMD_DOWN) ? 1 : (huntCmd & CMD_UP) ? -1 : 0));
+		const int huntDist = FlowFieldGetDistance(f, huntTile);
+		if (huntDist >= 0 && huntDist < FlowFieldGetDistance(f, tile))
+		{
+			return huntCmd;
 		}
 	}
-	return AIHunt(actor, targetPos);
+	return AIGotoDirect(realPos, Vec2iCenterOfTile(next));
 }
 
 void AIContextTerminate(void *aiContext)
@@ -646,7 +912,7 @@ void AIContextTerminate(void *aiContext)
 	AIGotoContext *c = aiContext;
 	if (c)
 	{
-		ASPathDestroy(c->Path);
+		CArrayTerminate(&c->Path);
 	}
 	CFREE(c);
 }
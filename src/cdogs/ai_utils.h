@@ -53,6 +53,25 @@
 
 #include "actors.h"
 #include "objs.h"
+#include "path_grid.h"
+#include "room_graph.h"
+
+// Scratch memory for pathfinding
+// Each thread running AIs needs its own; an actor's AI context points to
+// the one in use while it is deciding, or NULL for the main thread's
+typedef struct AIScratch
+{
+	PathGrid PathGrid;
+	RoomGraphSearch RoomSearch;
+	CArray AreaPath;	// of int
+	CArray Path;	// of Vec2i
+} AIScratch;
+void AIScratchInit(AIScratch *s);
+void AIScratchTerminate(AIScratch *s);
+// Set up the scratch's path grid for the map if it isn't already
+// Returns false if it can't be, in which case pathfinding with this
+// scratch falls back to the slower generic A*
+bool AIScratchSetupPathGrid(AIScratch *s, const Map *map);
 
 TActor *AIGetClosestPlayer(Vec2i fullpos);
 TActor *AIGetClosestEnemy(Vec2i from, int flags, int isPlayer);
@@ -72,6 +91,19 @@ int AIGoto(TActor *actor, Vec2i target, bool ignoreObjects);
 int AIHunt(TActor *actor, Vec2i targetPos);
 int AIHuntClosest(TActor *actor);
 
+// Shared flow fields towards each player, used when hunting players
+// Update once per tick, before commanding the AIs
+void AIFlowFieldsInit(void);
+void AIFlowFieldsTerminate(void);
+void AIFlowFieldsUpdate(void);
+
+// Index of targetable actors by side, for closest enemy queries
+// Queries see actors where they were at the last update, so update
+// before each part of the tick that queries, once actors have moved
+void AIProximityInit(void);
+void AIProximityTerminate(void);
+void AIProximityUpdate(void);
+
 void AIContextTerminate(void *aiContext);
 
 #endif
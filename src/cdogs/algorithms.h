@@ -46,6 +46,7 @@ typedef struct
 	void (*Draw)(void *, Vec2i);
 	void *data;
 } AlgoLineDrawData;
+
 void BresenhamLineDraw(Vec2i from, Vec2i to, AlgoLineDrawData *data);
 void XiaolinWuLineDraw(Vec2i from, Vec2i to, AlgoLineDrawData *data);
 
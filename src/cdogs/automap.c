@@ -216,9 +216,11 @@ static void DrawMap(
 		{
 			for (x = 0; x < gMap.Size.x; x++)
 			{
-				Tile *tile = MapGetTile(map, Vec2iNew(x, y));
-				if (!(tile->flags & MAPTILE_IS_NOTHING) &&
-					(tile->isVisited || (flags & AUTOMAP_FLAGS_SHOWALL)))
+				const Vec2i tilePos = Vec2iNew(x, y);
+				const int tileFlags = MapGetTileFlags(map, tilePos);
+				if (!(tileFlags & MAPTILE_IS_NOTHING) &&
+					(!MapTileIsUnexplored(map, tilePos) ||
+					(flags & AUTOMAP_FLAGS_SHOWALL)))
 				{
 					int j;
 					for (j = 0; j < scale; j++)
@@ -227,15 +229,15 @@ static void DrawMap(
 							mapPos.x + x*scale + j,
 							mapPos.y + y*scale + i);
 						color_t color = colorBlack;
-						if (tile->flags & MAPTILE_IS_WALL)
+						if (tileFlags & MAPTILE_IS_WALL)
 						{
 							color = colorWall;
 						}
-						else if (tile->flags & MAPTILE_NO_WALK)
+						else if (tileFlags & MAPTILE_NO_WALK)
 						{
 							color = DoorColor(x, y);
 						}
-						else if (tile->flags & MAPTILE_IS_NORMAL_FLOOR)
+						else if (tileFlags & MAPTILE_IS_NORMAL_FLOOR)
 						{
 							color = colorFloor;
 						}
@@ -268,25 +270,27 @@ static void DrawMap(
 }
 
 static void DrawTileItem(
-	TTileItem *t, Tile *tile, Vec2i pos, int scale, int flags);
+	TTileItem *t, const bool isVisited, Vec2i pos, int scale, int flags);
 static void DrawObjectivesAndKeys(Map *map, Vec2i pos, int scale, int flags)
 {
 	for (int y = 0; y < map->Size.y; y++)
 	{
 		for (int x = 0; x < map->Size.x; x++)
 		{
-			Tile *tile = MapGetTile(map, Vec2iNew(x, y));
-			for (int i = 0; i < (int)tile->things.size; i++)
+			const Vec2i tilePos = Vec2iNew(x, y);
+			const CArray *things = MapGetTileThings(map, tilePos);
+			const bool isVisited = !MapTileIsUnexplored(map, tilePos);
+			for (int i = 0; i < (int)things->size; i++)
 			{
-				ThingId *tid = CArrayGet(&tile->things, i);
+				ThingId *tid = CArrayGet(things, i);
 				DrawTileItem(
-					ThingIdGetTileItem(tid), tile, pos, scale, flags);
+					ThingIdGetTileItem(tid), isVisited, pos, scale, flags);
 			}
 		}
 	}
 }
 static void DrawTileItem(
-	TTileItem *t, Tile *tile, Vec2i pos, int scale, int flags)
+	TTileItem *t, const bool isVisited, Vec2i pos, int scale, int flags)
 {
 	if ((t->flags & TILEITEM_OBJECTIVE) != 0)
 	{
@@ -298,17 +302,17 @@ static void DrawTileItem(
 			(flags & AUTOMAP_FLAGS_SHOWALL))
 		{
 			if ((objFlags & OBJECTIVE_POSKNOWN) ||
-				tile->isVisited ||
+				isVisited ||
 				(flags & AUTOMAP_FLAGS_SHOWALL))
 			{
 				DisplayObjective(t, obj, pos, scale, flags);
 			}
 		}
 	}
-	else if (t->kind == KIND_OBJECT && tile->isVisited)
+	else if (t->kind == KIND_OBJECT && isVisited)
 	{
 		color_t dotColor = colorBlack;
-		switch (((TObject *)CArrayGet(&gObjs, t->id))->Type)
+		switch (((TObject *)CPoolGet(&gObjs, t->id))->Type)
 		{
 		case OBJ_KEYCARD_RED:
 			dotColor = colorRedDoor;
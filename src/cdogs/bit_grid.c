@@ -0,0 +1,107 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "bit_grid.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+
+void BitGridInit(BitGrid *g, const Vec2i size)
+{
+	memset(g, 0, sizeof *g);
+	g->Size = size;
+	g->Stride = (size.x + 31) / 32;
+	CArrayInit(&g->Words, sizeof(uint32_t));
+	const uint32_t zero = 0;
+	for (int i = 0; i < g->Stride * size.y; i++)
+	{
+		CArrayPushBack(&g->Words, &zero);
+	}
+}
+void BitGridTerminate(BitGrid *g)
+{
+	CArrayTerminate(&g->Words);
+	memset(g, 0, sizeof *g);
+}
+
+void BitGridSet(BitGrid *g, const Vec2i v, const bool value)
+{
+	CASSERT(
+		v.x >= 0 && v.x < g->Size.x && v.y >= 0 && v.y < g->Size.y,
+		"bit grid set out of range");
+	uint32_t *word = CArrayGet(&g->Words, v.y * g->Stride + v.x / 32);
+	const uint32_t bit = (uint32_t)1 << (v.x % 32);
+	if (value)
+	{
+		*word |= bit;
+	}
+	else
+	{
+		*word &= ~bit;
+	}
+}
+void BitGridSetAll(BitGrid *g, const bool value)
+{
+	// Bits past the end of each row are set too; they are never read
+	memset(
+		g->Words.data, value ? 0xFF : 0, g->Words.size * g->Words.elemSize);
+}
+
+// Mask of bits from..to inclusive, within a word
+static uint32_t WordMask(const int from, const int to)
+{
+	const uint32_t high = to == 31 ? 0xFFFFFFFF : ((uint32_t)1 << (to + 1)) - 1;
+	const uint32_t low = ((uint32_t)1 << from) - 1;
+	return high & ~low;
+}
+bool BitGridAnyInRect(const BitGrid *g, const Vec2i min, const Vec2i max)
+{
+	const Vec2i lo = Vec2iNew(MAX(min.x, 0), MAX(min.y, 0));
+	const Vec2i hi = Vec2iNew(
+		MIN(max.x, g->Size.x - 1), MIN(max.y, g->Size.y - 1));
+	if (lo.x > hi.x || lo.y > hi.y)
+	{
+		return false;
+	}
+	const uint32_t *words = g->Words.data;
+	const int firstWord = lo.x / 32;
+	const int lastWord = hi.x / 32;
+	for (int y = lo.y; y <= hi.y; y++)
+	{
+		const uint32_t *row = words + y * g->Stride;
+		for (int w = firstWord; w <= lastWord; w++)
+		{
+			const int from = w == firstWord ? lo.x % 32 : 0;
+			const int to = w == lastWord ? hi.x % 32 : 31;
+			if (row[w] & WordMask(from, to))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
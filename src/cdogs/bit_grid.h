@@ -0,0 +1,64 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __BIT_GRID
+#define __BIT_GRID
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "c_array.h"
+#include "sys_specifics.h"
+#include "vector.h"
+
+// A grid of bits, packed into 32-bit words; each row starts on a new word
+// so that runs of cells in a row can be tested a word at a time
+typedef struct
+{
+	Vec2i Size;
+	int Stride;	// words per row
+	CArray Words;	// of uint32_t
+} BitGrid;
+
+void BitGridInit(BitGrid *g, const Vec2i size);
+void BitGridTerminate(BitGrid *g);
+
+void BitGridSet(BitGrid *g, const Vec2i v, const bool value);
+void BitGridSetAll(BitGrid *g, const bool value);
+// Cells outside the grid are false
+static INLINE bool BitGridGet(const BitGrid *g, const Vec2i v)
+{
+	if (v.x < 0 || v.x >= g->Size.x || v.y < 0 || v.y >= g->Size.y)
+	{
+		return false;
+	}
+	const uint32_t *words = g->Words.data;
+	return (words[v.y * g->Stride + v.x / 32] >> (v.x % 32)) & 1;
+}
+// Whether any cell in the inclusive rectangle is set;
+// the rectangle is clamped to the grid
+bool BitGridAnyInRect(const BitGrid *g, const Vec2i min, const Vec2i max);
+
+#endif
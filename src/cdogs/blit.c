@@ -60,6 +60,7 @@
 #include "config.h"
 #include "grafx.h"
 #include "palette.h"
+#include "thread_pool.h"
 #include "utils.h" /* for debug() */
 
 
@@ -184,114 +185,133 @@ void BlitPicHighlight(
 	}
 }
 
-void BlitBackground(
-	GraphicsDevice *device,
-	const Pic *pic, Vec2i pos, const HSV *tint, const bool isTransparent)
+// The rows and columns of a pic, drawn at pos, that are within the
+// clipping; returns false if none are
+static bool ClipPic(
+	const GraphicsDevice *g, const Pic *pic, const Vec2i pos,
+	Vec2i *start, Vec2i *end)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	start->x = MAX(0, g->clipping.left - pos.x);
+	start->y = MAX(0, g->clipping.top - pos.y);
+	end->x = MIN(pic->size.x, g->clipping.right + 1 - pos.x);
+	end->y = MIN(pic->size.y, g->clipping.bottom + 1 - pos.y);
+	return start->x < end->x && start->y < end->y;
+}
+
+// The last tint used, as most blits in a frame use the same one
+static BlitTint sTint;
+static bool sIsTintInitialized = false;
+static const BlitTint *GetTint(const GraphicsDevice *device, const HSV *tint)
+{
+	const SDL_PixelFormat *f = device->screen->format;
+	if (!sIsTintInitialized ||
+		sTint.Tint.h != tint->h || sTint.Tint.s != tint->s ||
+		sTint.Tint.v != tint->v ||
+		sTint.Amask != device->Amask || sTint.Rshift != f->Rshift ||
+		sTint.Gshift != f->Gshift || sTint.Bshift != f->Bshift)
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
+		BlitTintInit(
+			&sTint, *tint, device->Amask, f->Rshift, f->Gshift, f->Bshift);
+		sIsTintInitialized = true;
+	}
+	return &sTint;
+}
+
+// Get the next part of a pic row to draw, within the columns
+// [left, right), starting from the part numbered *i. With spans, the parts
+// are the runs of non-zero pixels; without, the whole row is one part.
+// Returns false when there are no more.
+static bool NextRowPart(
+	const Pic *pic, const bool useSpans, const int y,
+	const int left, const int right, int *i, int *x, int *n)
+{
+	if (!useSpans || pic->RowSpans == NULL)
+	{
+		*x = left;
+		*n = right - left;
+		return (*i)++ == 0;
+	}
+	for (int k = pic->RowSpans[y] + *i; k < pic->RowSpans[y + 1]; k++)
+	{
+		const PicSpan *span = &pic->Spans[k];
+		if (span->Start >= right)
 		{
 			break;
 		}
-		if (yoff < device->clipping.top)
+		(*i)++;
+		*x = MAX(span->Start, left);
+		*n = MIN(span->Start + span->Length, right) - *x;
+		if (*n > 0)
 		{
-			current += pic->size.x;
-			continue;
+			return true;
 		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
+	}
+	return false;
+}
+
+void BlitBackground(
+	GraphicsDevice *device,
+	const Pic *pic, Vec2i pos, const HSV *tint, const bool isTransparent)
+{
+	pos = Vec2iAdd(pos, pic->offset);
+	Vec2i start, end;
+	if (!ClipPic(device, pic, pos, &start, &end))
+	{
+		return;
+	}
+	const BlitTint *t = tint != NULL ? GetTint(device, tint) : NULL;
+	// The spans have no zero pixels, so they need no more checks
+	const bool useSpans = isTransparent && pic->RowSpans != NULL;
+	const bool isPartTransparent = isTransparent && !useSpans;
+	for (int y = start.y; y < end.y; y++)
+	{
+		const int targetRow =
+			(y + pos.y) * device->cachedConfig.Res.x + pos.x;
+		const Uint32 *current = pic->Data + y * pic->size.x;
+		int x, n;
+		for (int i = 0;
+			NextRowPart(pic, useSpans, y, start.x, end.x, &i, &x, &n);)
 		{
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
+			Uint32 *target = device->buf + (targetRow + x);
+			if (t != NULL)
 			{
-				current += pic->size.x - j;
-				break;
+				gBlitSpan.Tint(target, current + x, n, t, isPartTransparent);
 			}
-			if ((isTransparent && *current) ||  !isTransparent)
+			else
 			{
-				Uint32 *target = gGraphicsDevice.buf + yoff + xoff;
-				if (tint != NULL)
-				{
-					color_t targetColor =
-						PixelToColor(&gGraphicsDevice, *target);
-					color_t blendedColor = ColorTint(targetColor, *tint);
-					*target = PixelFromColor(&gGraphicsDevice, blendedColor);
-				}
-				else
-				{
-					*target = *current;
-				}
+				// Multiplying by all ones copies the pixels
+				gBlitSpan.Masked(
+					target, current + x, n, 0xFFFFFFFF, isPartTransparent);
 			}
-			current++;
 		}
 	}
 }
 
 void Blit(GraphicsDevice *device, const Pic *pic, Vec2i pos)
 {
-	Uint32 *current = pic->Data;
 	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	Vec2i start, end;
+	if (!ClipPic(device, pic, pos, &start, &end))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
+		return;
+	}
+	for (int y = start.y; y < end.y; y++)
+	{
+		const int targetRow =
+			(y + pos.y) * device->cachedConfig.Res.x + pos.x;
+		const Uint32 *current = pic->Data + y * pic->size.x;
+		int x, n;
+		// Zero pixels are also skipped for having no alpha; the copy still
+		// checks the alpha of the rest
+		for (int i = 0;
+			NextRowPart(pic, true, y, start.x, end.x, &i, &x, &n);)
 		{
-			Uint32 *target;
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if ((*current & device->Amask) == 0)
-			{
-				/*
-				// hack to blit transparent background as hot pink
-				target = device->buf + yoff + xoff;
-				*target = PixelFromColor(device, colorMagenta);
-				*/
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			*target = *current;
-			current++;
+			gBlitSpan.Transparent(
+				device->buf + (targetRow + x), current + x, n, device->Amask);
 		}
 	}
 }
 
-Uint32 PixelMult(Uint32 p, Uint32 m)
-{
-	return
-		((p & 0xFF) * (m & 0xFF) / 0xFF) |
-		((((p & 0xFF00) >> 8) * ((m & 0xFF00) >> 8) / 0xFF) << 8) |
-		((((p & 0xFF0000) >> 16) * ((m & 0xFF0000) >> 16) / 0xFF) << 16) |
-		((((p & 0xFF000000) >> 24) * ((m & 0xFF000000) >> 24) / 0xFF) << 24);
-}
 void BlitMasked(
 	GraphicsDevice *device,
 	const Pic *pic,
@@ -299,45 +319,27 @@ void BlitMasked(
 	color_t mask,
 	int isTransparent)
 {
-	Uint32 *current = pic->Data;
-	Uint32 maskPixel = PixelFromColor(device, mask);
-	int i;
+	const Uint32 maskPixel = PixelFromColor(device, mask);
 	pos = Vec2iAdd(pos, pic->offset);
-	for (i = 0; i < pic->size.y; i++)
+	Vec2i start, end;
+	if (!ClipPic(device, pic, pos, &start, &end))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
+		return;
+	}
+	const bool useSpans = isTransparent && pic->RowSpans != NULL;
+	const bool isPartTransparent = isTransparent && !useSpans;
+	for (int y = start.y; y < end.y; y++)
+	{
+		const int targetRow =
+			(y + pos.y) * device->cachedConfig.Res.x + pos.x;
+		const Uint32 *current = pic->Data + y * pic->size.x;
+		int x, n;
+		for (int i = 0;
+			NextRowPart(pic, useSpans, y, start.x, end.x, &i, &x, &n);)
 		{
-			Uint32 *target;
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (isTransparent && *current == 0)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			*target = PixelMult(*current, maskPixel);
-			current++;
+			gBlitSpan.Masked(
+				device->buf + (targetRow + x), current + x, n,
+				maskPixel, isPartTransparent);
 		}
 	}
 }
@@ -392,83 +394,11 @@ void BlitBlend(
 
 #define PixelIndex(x, y, w)		(y * w + x)
 
-static INLINE
-void Scale8(Uint32 *d, const Uint32 *s, const int w, const int h, const int sf)
-{
-	int sx;
-	int sy;
-	int f = sf;
-
-	int dx, dy, dw;
-
-	if (f > 4)
-	{
-		f = 4;	/* max 4x for the moment */
-	}
-
-	dw = w * f;
-
-	for (sy = 0; sy < h; sy++) {
-		dy = f * sy;
-		for (sx = 0; sx < w; sx++)
-		{
-			Uint32 p = s[PixelIndex(sx, sy, w)];
-			dx = f * sx;
-
-			switch (f) {
-				case 4:
-					/* right side */
-					d[PixelIndex((dx + 3),	(dy + 1),	dw)] = p;
-					d[PixelIndex((dx + 3),	(dy + 2),	dw)] = p;
-					d[PixelIndex((dx + 3),	dy,		dw)] = p;
-
-					/* bottom row */
-					d[PixelIndex(dx,	(dy + 3),	dw)] = p;
-					d[PixelIndex((dx + 1),	(dy + 3),	dw)] = p;
-					d[PixelIndex((dx + 2),	(dy + 3),	dw)] = p;
-
-					/* bottom right */
-					d[PixelIndex((dx + 3),	(dy + 3),	dw)] = p;
-
-				case 3:
-					/* right side */
-					d[PixelIndex((dx + 2),	(dy + 1),	dw)] = p;
-					d[PixelIndex((dx + 2),	dy,		dw)] = p;
-
-					/* bottom row */
-					d[PixelIndex(dx,	(dy + 2),	dw)] = p;
-					d[PixelIndex((dx + 1),	(dy + 2),	dw)] = p;
-
-					/* bottom right */
-					d[PixelIndex((dx + 2),	(dy + 2),	dw)] = p;
-
-				case 2:
-					d[PixelIndex((dx + 1),	dy,		dw)] = p;
-					d[PixelIndex((dx + 1),	(dy + 1),	dw)] = p;
-					d[PixelIndex(dx,	(dy + 1),	dw)] = p;
-
-				default:
-					d[PixelIndex(dx,	dy,		dw)] = p;
-			}
-		}
-	}
-}
-
 static Uint32 PixAvg(Uint32 p1, Uint32 p2)
 {
-	union
-	{
-		Uint8 rgba[4];
-		Uint32 out;
-	} u1, u2;
-	int i;
-	u1.out = p1;
-	u2.out = p2;
-	for (i = 0; i < 4; i++)
-	{
-		u1.rgba[i] = (Uint8)CLAMP(((int)u1.rgba[i] + u2.rgba[i]) / 2, 0, 255);
-	}
-	return u1.out;
+	// Each byte rounded down, all four at once: the bits in common, plus
+	// half the others, without borrowing from the next byte
+	return (p1 & p2) + (((p1 ^ p2) >> 1) & 0x7F7F7F7F);
 }
 static Uint32 Pix3rds(Uint32 p1, Uint32 p2)
 {
@@ -486,157 +416,275 @@ static Uint32 Pix3rds(Uint32 p1, Uint32 p2)
 	}
 	return u1.out;
 }
-static void Bilinear(
-	Uint32 *dest, const Uint32 *src,
-	const int w, const int h,
+// Scale source row sy; below is the row under it, or the row itself if it
+// is the last
+static void BilinearRow(
+	Uint32 *dest, const Uint32 *row, const Uint32 *below,
+	const int w, const int sy,
 	const int scaleFactor)
 {
-	int sx, sy;
+	int sx;
 	int dw = scaleFactor * w;
-	for (sy = 0; sy < h; sy++)
+	int dy = scaleFactor * sy;
+	for (sx = 0; sx < w; sx++)
 	{
-		int dy = scaleFactor * sy;
-		for (sx = 0; sx < w; sx++)
+		Uint32 p = row[sx];
+		int dx = scaleFactor * sx;
+		switch (scaleFactor)
 		{
-			Uint32 p = src[PixelIndex(sx, sy, w)];
-			int dx = scaleFactor * sx;
-			switch (scaleFactor)
+		#define BLIT(x, y, pix) dest[PixelIndex((x), (y), dw)] = pix;
+		case 4:
 			{
-			#define BLIT(x, y, pix) dest[PixelIndex((x), (y), dw)] = pix;
-			case 4:
-				{
-					// 0 1 2 3|g
-					// 4 5 6 7|h
-					// 8 9 a b|i
-					// c d e f|j
-					// k-l-m-n+o
-					Uint32 pg = src[PixelIndex(MIN(sx+1, w-1), sy, w)];
-					Uint32 p2 = PixAvg(p, pg);
-					Uint32 p1 = PixAvg(p, p2);
-					Uint32 p3 = PixAvg(p2, pg);
-					Uint32 pk = src[PixelIndex(sx, MIN(sy+1, h-1), w)];
-					Uint32 p8 = PixAvg(p, pk);
-					Uint32 p4 = PixAvg(p, p8);
-					Uint32 pc = PixAvg(p8, pk);
-					Uint32 po = src[PixelIndex(MIN(sx+1, w-1), MIN(sy+1, h-1), w)];
-					Uint32 pi = PixAvg(pg, po);
-					Uint32 pa = PixAvg(p8, pi);
-					Uint32 p9 = PixAvg(p8, pa);
-					Uint32 pb = PixAvg(pa, pi);
-					Uint32 p6 = PixAvg(p2, pa);
-					Uint32 p5 = PixAvg(p4, p6);
-					Uint32 pm = PixAvg(pk, po);
-					Uint32 pe = PixAvg(pa, pm);
-					Uint32 ph = PixAvg(pg, pi);
-					Uint32 p7 = PixAvg(p6, ph);
-					Uint32 pj = PixAvg(pi, po);
-					Uint32 pd = PixAvg(pc, pe);
-					Uint32 pf = PixAvg(pe, pj);
-					BLIT(dx, dy, p);
-					BLIT(dx+1, dy, p1);
-					BLIT(dx+2, dy, p2);
-					BLIT(dx+3, dy, p3);
-					BLIT(dx, dy+1, p4);
-					BLIT(dx+1, dy+1, p5);
-					BLIT(dx+2, dy+1, p6);
-					BLIT(dx+3, dy+1, p7);
-					BLIT(dx, dy+2, p8);
-					BLIT(dx+1, dy+2, p9);
-					BLIT(dx+2, dy+2, pa);
-					BLIT(dx+3, dy+2, pb);
-					BLIT(dx, dy+3, pc);
-					BLIT(dx+1, dy+3, pd);
-					BLIT(dx+2, dy+3, pe);
-					BLIT(dx+3, dy+3, pf);
-				}
-				break;
-			case 3:
+				// 0 1 2 3|g
+				// 4 5 6 7|h
+				// 8 9 a b|i
+				// c d e f|j
+				// k-l-m-n+o
+				Uint32 pg = row[MIN(sx+1, w-1)];
+				Uint32 p2 = PixAvg(p, pg);
+				Uint32 p1 = PixAvg(p, p2);
+				Uint32 p3 = PixAvg(p2, pg);
+				Uint32 pk = below[sx];
+				Uint32 p8 = PixAvg(p, pk);
+				Uint32 p4 = PixAvg(p, p8);
+				Uint32 pc = PixAvg(p8, pk);
+				Uint32 po = below[MIN(sx+1, w-1)];
+				Uint32 pi = PixAvg(pg, po);
+				Uint32 pa = PixAvg(p8, pi);
+				Uint32 p9 = PixAvg(p8, pa);
+				Uint32 pb = PixAvg(pa, pi);
+				Uint32 p6 = PixAvg(p2, pa);
+				Uint32 p5 = PixAvg(p4, p6);
+				Uint32 pm = PixAvg(pk, po);
+				Uint32 pe = PixAvg(pa, pm);
+				Uint32 ph = PixAvg(pg, pi);
+				Uint32 p7 = PixAvg(p6, ph);
+				Uint32 pj = PixAvg(pi, po);
+				Uint32 pd = PixAvg(pc, pe);
+				Uint32 pf = PixAvg(pe, pj);
+				BLIT(dx, dy, p);
+				BLIT(dx+1, dy, p1);
+				BLIT(dx+2, dy, p2);
+				BLIT(dx+3, dy, p3);
+				BLIT(dx, dy+1, p4);
+				BLIT(dx+1, dy+1, p5);
+				BLIT(dx+2, dy+1, p6);
+				BLIT(dx+3, dy+1, p7);
+				BLIT(dx, dy+2, p8);
+				BLIT(dx+1, dy+2, p9);
+				BLIT(dx+2, dy+2, pa);
+				BLIT(dx+3, dy+2, pb);
+				BLIT(dx, dy+3, pc);
+				BLIT(dx+1, dy+3, pd);
+				BLIT(dx+2, dy+3, pe);
+				BLIT(dx+3, dy+3, pf);
+			}
+			break;
+		case 3:
+			{
+				// 0 1 2|9
+				// 3 4 5|a
+				// 6 7 8|b
+				// c-d-e+f
+				Uint32 p9 = row[MIN(sx+1, w-1)];
+				Uint32 p1 = Pix3rds(p9, p);
+				Uint32 p2 = Pix3rds(p, p9);
+				Uint32 pc = below[sx];
+				Uint32 p3 = Pix3rds(pc, p);
+				Uint32 p6 = Pix3rds(p, pc);
+				Uint32 pf = below[MIN(sx+1, w-1)];
+				Uint32 pa = Pix3rds(pf, p9);
+				Uint32 pb = Pix3rds(p9, pf);
+				Uint32 p4 = Pix3rds(pa, p3);
+				Uint32 p5 = Pix3rds(p3, pa);
+				Uint32 p7 = Pix3rds(pb, p6);
+				Uint32 p8 = Pix3rds(p6, pb);
+				BLIT(dx, dy, p);
+				BLIT(dx+1, dy, p1);
+				BLIT(dx+2, dy, p2);
+				BLIT(dx, dy+1, p3);
+				BLIT(dx+1, dy+1, p4);
+				BLIT(dx+2, dy+1, p5);
+				BLIT(dx, dy+2, p6);
+				BLIT(dx+1, dy+2, p7);
+				BLIT(dx+2, dy+2, p8);
+			}
+			break;
+		case 2:
+			{
+				// 0 1|4
+				// 2 3|5
+				// 6-7+8
+				Uint32 p4 = row[MIN(sx+1, w-1)];
+				Uint32 p1 = PixAvg(p, p4);
+				Uint32 p6 = below[sx];
+				Uint32 p2 = PixAvg(p, p6);
+				Uint32 p8 = below[MIN(sx+1, w-1)];
+				Uint32 p5 = PixAvg(p4, p8);
+				Uint32 p3 = PixAvg(p2, p5);
+				BLIT(dx, dy, p);
+				BLIT(dx+1, dy, p1);
+				BLIT(dx, dy+1, p2);
+				BLIT(dx+1, dy+1, p3);
+			}
+			break;
+		default:
+			BLIT(dx, dy, p);
+			break;
+		#undef BLIT
+		}
+	}
+}
+
+// The screen is brightened and scaled in one pass, reading the buffer and
+// writing the screen, in stripes of rows run on the flip threads.
+// The buffer itself is left as it was drawn.
+typedef enum
+{
+	FLIP_COPY,
+	FLIP_NEAREST,
+	FLIP_BILINEAR
+} FlipMode;
+typedef struct
+{
+	const Uint32 *Src;
+	Uint32 *Dst;
+	Vec2i Size;
+	FlipMode Mode;
+	int Scale;
+	const BlitBrightness *Brightness;	// NULL if it changes nothing
+	int Stripes;
+} FlipJob;
+static ThreadPool sFlipPool;
+static bool sFlipPoolInitialized = false;
+static Uint32 *sFlipRows = NULL;	// two rows per thread
+static int sFlipRowsSize = 0;
+static Uint32 *sFlipBrightBuf = NULL;	// the brightened buffer, for hqx
+static int sFlipBrightBufSize = 0;
+static BlitBrightness sBrightness;
+static bool sBrightnessInitialized = false;
+
+// Source row y, brightened into scratch if needed
+static const Uint32 *FlipSrcRow(
+	const FlipJob *j, const int y, Uint32 *scratch)
+{
+	const Uint32 *row = j->Src + y * j->Size.x;
+	if (j->Brightness == NULL)
+	{
+		return row;
+	}
+	gBlitSpan.Brighten(scratch, row, j->Size.x, j->Brightness);
+	return scratch;
+}
+static void FlipStripe(void *data, const int index, const int worker)
+{
+	const FlipJob *j = data;
+	const int w = j->Size.x;
+	const int h = j->Size.y;
+	const int yStart = index * h / j->Stripes;
+	const int yEnd = (index + 1) * h / j->Stripes;
+	Uint32 *scratch = sFlipRows + worker * 2 * w;
+	switch (j->Mode)
+	{
+	case FLIP_COPY:
+		for (int y = yStart; y < yEnd; y++)
+		{
+			Uint32 *d = j->Dst + y * w;
+			if (j->Brightness == NULL)
+			{
+				memcpy(d, j->Src + y * w, w * sizeof *d);
+			}
+			else
+			{
+				gBlitSpan.Brighten(d, j->Src + y * w, w, j->Brightness);
+			}
+		}
+		break;
+	case FLIP_NEAREST:
+		{
+			const int f = MIN(j->Scale, 4);	// max 4x for the moment
+			const int dw = w * f;
+			for (int y = yStart; y < yEnd; y++)
+			{
+				Uint32 *d = j->Dst + y * f * dw;
+				gBlitSpan.Stretch(d, FlipSrcRow(j, y, scratch), w, f);
+				for (int i = 1; i < f; i++)
 				{
-					// 0 1 2|9
-					// 3 4 5|a
-					// 6 7 8|b
-					// c-d-e+f
-					Uint32 p9 = src[PixelIndex(MIN(sx+1, w-1), sy, w)];
-					Uint32 p1 = Pix3rds(p9, p);
-					Uint32 p2 = Pix3rds(p, p9);
-					Uint32 pc = src[PixelIndex(sx, MIN(sy+1, h-1), w)];
-					Uint32 p3 = Pix3rds(pc, p);
-					Uint32 p6 = Pix3rds(p, pc);
-					Uint32 pf = src[PixelIndex(MIN(sx+1, w-1), MIN(sy+1, h-1), w)];
-					Uint32 pa = Pix3rds(pf, p9);
-					Uint32 pb = Pix3rds(p9, pf);
-					Uint32 p4 = Pix3rds(pa, p3);
-					Uint32 p5 = Pix3rds(p3, pa);
-					Uint32 p7 = Pix3rds(pb, p6);
-					Uint32 p8 = Pix3rds(p6, pb);
-					BLIT(dx, dy, p);
-					BLIT(dx+1, dy, p1);
-					BLIT(dx+2, dy, p2);
-					BLIT(dx, dy+1, p3);
-					BLIT(dx+1, dy+1, p4);
-					BLIT(dx+2, dy+1, p5);
-					BLIT(dx, dy+2, p6);
-					BLIT(dx+1, dy+2, p7);
-					BLIT(dx+2, dy+2, p8);
+					memcpy(d + i * dw, d, dw * sizeof *d);
 				}
-				break;
-			case 2:
+			}
+		}
+		break;
+	case FLIP_BILINEAR:
+		if (yStart < yEnd)
+		{
+			// Each row is brightened once, as the row below and then as
+			// the row itself; alternate between the two scratch rows
+			const Uint32 *row = FlipSrcRow(j, yStart, scratch);
+			for (int y = yStart; y < yEnd; y++)
+			{
+				const Uint32 *below = row;
+				if (y + 1 < h)
 				{
-					// 0 1|4
-					// 2 3|5
-					// 6-7+8
-					Uint32 p4 = src[PixelIndex(MIN(sx+1, w-1), sy, w)];
-					Uint32 p1 = PixAvg(p, p4);
-					Uint32 p6 = src[PixelIndex(sx, MIN(sy+1, h-1), w)];
-					Uint32 p2 = PixAvg(p, p6);
-					Uint32 p8 = src[PixelIndex(MIN(sx+1, w-1), MIN(sy+1, h-1), w)];
-					Uint32 p5 = PixAvg(p4, p8);
-					Uint32 p3 = PixAvg(p2, p5);
-					BLIT(dx, dy, p);
-					BLIT(dx+1, dy, p1);
-					BLIT(dx, dy+1, p2);
-					BLIT(dx+1, dy+1, p3);
+					below = FlipSrcRow(
+						j, y + 1, row == scratch ? scratch + w : scratch);
 				}
-				break;
-			default:
-				BLIT(dx, dy, p);
-				break;
-			#undef BLIT
+				BilinearRow(j->Dst, row, below, w, y, j->Scale);
+				row = below;
 			}
 		}
+		break;
+	default:
+		CASSERT(false, "unknown flip mode");
+		break;
 	}
 }
+static void FlipRun(
+	const FlipMode mode, Uint32 *dst, const Uint32 *src, const Vec2i size,
+	const int scale, const BlitBrightness *brightness)
+{
+	FlipJob j;
+	j.Src = src;
+	j.Dst = dst;
+	j.Size = size;
+	j.Mode = mode;
+	j.Scale = scale;
+	j.Brightness = brightness;
+	j.Stripes = sFlipPool.NumThreads;
+	ThreadPoolRun(&sFlipPool, j.Stripes, FlipStripe, &j);
+}
 
-static void ApplyBrightness(Uint32 *screen, Vec2i screenSize, int brightness)
+static void FlipThreadsInit(const int numThreads, const int width)
 {
-	double f = pow(1.07177346254, brightness);	// 10th root of 2; i.e. n^10 = 2
-	int m = (int)(0xFF * f);
-	int y;
-	for (y = 0; y < screenSize.y; y++)
+	if (!sFlipPoolInitialized || sFlipPool.NumThreads != numThreads)
 	{
-		int x;
-		for (x = 0; x < screenSize.x; x++)
+		if (sFlipPoolInitialized)
 		{
-			// Semi-optimised pixel multiplcation routine
-			// Multiply each 8-bit component with the gamma mask
-			// Detect overflows by checking if there are bits above 255
-			// If so, turning into boolean (!!) and negation will create
-			// a -1 (i.e. FFFFFFFF) mask which fills all the bits with 1
-			// i.e. saturated multiply
-			int idx = x + y * screenSize.x;
-			Uint32 p = screen[idx];
-			Uint32 pp;
-			screen[idx] = 0;
-			pp = ((p & 0xFF) * m / 0xFF);
-			screen[idx] |= (pp | -!!(pp >> 8)) & 0xFF;
-			pp = (((p >> 8) & 0xFF) * m / 0xFF);
-			screen[idx] |= ((pp | -!!(pp >> 8)) & 0xFF) << 8;
-			pp = (((p >> 16) & 0xFF) * m / 0xFF);
-			screen[idx] |= ((pp | -!!(pp >> 8)) & 0xFF) << 16;
-			pp = (((p >> 24) & 0xFF) * m / 0xFF);
-			screen[idx] |= ((pp | -!!(pp >> 8)) & 0xFF) << 24;
+			ThreadPoolTerminate(&sFlipPool);
 		}
+		ThreadPoolInit(&sFlipPool, numThreads);
+		sFlipPoolInitialized = true;
+	}
+	const int rowsSize = sFlipPool.NumThreads * 2 * width;
+	if (sFlipRowsSize < rowsSize)
+	{
+		CREALLOC(sFlipRows, rowsSize * sizeof *sFlipRows);
+		sFlipRowsSize = rowsSize;
+	}
+}
+void BlitFlipTerminate(void)
+{
+	if (sFlipPoolInitialized)
+	{
+		ThreadPoolTerminate(&sFlipPool);
+		sFlipPoolInitialized = false;
 	}
+	CFREE(sFlipRows);
+	sFlipRows = NULL;
+	sFlipRowsSize = 0;
+	CFREE(sFlipBrightBuf);
+	sFlipBrightBuf = NULL;
+	sFlipBrightBufSize = 0;
 }
 
 void BlitFlip(GraphicsDevice *device, GraphicsConfig *config)
@@ -648,7 +696,30 @@ void BlitFlip(GraphicsDevice *device, GraphicsConfig *config)
 	int scr_size = screenSize.x * screenSize.y;
 	int scalef = config->ScaleFactor;
 
-	ApplyBrightness(device->buf, screenSize, config->Brightness);
+	if (!sBrightnessInitialized ||
+		sBrightness.Brightness != config->Brightness)
+	{
+		BlitBrightnessInit(&sBrightness, config->Brightness);
+		sBrightnessInitialized = true;
+	}
+	const BlitBrightness *brightness =
+		BlitBrightnessIsIdentity(&sBrightness) ? NULL : &sBrightness;
+	FlipThreadsInit(ThreadPoolNumThreads(config->ScaleThreads), screenSize.x);
+
+	// hqx needs the whole brightened screen to read from
+	Uint32 *hqxSrc = device->buf;
+	if (scalef != 1 && config->ScaleMode == SCALE_MODE_HQX &&
+		brightness != NULL)
+	{
+		if (sFlipBrightBufSize < scr_size)
+		{
+			CREALLOC(sFlipBrightBuf, scr_size * sizeof *sFlipBrightBuf);
+			sFlipBrightBufSize = scr_size;
+		}
+		FlipRun(
+			FLIP_COPY, sFlipBrightBuf, device->buf, screenSize, 1, brightness);
+		hqxSrc = sFlipBrightBuf;
+	}
 
 	if (SDL_LockSurface(device->screen) == -1)
 	{
@@ -658,24 +729,34 @@ void BlitFlip(GraphicsDevice *device, GraphicsConfig *config)
 
 	if (scalef == 1)
 	{
-		memcpy(pScreen, device->buf, sizeof *pScreen * scr_size);
+		if (brightness == NULL)
+		{
+			memcpy(pScreen, device->buf, sizeof *pScreen * scr_size);
+		}
+		else
+		{
+			FlipRun(
+				FLIP_COPY, pScreen, device->buf, screenSize, 1, brightness);
+		}
 	}
 	else if (config->ScaleMode == SCALE_MODE_BILINEAR)
 	{
-		Bilinear(pScreen, device->buf, screenSize.x, screenSize.y, scalef);
+		FlipRun(
+			FLIP_BILINEAR, pScreen, device->buf, screenSize, scalef,
+			brightness);
 	}
 	else if (config->ScaleMode == SCALE_MODE_HQX)
 	{
 		switch (scalef)
 		{
 		case 2:
-			hq2x_32(device->buf, pScreen, screenSize.x, screenSize.y);
+			hq2x_32(hqxSrc, pScreen, screenSize.x, screenSize.y);
 			break;
 		case 3:
-			hq3x_32(device->buf, pScreen, screenSize.x, screenSize.y);
+			hq3x_32(hqxSrc, pScreen, screenSize.x, screenSize.y);
 			break;
 		case 4:
-			hq4x_32(device->buf, pScreen, screenSize.x, screenSize.y);
+			hq4x_32(hqxSrc, pScreen, screenSize.x, screenSize.y);
 			break;
 		default:
 			assert(0);
@@ -684,7 +765,9 @@ void BlitFlip(GraphicsDevice *device, GraphicsConfig *config)
 	}
 	else
 	{
-		Scale8(pScreen, device->buf, screenSize.x, screenSize.y, scalef);
+		FlipRun(
+			FLIP_NEAREST, pScreen, device->buf, screenSize, scalef,
+			brightness);
 	}
 
 	SDL_UnlockSurface(device->screen);
@@ -51,6 +51,7 @@
 
 #include <SDL_stdinc.h>
 
+#include "blit_span.h"
 #include "grafx.h"
 #include "pic.h"
 #include "pic_file.h"
@@ -105,6 +106,7 @@ void BlitPicHighlight(
 #define DrawBTPic(g, pic, pos, tint) BlitBackground(g, pic, pos, tint, true)
 
 void BlitFlip(GraphicsDevice *device, GraphicsConfig *config);
+void BlitFlipTerminate(void);
 
 #define BLIT_BRIGHTNESS_MIN (-10)
 #define BLIT_BRIGHTNESS_MAX 10
@@ -0,0 +1,685 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "blit_span.h"
+
+#include <math.h>
+
+#include "utils.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+	defined(__i386__) || defined(_M_IX86)
+#define BLIT_SPAN_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+// Only these functions are built for the newer instructions; the rest of
+// the program still runs on any x86
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+const char *BlitSpanImplStr(const BlitSpanImpl impl)
+{
+	switch (impl)
+	{
+	case BLIT_SPAN_SCALAR: return "scalar";
+	case BLIT_SPAN_SSE2: return "SSE2";
+	case BLIT_SPAN_AVX2: return "AVX2";
+	default: return "";
+	}
+}
+
+Uint32 PixelMult(Uint32 p, Uint32 m)
+{
+	return
+		((p & 0xFF) * (m & 0xFF) / 0xFF) |
+		((((p & 0xFF00) >> 8) * ((m & 0xFF00) >> 8) / 0xFF) << 8) |
+		((((p & 0xFF0000) >> 16) * ((m & 0xFF0000) >> 16) / 0xFF) << 16) |
+		((((p & 0xFF000000) >> 24) * ((m & 0xFF000000) >> 24) / 0xFF) << 24);
+}
+
+static Uint32 TintPack(const BlitTint *t, const color_t c)
+{
+	return
+		((Uint32)c.r << t->Rshift) |
+		((Uint32)c.g << t->Gshift) |
+		((Uint32)c.b << t->Bshift);
+}
+void BlitTintInit(
+	BlitTint *t, const HSV tint, const Uint32 amask,
+	const int rShift, const int gShift, const int bShift)
+{
+	t->Tint = tint;
+	t->Amask = amask;
+	t->Rshift = rShift;
+	t->Gshift = gShift;
+	t->Bshift = bShift;
+	// Unless the hue is kept and the saturation changed, each component
+	// comes from the average alone; see ColorTint
+	t->UseLut = tint.s <= 0 || tint.h >= 0;
+	if (t->UseLut)
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			color_t c;
+			c.r = c.g = c.b = (uint8_t)i;
+			c.a = 0;
+			t->Lut[i] = TintPack(t, ColorTint(c, tint));
+		}
+	}
+}
+
+void BlitBrightnessInit(BlitBrightness *b, const int brightness)
+{
+	b->Brightness = brightness;
+	// 10th root of 2; i.e. n^10 = 2
+	b->M = (int)(0xFF * pow(1.07177346254, brightness));
+	for (int i = 0; i < 256; i++)
+	{
+		b->Lut[i] = (Uint8)MIN(i * b->M / 0xFF, 0xFF);
+	}
+}
+bool BlitBrightnessIsIdentity(const BlitBrightness *b)
+{
+	return b->M == 0xFF;
+}
+
+
+static void TransparentScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (src[i] & amask)
+		{
+			dst[i] = src[i];
+		}
+	}
+}
+static void MaskedScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const bool isTransparent)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (isTransparent && src[i] == 0)
+		{
+			continue;
+		}
+		dst[i] = PixelMult(src[i], mask);
+	}
+}
+static Uint32 TintPixel(const Uint32 p, const BlitTint *t)
+{
+	color_t c;
+	c.r = (uint8_t)(p >> t->Rshift);
+	c.g = (uint8_t)(p >> t->Gshift);
+	c.b = (uint8_t)(p >> t->Bshift);
+	c.a = 0;
+	if (t->UseLut)
+	{
+		return t->Lut[((int)c.r + c.g + c.b) / 3] | (p & t->Amask);
+	}
+	return TintPack(t, ColorTint(c, t->Tint)) | (p & t->Amask);
+}
+static void TintScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const BlitTint *t,
+	const bool isTransparent)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (isTransparent && src[i] == 0)
+		{
+			continue;
+		}
+		dst[i] = TintPixel(dst[i], t);
+	}
+}
+static void BrightenScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const BlitBrightness *b)
+{
+	for (int i = 0; i < n; i++)
+	{
+		const Uint32 p = src[i];
+		dst[i] =
+			(Uint32)b->Lut[p & 0xFF] |
+			((Uint32)b->Lut[(p >> 8) & 0xFF] << 8) |
+			((Uint32)b->Lut[(p >> 16) & 0xFF] << 16) |
+			((Uint32)b->Lut[p >> 24] << 24);
+	}
+}
+static void StretchScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const int scale)
+{
+	for (int i = 0; i < n; i++)
+	{
+		for (int j = 0; j < scale; j++)
+		{
+			*dst++ = src[i];
+		}
+	}
+}
+
+
+#ifdef BLIT_SPAN_X86
+// Enough for the brightest brightness; larger multipliers are done with
+// the scalar version
+#define BRIGHTEN_M_MAX 0x200
+
+// The SIMD versions do the same sums as the scalar ones:
+// - PixelMult's x / 255, for x up to 255 * 255, is exactly
+//   (x + 1 + ((x + 1) >> 8)) >> 8
+// - the average's x / 3, for x up to 3 * 255, is exactly (x * 0xAAAB) >> 17
+// - ColorTint's floating point sums are done in doubles in the same order,
+//   and clamped and truncated the same way
+// - brightening's x / 255, for x up to 255 * BRIGHTEN_M_MAX, is done with
+//   the same sum in 32 bits; it is only inexact where both results are
+//   over 255, and so saturate to the same byte
+// Each handles as many whole vectors as it can, and the rest of the span
+// with the scalar version.
+
+// a where sel is set, b elsewhere
+static TARGET_SSE2 __m128i SelectSSE2(
+	const __m128i sel, const __m128i a, const __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(sel, a), _mm_andnot_si128(sel, b));
+}
+static TARGET_SSE2 __m128i Div255SSE2(__m128i x)
+{
+	x = _mm_add_epi16(x, _mm_set1_epi16(1));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+// m16 is the mask's components as 16-bit values, repeated
+static TARGET_SSE2 __m128i MultSSE2(const __m128i p, const __m128i m16)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), m16);
+	const __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), m16);
+	return _mm_packus_epi16(Div255SSE2(lo), Div255SSE2(hi));
+}
+static TARGET_SSE2 __m128i ComponentSSE2(const __m128i p, const __m128i shift)
+{
+	return _mm_and_si128(_mm_srl_epi32(p, shift), _mm_set1_epi32(0xFF));
+}
+static TARGET_SSE2 __m128i AverageSSE2(
+	const __m128i r, const __m128i g, const __m128i b)
+{
+	// The sum fits in the low 16 bits of each pixel
+	const __m128i sum = _mm_add_epi32(_mm_add_epi32(r, g), b);
+	return _mm_srli_epi32(_mm_mulhi_epu16(sum, _mm_set1_epi32(0xAAAB)), 1);
+}
+// A tinted component, for the two pixels in the low half of c
+static TARGET_SSE2 __m128i TintComponent2SSE2(
+	const __m128d avg, const __m128i c, const BlitTint *t)
+{
+	__m128d x = _mm_add_pd(
+		_mm_mul_pd(avg, _mm_set1_pd(1.0 - t->Tint.s)),
+		_mm_mul_pd(_mm_set1_pd(t->Tint.s), _mm_cvtepi32_pd(c)));
+	x = _mm_mul_pd(_mm_set1_pd(t->Tint.v), x);
+	x = _mm_max_pd(_mm_set1_pd(0), _mm_min_pd(_mm_set1_pd(255), x));
+	return _mm_cvttpd_epi32(x);
+}
+static TARGET_SSE2 __m128i TintComponentSSE2(
+	const __m128d avgLo, const __m128d avgHi, const __m128i c,
+	const int shift, const BlitTint *t)
+{
+	const __m128i lo = TintComponent2SSE2(avgLo, c, t);
+	const __m128i hi = TintComponent2SSE2(
+		avgHi, _mm_shuffle_epi32(c, _MM_SHUFFLE(3, 2, 3, 2)), t);
+	return _mm_sll_epi32(
+		_mm_unpacklo_epi64(lo, hi), _mm_cvtsi32_si128(shift));
+}
+
+static TARGET_SSE2 void TransparentSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask)
+{
+	const __m128i am = _mm_set1_epi32((int)amask);
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		const __m128i isClear = _mm_cmpeq_epi32(_mm_and_si128(s, am), zero);
+		_mm_storeu_si128((__m128i *)(dst + i), SelectSSE2(isClear, d, s));
+	}
+	TransparentScalar(dst + i, src + i, n - i, amask);
+}
+static TARGET_SSE2 void MaskedSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const bool isTransparent)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i m16 = _mm_unpacklo_epi8(_mm_set1_epi32((int)mask), zero);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i out = MultSSE2(s, m16);
+		if (isTransparent)
+		{
+			const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+			out = SelectSSE2(_mm_cmpeq_epi32(s, zero), d, out);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), out);
+	}
+	MaskedScalar(dst + i, src + i, n - i, mask, isTransparent);
+}
+static TARGET_SSE2 void TintSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const BlitTint *t,
+	const bool isTransparent)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i am = _mm_set1_epi32((int)t->Amask);
+	const __m128i rShift = _mm_cvtsi32_si128(t->Rshift);
+	const __m128i gShift = _mm_cvtsi32_si128(t->Gshift);
+	const __m128i bShift = _mm_cvtsi32_si128(t->Bshift);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		const __m128i r = ComponentSSE2(d, rShift);
+		const __m128i g = ComponentSSE2(d, gShift);
+		const __m128i b = ComponentSSE2(d, bShift);
+		const __m128i avg = AverageSSE2(r, g, b);
+		__m128i rgb;
+		if (t->UseLut)
+		{
+			// No gathers in SSE2
+			Uint32 idx[4];
+			_mm_storeu_si128((__m128i *)idx, avg);
+			rgb = _mm_set_epi32(
+				(int)t->Lut[idx[3]], (int)t->Lut[idx[2]],
+				(int)t->Lut[idx[1]], (int)t->Lut[idx[0]]);
+		}
+		else
+		{
+			const __m128d avgLo = _mm_cvtepi32_pd(avg);
+			const __m128d avgHi = _mm_cvtepi32_pd(
+				_mm_shuffle_epi32(avg, _MM_SHUFFLE(3, 2, 3, 2)));
+			rgb = _mm_or_si128(
+				_mm_or_si128(
+					TintComponentSSE2(avgLo, avgHi, r, t->Rshift, t),
+					TintComponentSSE2(avgLo, avgHi, g, t->Gshift, t)),
+				TintComponentSSE2(avgLo, avgHi, b, t->Bshift, t));
+		}
+		__m128i out = _mm_or_si128(rgb, _mm_and_si128(d, am));
+		if (isTransparent)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			out = SelectSSE2(_mm_cmpeq_epi32(s, zero), d, out);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i), out);
+	}
+	TintScalar(dst + i, src + i, n - i, t, isTransparent);
+}
+
+static TARGET_SSE2 __m128i Div255Epi32SSE2(__m128i x)
+{
+	x = _mm_add_epi32(x, _mm_set1_epi32(1));
+	return _mm_srli_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 8)), 8);
+}
+// Eight bytes as 16-bit values, brightened, as 16-bit values up to 510
+static TARGET_SSE2 __m128i Brighten8SSE2(const __m128i c, const __m128i m)
+{
+	const __m128i lo = _mm_mullo_epi16(c, m);
+	const __m128i hi = _mm_mulhi_epu16(c, m);
+	return _mm_packs_epi32(
+		Div255Epi32SSE2(_mm_unpacklo_epi16(lo, hi)),
+		Div255Epi32SSE2(_mm_unpackhi_epi16(lo, hi)));
+}
+static TARGET_SSE2 void BrightenSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const BlitBrightness *b)
+{
+	int i = 0;
+	if (b->M <= BRIGHTEN_M_MAX)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i m = _mm_set1_epi16((short)b->M);
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(
+				Brighten8SSE2(_mm_unpacklo_epi8(s, zero), m),
+				Brighten8SSE2(_mm_unpackhi_epi8(s, zero), m)));
+		}
+	}
+	BrightenScalar(dst + i, src + i, n - i, b);
+}
+static TARGET_SSE2 void StretchSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const int scale)
+{
+	int i = 0;
+	switch (scale)
+	{
+	case 2:
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i *d = (__m128i *)(dst + i * 2);
+			_mm_storeu_si128(d, _mm_unpacklo_epi32(s, s));
+			_mm_storeu_si128(d + 1, _mm_unpackhi_epi32(s, s));
+		}
+		break;
+	case 3:
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i *d = (__m128i *)(dst + i * 3);
+			_mm_storeu_si128(d, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 0, 0)));
+			_mm_storeu_si128(
+				d + 1, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 2, 1, 1)));
+			_mm_storeu_si128(
+				d + 2, _mm_shuffle_epi32(s, _MM_SHUFFLE(3, 3, 3, 2)));
+		}
+		break;
+	case 4:
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+			__m128i *d = (__m128i *)(dst + i * 4);
+			_mm_storeu_si128(d, _mm_shuffle_epi32(s, _MM_SHUFFLE(0, 0, 0, 0)));
+			_mm_storeu_si128(
+				d + 1, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 1, 1, 1)));
+			_mm_storeu_si128(
+				d + 2, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 2, 2, 2)));
+			_mm_storeu_si128(
+				d + 3, _mm_shuffle_epi32(s, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+		break;
+	default:
+		break;
+	}
+	StretchScalar(dst + i * scale, src + i, n - i, scale);
+}
+
+static TARGET_AVX2 __m256i Div255AVX2(__m256i x)
+{
+	x = _mm256_add_epi16(x, _mm256_set1_epi16(1));
+	return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+// Unpacking and packing both work within 128-bit lanes, so the pixels
+// come back in order
+static TARGET_AVX2 __m256i MultAVX2(const __m256i p, const __m256i m16)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(p, zero), m16);
+	const __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(p, zero), m16);
+	return _mm256_packus_epi16(Div255AVX2(lo), Div255AVX2(hi));
+}
+static TARGET_AVX2 __m256i ComponentAVX2(const __m256i p, const __m128i shift)
+{
+	return _mm256_and_si256(
+		_mm256_srl_epi32(p, shift), _mm256_set1_epi32(0xFF));
+}
+static TARGET_AVX2 __m256i AverageAVX2(
+	const __m256i r, const __m256i g, const __m256i b)
+{
+	const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(r, g), b);
+	return _mm256_srli_epi32(
+		_mm256_mulhi_epu16(sum, _mm256_set1_epi32(0xAAAB)), 1);
+}
+// A tinted component, for four pixels
+static TARGET_AVX2 __m128i TintComponent4AVX2(
+	const __m256d avg, const __m128i c, const BlitTint *t)
+{
+	__m256d x = _mm256_add_pd(
+		_mm256_mul_pd(avg, _mm256_set1_pd(1.0 - t->Tint.s)),
+		_mm256_mul_pd(_mm256_set1_pd(t->Tint.s), _mm256_cvtepi32_pd(c)));
+	x = _mm256_mul_pd(_mm256_set1_pd(t->Tint.v), x);
+	x = _mm256_max_pd(
+		_mm256_set1_pd(0), _mm256_min_pd(_mm256_set1_pd(255), x));
+	return _mm256_cvttpd_epi32(x);
+}
+static TARGET_AVX2 __m256i TintComponentAVX2(
+	const __m256d avgLo, const __m256d avgHi, const __m256i c,
+	const int shift, const BlitTint *t)
+{
+	const __m128i lo =
+		TintComponent4AVX2(avgLo, _mm256_castsi256_si128(c), t);
+	const __m128i hi =
+		TintComponent4AVX2(avgHi, _mm256_extracti128_si256(c, 1), t);
+	return _mm256_sll_epi32(
+		_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1),
+		_mm_cvtsi32_si128(shift));
+}
+
+static TARGET_AVX2 void TransparentAVX2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask)
+{
+	const __m256i am = _mm256_set1_epi32((int)amask);
+	const __m256i zero = _mm256_setzero_si256();
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		const __m256i isClear =
+			_mm256_cmpeq_epi32(_mm256_and_si256(s, am), zero);
+		_mm256_storeu_si256(
+			(__m256i *)(dst + i), _mm256_blendv_epi8(s, d, isClear));
+	}
+	TransparentScalar(dst + i, src + i, n - i, amask);
+}
+static TARGET_AVX2 void MaskedAVX2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const bool isTransparent)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i m16 =
+		_mm256_unpacklo_epi8(_mm256_set1_epi32((int)mask), zero);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i out = MultAVX2(s, m16);
+		if (isTransparent)
+		{
+			const __m256i d =
+				_mm256_loadu_si256((const __m256i *)(dst + i));
+			out = _mm256_blendv_epi8(out, d, _mm256_cmpeq_epi32(s, zero));
+		}
+		_mm256_storeu_si256((__m256i *)(dst + i), out);
+	}
+	MaskedScalar(dst + i, src + i, n - i, mask, isTransparent);
+}
+static TARGET_AVX2 void TintAVX2(
+	Uint32 *dst, const Uint32 *src, const int n, const BlitTint *t,
+	const bool isTransparent)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i am = _mm256_set1_epi32((int)t->Amask);
+	const __m128i rShift = _mm_cvtsi32_si128(t->Rshift);
+	const __m128i gShift = _mm_cvtsi32_si128(t->Gshift);
+	const __m128i bShift = _mm_cvtsi32_si128(t->Bshift);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		const __m256i r = ComponentAVX2(d, rShift);
+		const __m256i g = ComponentAVX2(d, gShift);
+		const __m256i b = ComponentAVX2(d, bShift);
+		const __m256i avg = AverageAVX2(r, g, b);
+		__m256i rgb;
+		if (t->UseLut)
+		{
+			rgb = _mm256_i32gather_epi32((const int *)t->Lut, avg, 4);
+		}
+		else
+		{
+			const __m256d avgLo =
+				_mm256_cvtepi32_pd(_mm256_castsi256_si128(avg));
+			const __m256d avgHi =
+				_mm256_cvtepi32_pd(_mm256_extracti128_si256(avg, 1));
+			rgb = _mm256_or_si256(
+				_mm256_or_si256(
+					TintComponentAVX2(avgLo, avgHi, r, t->Rshift, t),
+					TintComponentAVX2(avgLo, avgHi, g, t->Gshift, t)),
+				TintComponentAVX2(avgLo, avgHi, b, t->Bshift, t));
+		}
+		__m256i out = _mm256_or_si256(rgb, _mm256_and_si256(d, am));
+		if (isTransparent)
+		{
+			const __m256i s =
+				_mm256_loadu_si256((const __m256i *)(src + i));
+			out = _mm256_blendv_epi8(out, d, _mm256_cmpeq_epi32(s, zero));
+		}
+		_mm256_storeu_si256((__m256i *)(dst + i), out);
+	}
+	TintScalar(dst + i, src + i, n - i, t, isTransparent);
+}
+static TARGET_AVX2 __m256i Div255Epi32AVX2(__m256i x)
+{
+	x = _mm256_add_epi32(x, _mm256_set1_epi32(1));
+	return _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 8)), 8);
+}
+static TARGET_AVX2 __m256i Brighten16AVX2(const __m256i c, const __m256i m)
+{
+	const __m256i lo = _mm256_mullo_epi16(c, m);
+	const __m256i hi = _mm256_mulhi_epu16(c, m);
+	return _mm256_packs_epi32(
+		Div255Epi32AVX2(_mm256_unpacklo_epi16(lo, hi)),
+		Div255Epi32AVX2(_mm256_unpackhi_epi16(lo, hi)));
+}
+static TARGET_AVX2 void BrightenAVX2(
+	Uint32 *dst, const Uint32 *src, const int n, const BlitBrightness *b)
+{
+	int i = 0;
+	if (b->M <= BRIGHTEN_M_MAX)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i m = _mm256_set1_epi16((short)b->M);
+		for (; i + 8 <= n; i += 8)
+		{
+			const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+			_mm256_storeu_si256((__m256i *)(dst + i), _mm256_packus_epi16(
+				Brighten16AVX2(_mm256_unpacklo_epi8(s, zero), m),
+				Brighten16AVX2(_mm256_unpackhi_epi8(s, zero), m)));
+		}
+	}
+	BrightenScalar(dst + i, src + i, n - i, b);
+}
+#endif
+
+
+static const BlitSpanFuncs sFuncs[BLIT_SPAN_COUNT] =
+{
+	{
+		TransparentScalar, MaskedScalar, TintScalar,
+		BrightenScalar, StretchScalar
+	},
+#ifdef BLIT_SPAN_X86
+	{
+		TransparentSSE2, MaskedSSE2, TintSSE2,
+		BrightenSSE2, StretchSSE2
+	},
+	// Stretching only moves memory; AVX2 doesn't make it any faster
+	{
+		TransparentAVX2, MaskedAVX2, TintAVX2,
+		BrightenAVX2, StretchSSE2
+	}
+#endif
+};
+BlitSpanFuncs gBlitSpan =
+{
+	TransparentScalar, MaskedScalar, TintScalar,
+	BrightenScalar, StretchScalar
+};
+
+static bool IsSupported(const BlitSpanImpl impl)
+{
+	switch (impl)
+	{
+	case BLIT_SPAN_SCALAR:
+		return true;
+#ifdef BLIT_SPAN_X86
+#ifdef _MSC_VER
+	case BLIT_SPAN_SSE2:
+		{
+			int info[4];
+			__cpuid(info, 1);
+			return (info[3] & (1 << 26)) != 0;
+		}
+	case BLIT_SPAN_AVX2:
+		{
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+			{
+				return false;
+			}
+			__cpuid(info, 1);
+			// The OS must also save the AVX registers
+			const bool isAVXEnabled =
+				(info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+				(_xgetbv(0) & 6) == 6;
+			__cpuidex(info, 7, 0);
+			return isAVXEnabled && (info[1] & (1 << 5)) != 0;
+		}
+#else
+	case BLIT_SPAN_SSE2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2");
+	case BLIT_SPAN_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+void BlitSpanInit(void)
+{
+	for (int i = BLIT_SPAN_COUNT - 1; i >= 0; i--)
+	{
+		const BlitSpanFuncs *f = BlitSpanGetFuncs((BlitSpanImpl)i);
+		if (f != NULL)
+		{
+			gBlitSpan = *f;
+			debug(D_NORMAL, "using %s blitters\n",
+				BlitSpanImplStr((BlitSpanImpl)i));
+			return;
+		}
+	}
+}
+
+const BlitSpanFuncs *BlitSpanGetFuncs(const BlitSpanImpl impl)
+{
+	if ((unsigned)impl >= BLIT_SPAN_COUNT ||
+		sFuncs[impl].Transparent == NULL || !IsSupported(impl))
+	{
+		return NULL;
+	}
+	return &sFuncs[impl];
+}
@@ -0,0 +1,110 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __BLIT_SPAN
+#define __BLIT_SPAN
+
+#include <stdbool.h>
+
+#include <SDL_stdinc.h>
+
+#include "color.h"
+
+// The per-pixel work of the blitters, and of brightening and scaling the
+// screen (see BlitFlip), done a clipped row (span) at a time.
+// There is a scalar version of each, and on x86 SSE2 and AVX2 versions;
+// they all give exactly the same pixels. BlitSpanInit picks the fastest
+// one the CPU supports.
+
+typedef enum
+{
+	BLIT_SPAN_SCALAR,
+	BLIT_SPAN_SSE2,
+	BLIT_SPAN_AVX2,
+	BLIT_SPAN_COUNT
+} BlitSpanImpl;
+const char *BlitSpanImplStr(const BlitSpanImpl impl);
+
+// Multiply each channel of a pixel by a mask pixel's
+Uint32 PixelMult(Uint32 p, Uint32 m);
+
+// A tint (see ColorTint) and the pixel layout it is applied to
+typedef struct
+{
+	HSV Tint;
+	Uint32 Amask;	// the bits that aren't RGB; these are kept
+	int Rshift, Gshift, Bshift;
+	// Most tints only depend on the average of the RGB components;
+	// for those, the tinted RGB for each average
+	bool UseLut;
+	Uint32 Lut[256];
+} BlitTint;
+void BlitTintInit(
+	BlitTint *t, const HSV tint, const Uint32 amask,
+	const int rShift, const int gShift, const int bShift);
+
+// Screen brightness; every byte of a pixel is multiplied by M / 0xFF,
+// saturated, which is 2x per 10 brightness levels
+typedef struct
+{
+	int Brightness;
+	int M;
+	Uint8 Lut[256];	// each byte brightened
+} BlitBrightness;
+void BlitBrightnessInit(BlitBrightness *b, const int brightness);
+// Whether the brightness leaves the pixels unchanged
+bool BlitBrightnessIsIdentity(const BlitBrightness *b);
+
+typedef struct
+{
+	// Copy the source pixels that have any of the alpha bits set
+	void (*Transparent)(
+		Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask);
+	// Write the source pixels multiplied by the mask (see PixelMult);
+	// if transparent, zero source pixels are skipped
+	void (*Masked)(
+		Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+		const bool isTransparent);
+	// Tint the destination pixels; if transparent, only where the source
+	// pixels are non-zero
+	void (*Tint)(
+		Uint32 *dst, const Uint32 *src, const int n, const BlitTint *tint,
+		const bool isTransparent);
+	// Write the source pixels brightened
+	void (*Brighten)(
+		Uint32 *dst, const Uint32 *src, const int n, const BlitBrightness *b);
+	// Write each source pixel scale times in a row
+	void (*Stretch)(
+		Uint32 *dst, const Uint32 *src, const int n, const int scale);
+} BlitSpanFuncs;
+
+// The implementation in use; scalar until BlitSpanInit is called
+extern BlitSpanFuncs gBlitSpan;
+
+void BlitSpanInit(void);
+// NULL if the CPU or build doesn't support it
+const BlitSpanFuncs *BlitSpanGetFuncs(const BlitSpanImpl impl);
+
+#endif
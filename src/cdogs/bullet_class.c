@@ -56,6 +56,7 @@
 #include "game_events.h"
 #include "json_utils.h"
 #include "objs.h"
+#include "rng.h"
 #include "screen_shake.h"
 
 BulletClasses gBulletClasses;
@@ -92,7 +93,7 @@ BulletClass *StrBulletClass(const char *s)
 
 static CPicDrawContext GetBulletDrawContext(const int id)
 {
-	const TMobileObject *obj = CArrayGet(&gMobObjs, id);
+	const TMobileObject *obj = CPoolGet(&gMobObjs, id);
 	CASSERT(obj->isInUse, "Cannot draw non-existent mobobj");
 	// Calculate direction based on velocity
 	const direction_e dir = RadiansToDirection(Vec2iToRadians(obj->vel));
@@ -288,8 +289,8 @@ bool UpdateBullet(TMobileObject *obj, const int ticks)
 	{
 		for (int i = 0; i < ticks; i++)
 		{
-			obj->vel.x += ((rand() % 3) - 1) * 128;
-			obj->vel.y += ((rand() % 3) - 1) * 128;
+			obj->vel.x += RngRange(&gRngSim, -1, 2) * 128;
+			obj->vel.y += RngRange(&gRngSim, -1, 2) * 128;
 		}
 	}
 
@@ -310,7 +311,8 @@ bool UpdateBullet(TMobileObject *obj, const int ticks)
 				{
 					continue;
 				}
-				if (TileHasCharacter(MapGetTile(&gMap, dtv)))
+				const Tile t = MapGetTile(&gMap, dtv);
+				if (TileHasCharacter(&t))
 				{
 					FireGuns(obj, &obj->bulletClass->ProximityGuns);
 					return false;
@@ -589,7 +591,7 @@ void BulletClassesClear(CArray *classes)
 void BulletAdd(const AddBullet add)
 {
 	const Vec2i pos = add.MuzzlePos;
-	TMobileObject *obj = CArrayGet(
+	TMobileObject *obj = CPoolGet(
 		&gMobObjs, MobObjAdd(pos, add.PlayerIndex, add.UID));
 	obj->vel = GetFullVectorsForRadians(add.Angle);
 	obj->bulletClass = add.BulletClass;
@@ -601,8 +603,8 @@ void BulletAdd(const AddBullet add)
 	obj->tileItem.CPicFunc = GetBulletDrawContext;
 	obj->z = add.MuzzleHeight;
 	obj->dz = add.Elevation;
-	obj->range = RAND_INT(
-		obj->bulletClass->RangeLow, obj->bulletClass->RangeHigh);
+	obj->range = RngRange(
+		&gRngSim, obj->bulletClass->RangeLow, obj->bulletClass->RangeHigh);
 	obj->flags = add.Flags;
 	if (obj->bulletClass->HurtAlways)
 	{
@@ -610,7 +612,9 @@ void BulletAdd(const AddBullet add)
 	}
 	obj->vel = Vec2iFull2Real(Vec2iScale(
 		obj->vel,
-		RAND_INT(obj->bulletClass->SpeedLow, obj->bulletClass->SpeedHigh)));
+		RngRange(
+			&gRngSim,
+			obj->bulletClass->SpeedLow, obj->bulletClass->SpeedHigh)));
 	if (obj->bulletClass->SpeedScale)
 	{
 		obj->vel.y = obj->vel.y * TILE_HEIGHT / TILE_WIDTH;
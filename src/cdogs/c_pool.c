@@ -0,0 +1,130 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "c_pool.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+void CPoolInit(CPool *p, size_t elemSize)
+{
+	CArrayInit(&p->items, elemSize);
+	CArrayInit(&p->slots, sizeof(CPoolSlot));
+	CArrayInit(&p->live, sizeof(int));
+	p->freeHead = -1;
+}
+void CPoolReserve(CPool *p, size_t capacity)
+{
+	CArrayReserve(&p->items, capacity);
+	CArrayReserve(&p->slots, capacity);
+	CArrayReserve(&p->live, capacity);
+}
+void CPoolTerminate(CPool *p)
+{
+	CArrayTerminate(&p->items);
+	CArrayTerminate(&p->slots);
+	CArrayTerminate(&p->live);
+	p->freeHead = -1;
+}
+
+int CPoolAdd(CPool *p)
+{
+	CASSERT(p->items.elemSize > 0, "pool has not been initialised");
+	int id = p->freeHead;
+	if (id >= 0)
+	{
+		CPoolSlot *s = CArrayGet(&p->slots, id);
+		p->freeHead = s->next;
+	}
+	else
+	{
+		// No free slots; grow
+		CPoolSlot s;
+		memset(&s, 0, sizeof s);
+		CArrayPushBack(&p->slots, &s);
+		if (p->items.size == p->items.capacity)
+		{
+			CArrayReserve(&p->items, p->items.capacity * 2);
+		}
+		p->items.size++;
+		id = (int)p->slots.size - 1;
+	}
+	CPoolSlot *s = CArrayGet(&p->slots, id);
+	s->next = -1;
+	s->liveIndex = (int)p->live.size;
+	CArrayPushBack(&p->live, &id);
+	memset(CArrayGet(&p->items, id), 0, p->items.elemSize);
+	return id;
+}
+void CPoolRemove(CPool *p, int id)
+{
+	CASSERT(CPoolIsLive(p, id), "Removing free pool slot");
+	CPoolSlot *s = CArrayGet(&p->slots, id);
+	// Move the last live id into the removed one's place
+	const int lastId = *(int *)CArrayGet(&p->live, (int)p->live.size - 1);
+	*(int *)CArrayGet(&p->live, s->liveIndex) = lastId;
+	((CPoolSlot *)CArrayGet(&p->slots, lastId))->liveIndex = s->liveIndex;
+	p->live.size--;
+
+	s->liveIndex = -1;
+	s->generation++;
+	s->next = p->freeHead;
+	p->freeHead = id;
+}
+
+void *CPoolGet(const CPool *p, int id)
+{
+	return CArrayGet(&p->items, id);
+}
+bool CPoolIsLive(const CPool *p, int id)
+{
+	if (id < 0 || id >= (int)p->slots.size)
+	{
+		return false;
+	}
+	return ((const CPoolSlot *)CArrayGet(&p->slots, id))->liveIndex >= 0;
+}
+unsigned int CPoolGeneration(const CPool *p, int id)
+{
+	return ((const CPoolSlot *)CArrayGet(&p->slots, id))->generation;
+}
+
+int CPoolLiveCount(const CPool *p)
+{
+	return (int)p->live.size;
+}
+int CPoolLiveId(const CPool *p, int index)
+{
+	return *(int *)CArrayGet(&p->live, index);
+}
+int CPoolLiveIndex(const CPool *p, int id)
+{
+	return ((const CPoolSlot *)CArrayGet(&p->slots, id))->liveIndex;
+}
+void *CPoolGetLive(const CPool *p, int index)
+{
+	return CPoolGet(p, CPoolLiveId(p, index));
+}
@@ -0,0 +1,78 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __C_POOL
+#define __C_POOL
+
+#include <stdbool.h>
+
+#include "c_array.h"
+
+// Pool of reusable slots, for entities that are added and removed often.
+// Free slots form a linked list threaded through the slot metadata, so
+// adding and removing are O(1); live slots are also listed densely so that
+// update loops don't visit dead slots.
+// Element addresses are stable until the pool grows.
+// Each slot has a generation counter, incremented on removal, which can be
+// used to detect stale references to reused slots.
+typedef struct
+{
+	int next;	// next free slot, when free
+	int liveIndex;	// index into the live list, when in use
+	unsigned int generation;
+} CPoolSlot;
+
+typedef struct
+{
+	CArray items;	// of elements, indexed by slot id
+	CArray slots;	// of CPoolSlot
+	CArray live;	// of int; ids of the slots in use, in no particular order
+	int freeHead;	// first free slot id, or -1 if none
+} CPool;
+
+void CPoolInit(CPool *p, size_t elemSize);
+void CPoolReserve(CPool *p, size_t capacity);
+void CPoolTerminate(CPool *p);
+
+// Get a free slot, with its element zeroed, and return its id
+int CPoolAdd(CPool *p);
+void CPoolRemove(CPool *p, int id);
+
+void *CPoolGet(const CPool *p, int id);	// gets address
+bool CPoolIsLive(const CPool *p, int id);
+unsigned int CPoolGeneration(const CPool *p, int id);
+
+// Dense iteration over the slots in use:
+// for (int i = 0; i < CPoolLiveCount(p); i++) { T *t = CPoolGetLive(p, i); }
+// Removing a slot moves the last live slot into its place, so iterate
+// backwards if removing during iteration
+int CPoolLiveCount(const CPool *p);
+int CPoolLiveId(const CPool *p, int index);
+// Index of a slot in the live list, or -1 if free; the live index changes
+// when other slots are removed
+int CPoolLiveIndex(const CPool *p, int id);
+void *CPoolGetLive(const CPool *p, int index);
+
+#endif
@@ -35,6 +35,7 @@
 #include <cdogs/files.h>
 #include <cdogs/map_new.h>
 #include <cdogs/mission.h>
+#include <cdogs/rng.h>
 #include <cdogs/utils.h>
 
 
@@ -249,7 +250,7 @@ Mission *CampaignGetCurrentMission(CampaignOptions *campaign)
 
 void CampaignSeedRandom(CampaignOptions *campaign)
 {
-	srand(10 * campaign->MissionIndex + campaign->seed);
+	RngSeedAll(10 * campaign->MissionIndex + campaign->seed);
 }
 
 void CampaignAndMissionSetup(
@@ -31,6 +31,7 @@
 #include <assert.h>
 
 #include "actors.h"
+#include "rng.h"
 
 // Color range defines
 #define SKIN_START 2
@@ -205,9 +206,9 @@ Character *CharacterStoreGetSpecial(CharacterStore *store, int i)
 }
 Character *CharacterStoreGetRandomBaddie(CharacterStore *store)
 {
-	return store->baddies[rand() % store->baddieCount];
+	return store->baddies[RngInt(&gRngSim, store->baddieCount)];
 }
 Character *CharacterStoreGetRandomSpecial(CharacterStore *store)
 {
-	return store->specials[rand() % store->specialCount];
+	return store->specials[RngInt(&gRngSim, store->specialCount)];
 }
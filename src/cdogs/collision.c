@@ -77,6 +77,16 @@ bool IsCollisionWithWall(Vec2i pos, Vec2i size)
 	{
 		return true;
 	}
+	const Vec2i min = Vec2iNew(
+		(pos.x - size.x) / TILE_WIDTH, (pos.y - size.y) / TILE_HEIGHT);
+	const Vec2i max = Vec2iNew(
+		(pos.x + size.x) / TILE_WIDTH, (pos.y + size.y) / TILE_HEIGHT);
+	// If the box spans at most 2x2 tiles, the corners alone touch every
+	// tile in it, so test them all a word at a time
+	if (max.x - min.x <= 1 && max.y - min.y <= 1)
+	{
+		return BitGridAnyInRect(&gMap.NoWalk, min, max);
+	}
 	if (HitWall(pos.x - size.x,	pos.y - size.y) ||
 		HitWall(pos.x - size.x,	pos.y) ||
 		HitWall(pos.x - size.x,	pos.y + size.y) ||
@@ -103,116 +113,45 @@ bool IsCollisionWallOrEdge(Map *map, Vec2i pos, Vec2i size)
 	return IsCollisionWithWall(pos, size);
 }
 
-static bool ItemsCollide(
-	const TTileItem *item1, const TTileItem *item2, const Vec2i pos)
-{
-	int dx = abs(pos.x - item2->x);
-	int dy = abs(pos.y - item2->y);
-	int rx = item1->w + item2->w;
-	int ry = item1->h + item2->h;
-
-	if (dx < rx && dy < ry)
-	{
-		int odx = abs(item1->x - item2->x);
-		int ody = abs(item1->y - item2->y);
-
-		if (dx <= odx || dy <= ody)
-		{
-			return 1;
-		}
-	}
-	return 0;
-}
-
-bool CollisionIsOnSameTeam(
-	const TTileItem *i, const CollisionTeam team, const bool isDogfight)
-{
-	if (gConfig.Game.AllyCollision != ALLYCOLLISION_NORMAL)
-	{
-		CollisionTeam itemTeam = COLLISIONTEAM_NONE;
-		if (i->kind == KIND_CHARACTER)
-		{
-			TActor *a = CArrayGet(&gActors, i->id);
-			itemTeam = CalcCollisionTeam(1, a);
-		}
-		return
-			team != COLLISIONTEAM_NONE &&
-			itemTeam != COLLISIONTEAM_NONE &&
-			team == itemTeam &&
-			!isDogfight;
-	}
-	return 0;
-}
-
 TTileItem *GetItemOnTileInCollision(
 	TTileItem *item, Vec2i pos, int mask, CollisionTeam team, int isDogfight)
 {
-	const Vec2i tv = Vec2iToTile(pos);
-	Vec2i dv;
-	// Check collisions with all other items on this tile, in all 8 directions
-	for (dv.y = -1; dv.y <= 1; dv.y++)
-	{
-		for (dv.x = -1; dv.x <= 1; dv.x++)
-		{
-			const Vec2i dtv = Vec2iAdd(tv, dv);
-			if (!MapIsTileIn(&gMap, dtv))
-			{
-				continue;
-			}
-			CArray *tileThings = &MapGetTile(&gMap, dtv)->things;
-			for (int i = 0; i < (int)tileThings->size; i++)
-			{
-				TTileItem *ti = ThingIdGetTileItem(CArrayGet(tileThings, i));
-				// Don't collide if items are on the same team
-				if (!CollisionIsOnSameTeam(ti, team, isDogfight))
-				{
-					if (item != ti &&
-						(ti->flags & mask) &&
-						ItemsCollide(item, ti, pos))
-					{
-						return ti;
-					}
-				}
-			}
-		}
-	}
-
-	return NULL;
+	SpatialQuery q;
+	q.Item = item;
+	q.Pos = pos;
+	q.Mask = mask;
+	q.Team = team;
+	q.IsDogfight = isDogfight;
+	return SpatialHashGetFirst(&gMap.Broadphase, &q);
 }
+// Shared scratch space for collision results
+// Callbacks may collide recursively, so each call only uses the results
+// past what was there when it started
+static CArray sCollideResults;
 void CollideAllItems(
 	const TTileItem *item, const Vec2i pos,
 	const int mask, const CollisionTeam team, const bool isDogfight,
 	CollideItemFunc func, void *data)
 {
-	const Vec2i tv = Vec2iToTile(pos);
-	Vec2i dv;
-	// Check collisions with all other items on this tile, in all 8 directions
-	for (dv.y = -1; dv.y <= 1; dv.y++)
+	if (sCollideResults.elemSize == 0)
 	{
-		for (dv.x = -1; dv.x <= 1; dv.x++)
-		{
-			const Vec2i dtv = Vec2iAdd(tv, dv);
-			if (!MapIsTileIn(&gMap, dtv))
-			{
-				continue;
-			}
-			CArray *tileThings = &MapGetTile(&gMap, dtv)->things;
-			for (int i = 0; i < (int)tileThings->size; i++)
-			{
-				TTileItem *ti = ThingIdGetTileItem(CArrayGet(tileThings, i));
-				// Don't collide if items are on the same team
-				if (!CollisionIsOnSameTeam(ti, team, isDogfight))
-				{
-					if (item != ti &&
-						(ti->flags & mask) &&
-						ItemsCollide(item, ti, pos))
-					{
-						func(ti, data);
-					}
-				}
-			}
-		}
+		CArrayInit(&sCollideResults, sizeof(ThingId));
+	}
+	const size_t start = sCollideResults.size;
+	SpatialQuery q;
+	q.Item = item;
+	q.Pos = pos;
+	q.Mask = mask;
+	q.Team = team;
+	q.IsDogfight = isDogfight;
+	SpatialHashGetAll(&gMap.Broadphase, &q, &sCollideResults);
+	// Gather all the results first, so that callbacks can safely
+	// move or destroy things
+	for (int i = (int)start; i < (int)sCollideResults.size; i++)
+	{
+		func(ThingIdGetTileItem(CArrayGet(&sCollideResults, i)), data);
 	}
+	sCollideResults.size = start;
 }
 
 Vec2i GetWallBounceFullPos(
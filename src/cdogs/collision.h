@@ -51,29 +51,20 @@
 
 #include "actors.h"
 #include "map.h"
+#include "spatial_hash.h"
 
-#define HitWall(x, y) (MapGetTile(&gMap, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))->flags & MAPTILE_NO_WALK)
-#define ShootWall(x, y) (MapGetTile(&gMap, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))->flags & MAPTILE_NO_SHOOT)
-
-// Which "team" the actor's on, for collision
-// Actors on the same team don't have to collide
-typedef enum
-{
-	COLLISIONTEAM_NONE,
-	COLLISIONTEAM_GOOD,
-	COLLISIONTEAM_BAD
-} CollisionTeam;
+#define HitWall(x, y) BitGridGet(&gMap.NoWalk, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))
+#define ShootWall(x, y) BitGridGet(&gMap.NoShoot, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))
 
 CollisionTeam CalcCollisionTeam(int isActor, TActor *actor);
 
 bool IsCollisionWithWall(Vec2i pos, Vec2i size);
 // Check if colliding with a wall or the map edge
 bool IsCollisionWallOrEdge(Map *map, Vec2i pos, Vec2i size);
-bool CollisionIsOnSameTeam(
-	const TTileItem *i, const CollisionTeam team, const bool isDogfight);
 TTileItem *GetItemOnTileInCollision(
 	TTileItem *item, Vec2i pos, int mask, CollisionTeam team, int isDogfight);
 typedef void (*CollideItemFunc)(TTileItem *, void *);
+// Call func for every item in collision
 void CollideAllItems(
 	const TTileItem *item, const Vec2i pos,
 	const int mask, const CollisionTeam team, const bool isDogfight,
@@ -386,6 +386,8 @@ void ConfigLoadDefault(Config *config)
 	config->Game.AllyCollision = ALLYCOLLISION_REPEL;
 	config->Game.HealthPickups = true;
 	config->Game.Gore = GORE_LOW;
+	config->Game.AIThreads = 0;
+	config->Game.ActivityRange = 48;
 	config->Graphics.Brightness = 0;
 	config->Graphics.Fullscreen = 0;
 	config->Graphics.Res.y = 240;
@@ -393,6 +395,8 @@ void ConfigLoadDefault(Config *config)
 	config->Graphics.ScaleFactor = 2;
 	config->Graphics.ShakeMultiplier = 1;
 	config->Graphics.ScaleMode = SCALE_MODE_NN;
+	config->Graphics.ScaleThreads = 0;
+	config->Graphics.MaxFPS = 120;
 	config->Graphics.IsEditor = 0;
 	config->Input.PlayerKeys[0].Keys.left = SDLK_LEFT;
 	config->Input.PlayerKeys[0].Keys.right = SDLK_RIGHT;
@@ -99,6 +99,12 @@ typedef struct
 	AllyCollision AllyCollision;
 	bool HealthPickups;
 	GoreAmount Gore;
+	// Threads to run enemy AI on, or 0 for one per processor; results are
+	// the same for any number
+	int AIThreads;
+	// Distance from the players, in tiles, beyond which actors are
+	// simulated less often; 0 to simulate everything every tick
+	int ActivityRange;
 } GameConfig;
 
 typedef enum
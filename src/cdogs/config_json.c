@@ -66,6 +66,8 @@ static void LoadGameConfigNode(GameConfig *config, json_t *node)
 	LoadBool(&config->HealthPickups, node, "HealthPickups");
 	JSON_UTILS_LOAD_ENUM(
 		config->Gore, node, "Gore", StrGoreAmount);
+	LoadInt(&config->AIThreads, node, "AIThreads");
+	LoadInt(&config->ActivityRange, node, "ActivityRange");
 }
 static void AddGameConfigNode(GameConfig *config, json_t *root)
 {
@@ -100,6 +102,8 @@ static void AddGameConfigNode(GameConfig *config, json_t *root)
 	json_insert_pair_into_object(root, "Game", subConfig);
 	JSON_UTILS_ADD_ENUM_PAIR(
 		subConfig, "Gore", config->Gore, GoreAmountStr);
+	AddIntPair(subConfig, "AIThreads", config->AIThreads);
+	AddIntPair(subConfig, "ActivityRange", config->ActivityRange);
 }
 
 static void LoadGraphicsConfigNode(GraphicsConfig *config, json_t *node)
@@ -116,6 +120,8 @@ static void LoadGraphicsConfigNode(GraphicsConfig *config, json_t *node)
 	LoadInt(&config->ScaleFactor, node, "ScaleFactor");
 	LoadInt(&config->ShakeMultiplier, node, "ShakeMultiplier");
 	JSON_UTILS_LOAD_ENUM(config->ScaleMode, node, "ScaleMode", StrScaleMode);
+	LoadInt(&config->ScaleThreads, node, "ScaleThreads");
+	LoadInt(&config->MaxFPS, node, "MaxFPS");
 }
 static void AddGraphicsConfigNode(GraphicsConfig *config, json_t *root)
 {
@@ -128,6 +134,8 @@ static void AddGraphicsConfigNode(GraphicsConfig *config, json_t *root)
 	AddIntPair(subConfig, "ScaleFactor", config->ScaleFactor);
 	AddIntPair(subConfig, "ShakeMultiplier", config->ShakeMultiplier);
 	JSON_UTILS_ADD_ENUM_PAIR(subConfig, "ScaleMode", config->ScaleMode, ScaleModeStr);
+	AddIntPair(subConfig, "ScaleThreads", config->ScaleThreads);
+	AddIntPair(subConfig, "MaxFPS", config->MaxFPS);
 	json_insert_pair_into_object(root, "Graphics", subConfig);
 }
 
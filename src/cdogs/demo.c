@@ -0,0 +1,422 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "demo.h"
+
+#include <string.h>
+
+#include <SDL_endian.h>
+
+#include "config.h"
+#include "gamedata.h"
+#include "utils.h"
+
+Demo gDemo;
+
+#define DEMO_TAG_MISSION 'M'
+#define DEMO_TAG_TICKS 'T'
+
+#define DEMO_RUN_MAX 0xffff
+
+
+static void Write8(FILE *f, const int v)
+{
+	fputc(v & 0xff, f);
+}
+static void Write16(FILE *f, const int v)
+{
+	Uint16 n = SDL_SwapLE16((Uint16)v);
+	fwrite(&n, sizeof n, 1, f);
+}
+static void Write32(FILE *f, const int v)
+{
+	Uint32 n = SDL_SwapLE32((Uint32)v);
+	fwrite(&n, sizeof n, 1, f);
+}
+// Returns -1 at end of file
+static int Read8(FILE *f)
+{
+	const int c = fgetc(f);
+	return c == EOF ? -1 : c;
+}
+static int Read16(FILE *f)
+{
+	Uint16 n = 0;
+	fread(&n, sizeof n, 1, f);
+	return SDL_SwapLE16(n);
+}
+static int Read32(FILE *f)
+{
+	Uint32 n = 0;
+	fread(&n, sizeof n, 1, f);
+	return (int)SDL_SwapLE32(n);
+}
+
+
+bool DemoRecordStart(Demo *d, const char *filename)
+{
+	memset(d, 0, sizeof *d);
+	d->f = fopen(filename, "wb");
+	if (d->f == NULL)
+	{
+		printf("Error: cannot open demo file %s for writing\n", filename);
+		return false;
+	}
+	d->Mode = DEMO_MODE_RECORD;
+	return true;
+}
+
+static void ReadConfig(FILE *f);
+bool DemoReplayStart(Demo *d, const char *filename)
+{
+	memset(d, 0, sizeof *d);
+	d->f = fopen(filename, "rb");
+	if (d->f == NULL)
+	{
+		printf("Error: cannot open demo file %s\n", filename);
+		return false;
+	}
+	if ((Uint32)Read32(d->f) != DEMO_MAGIC)
+	{
+		printf("Error: %s is not a demo file\n", filename);
+		goto bail;
+	}
+	const int version = Read32(d->f);
+	if (version != DEMO_VERSION)
+	{
+		printf("Error: demo version %d not supported\n", version);
+		goto bail;
+	}
+	d->Entry.IsBuiltin = !!Read8(d->f);
+	d->Entry.Mode = (campaign_mode_e)Read8(d->f);
+	d->Entry.BuiltinIndex = Read32(d->f);
+	const int pathLen = Read16(d->f);
+	if (pathLen > 0)
+	{
+		CMALLOC(d->Entry.Path, pathLen + 1);
+		const size_t n = fread(d->Entry.Path, 1, pathLen, d->f);
+		d->Entry.Path[n] = '\0';
+	}
+	d->Seed = (unsigned int)Read32(d->f);
+	d->NumPlayers = Read8(d->f);
+	ReadConfig(d->f);
+	if (feof(d->f) || d->NumPlayers < 1 || d->NumPlayers > MAX_PLAYERS)
+	{
+		printf("Error: demo file %s is corrupt\n", filename);
+		goto bail;
+	}
+	d->HasHeader = true;
+	d->Mode = DEMO_MODE_REPLAY;
+	return true;
+
+bail:
+	DemoTerminate(d);
+	return false;
+}
+
+static void FlushTicks(Demo *d);
+void DemoTerminate(Demo *d)
+{
+	if (d->Mode == DEMO_MODE_RECORD)
+	{
+		FlushTicks(d);
+	}
+	if (d->f != NULL)
+	{
+		fclose(d->f);
+	}
+	CFREE(d->Entry.Path);
+	memset(d, 0, sizeof *d);
+}
+
+
+// Everything in the game config that changes how the game plays out;
+// cosmetic settings and the AI thread count are left out
+static void WriteConfig(FILE *f)
+{
+	const GameConfig *g = &gConfig.Game;
+	Write8(f, g->FriendlyFire);
+	Write8(f, g->Difficulty);
+	Write8(f, g->SlowMotion);
+	Write32(f, g->EnemyDensity);
+	Write32(f, g->NonPlayerHP);
+	Write32(f, g->PlayerHP);
+	Write8(f, g->Fog);
+	Write32(f, g->SightRange);
+	Write8(f, g->Shadows);
+	Write8(f, g->MoveWhenShooting);
+	Write8(f, g->SwitchMoveStyle);
+	Write8(f, g->ShotsPushback);
+	Write8(f, g->AllyCollision);
+	Write8(f, g->HealthPickups);
+	Write8(f, g->Gore);
+	Write32(f, g->ActivityRange);
+	// Split screen and the screen size decide when players get pulled
+	// back on screen
+	Write8(f, gConfig.Interface.Splitscreen);
+	Write16(f, gConfig.Graphics.Res.x);
+	Write16(f, gConfig.Graphics.Res.y);
+}
+static void ReadConfig(FILE *f)
+{
+	GameConfig *g = &gConfig.Game;
+	g->FriendlyFire = !!Read8(f);
+	g->Difficulty = (difficulty_e)Read8(f);
+	g->SlowMotion = !!Read8(f);
+	g->EnemyDensity = Read32(f);
+	g->NonPlayerHP = Read32(f);
+	g->PlayerHP = Read32(f);
+	g->Fog = !!Read8(f);
+	g->SightRange = Read32(f);
+	g->Shadows = !!Read8(f);
+	g->MoveWhenShooting = !!Read8(f);
+	g->SwitchMoveStyle = (SwitchMoveStyle)Read8(f);
+	g->ShotsPushback = !!Read8(f);
+	g->AllyCollision = (AllyCollision)Read8(f);
+	g->HealthPickups = !!Read8(f);
+	g->Gore = (GoreAmount)Read8(f);
+	g->ActivityRange = Read32(f);
+	gConfig.Interface.Splitscreen = (SplitscreenStyle)Read8(f);
+	gConfig.Graphics.Res.x = Read16(f);
+	gConfig.Graphics.Res.y = Read16(f);
+}
+
+static void WriteHeader(Demo *d, const CampaignOptions *co)
+{
+	Write32(d->f, DEMO_MAGIC);
+	Write32(d->f, DEMO_VERSION);
+	Write8(d->f, co->Entry.IsBuiltin);
+	Write8(d->f, co->Entry.Mode);
+	Write32(d->f, co->Entry.BuiltinIndex);
+	const int pathLen =
+		co->Entry.IsBuiltin || co->Entry.Path == NULL ?
+		0 : (int)strlen(co->Entry.Path);
+	Write16(d->f, pathLen);
+	fwrite(co->Entry.Path, 1, pathLen, d->f);
+	Write32(d->f, co->seed);
+	Write8(d->f, d->NumPlayers);
+	WriteConfig(d->f);
+	d->HasHeader = true;
+}
+
+void DemoRecordMission(
+	Demo *d, const CampaignOptions *co, const unsigned int gameSeed)
+{
+	if (d->Mode != DEMO_MODE_RECORD)
+	{
+		return;
+	}
+	if (co->Entry.Mode == CAMPAIGN_MODE_QUICK_PLAY)
+	{
+		// Quick play campaigns are generated randomly and not saved
+		printf("Warning: cannot record quick play games\n");
+		DemoTerminate(d);
+		return;
+	}
+	if (!d->HasHeader)
+	{
+		d->NumPlayers = gOptions.numPlayers;
+		WriteHeader(d, co);
+	}
+	FlushTicks(d);
+	Write8(d->f, DEMO_TAG_MISSION);
+	Write32(d->f, co->MissionIndex);
+	Write32(d->f, gameSeed);
+	for (int i = 0; i < d->NumPlayers; i++)
+	{
+		const struct PlayerData *p = &gPlayerDatas[i];
+		Write8(d->f, p->inputDevice);
+		Write8(d->f, p->weaponCount);
+		for (int j = 0; j < p->weaponCount; j++)
+		{
+			const int len = (int)MIN(strlen(p->weapons[j]->name), 0xff);
+			Write8(d->f, len);
+			fwrite(p->weapons[j]->name, 1, len, d->f);
+		}
+	}
+}
+
+static void FlushTicks(Demo *d)
+{
+	if (d->RunLength == 0)
+	{
+		return;
+	}
+	Write8(d->f, DEMO_TAG_TICKS);
+	Write16(d->f, d->RunLength);
+	for (int i = 0; i < d->NumPlayers; i++)
+	{
+		Write16(d->f, d->Cmds[i]);
+	}
+	d->RunLength = 0;
+}
+
+void DemoRecordTick(Demo *d, const int *cmds)
+{
+	if (d->Mode != DEMO_MODE_RECORD)
+	{
+		return;
+	}
+	// Commands rarely change from one tick to the next,
+	// so only write them out when they do
+	if (d->RunLength > 0 &&
+		(d->RunLength == DEMO_RUN_MAX ||
+		memcmp(d->Cmds, cmds, d->NumPlayers * sizeof *cmds) != 0))
+	{
+		FlushTicks(d);
+	}
+	if (d->RunLength == 0)
+	{
+		memcpy(d->Cmds, cmds, d->NumPlayers * sizeof *cmds);
+	}
+	d->RunLength++;
+}
+
+
+bool DemoReplayLoadCampaign(Demo *d, CampaignOptions *co)
+{
+	CampaignEntry entry;
+	if (d->Entry.IsBuiltin)
+	{
+		CampaignEntryInit(&entry, "Demo", d->Entry.Mode);
+		entry.IsBuiltin = true;
+		entry.BuiltinIndex = d->Entry.BuiltinIndex;
+	}
+	else if (d->Entry.Path == NULL ||
+		!CampaignEntryTryLoad(&entry, d->Entry.Path, d->Entry.Mode))
+	{
+		printf("Error: cannot load demo campaign %s\n",
+			d->Entry.Path != NULL ? d->Entry.Path : "");
+		return false;
+	}
+	CampaignLoad(co, &entry);
+	co->seed = d->Seed;
+	return co->IsLoaded;
+}
+
+static int ReadTag(Demo *d)
+{
+	if (d->NextTag != 0)
+	{
+		const int tag = d->NextTag;
+		d->NextTag = 0;
+		return tag;
+	}
+	return Read8(d->f);
+}
+
+bool DemoReplayMission(Demo *d, int *missionIndex, unsigned int *gameSeed)
+{
+	if (d->Mode != DEMO_MODE_REPLAY)
+	{
+		return false;
+	}
+	// Skip whatever is left of the last mission
+	int tag;
+	for (;;)
+	{
+		tag = ReadTag(d);
+		if (tag != DEMO_TAG_TICKS)
+		{
+			break;
+		}
+		Read16(d->f);
+		for (int i = 0; i < d->NumPlayers; i++)
+		{
+			Read16(d->f);
+		}
+	}
+	d->RunLength = 0;
+	if (tag != DEMO_TAG_MISSION)
+	{
+		return false;
+	}
+	*missionIndex = Read32(d->f);
+	*gameSeed = (unsigned int)Read32(d->f);
+	for (int i = 0; i < d->NumPlayers; i++)
+	{
+		struct PlayerData *p = &gPlayerDatas[i];
+		p->inputDevice = (input_device_e)Read8(d->f);
+		const int weaponCount = Read8(d->f);
+		if (weaponCount < 0 || weaponCount > MAX_WEAPONS)
+		{
+			goto bail;
+		}
+		p->weaponCount = weaponCount;
+		for (int j = 0; j < p->weaponCount; j++)
+		{
+			char name[256];
+			const int len = Read8(d->f);
+			if (len < 0 || fread(name, 1, len, d->f) != (size_t)len)
+			{
+				goto bail;
+			}
+			name[len] = '\0';
+			const GunDescription *gun = StrGunDescription(name);
+			if (gun == NULL)
+			{
+				printf("Error: demo uses unknown gun %s\n", name);
+				return false;
+			}
+			p->weapons[j] = gun;
+		}
+	}
+	if (feof(d->f))
+	{
+		goto bail;
+	}
+	return true;
+
+bail:
+	printf("Error: demo file is corrupt\n");
+	return false;
+}
+
+bool DemoReplayTick(Demo *d, int *cmds)
+{
+	if (d->RunLength == 0)
+	{
+		const int tag = ReadTag(d);
+		if (tag != DEMO_TAG_TICKS)
+		{
+			// Leave the next mission for DemoReplayMission
+			d->NextTag = tag == -1 ? 0 : tag;
+			return false;
+		}
+		d->RunLength = Read16(d->f);
+		for (int i = 0; i < d->NumPlayers; i++)
+		{
+			d->Cmds[i] = Read16(d->f);
+		}
+		if (feof(d->f))
+		{
+			d->RunLength = 0;
+			return false;
+		}
+	}
+	memcpy(cmds, d->Cmds, d->NumPlayers * sizeof *cmds);
+	d->RunLength--;
+	return true;
+}
@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __DEMO
+#define __DEMO
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "campaigns.h"
+
+/*
+Demo file format; integers are little-endian, sizes in bytes:
+- DEMO_MAGIC (4)
+- DEMO_VERSION (4)
+- IsBuiltin (1), Mode (1), BuiltinIndex (4)
+- Path length (2), Path (n); empty for builtin campaigns
+- Campaign seed (4)
+- Number of players (1)
+- Game config (see DemoWriteConfig)
+Followed by records, each starting with a one byte tag:
+- DEMO_TAG_MISSION: mission index (4), game seed (4), and for each player:
+  input device (1), weapon count (1), weapon names (1 + n each)
+- DEMO_TAG_TICKS: count (2), then one command per player (2 each);
+  the same commands were used for count sim ticks in a row
+*/
+#define DEMO_MAGIC 0x4f4d4544	// "DEMO"
+#define DEMO_VERSION 2
+
+typedef enum
+{
+	DEMO_MODE_NONE,
+	DEMO_MODE_RECORD,
+	DEMO_MODE_REPLAY
+} DemoMode;
+
+typedef struct
+{
+	DemoMode Mode;
+	FILE *f;
+	bool HasHeader;
+	int NumPlayers;
+	// Commands repeated since the last tick record was written or read
+	int Cmds[MAX_PLAYERS];
+	int RunLength;
+	// Tag read ahead while replaying, or 0
+	int NextTag;
+	// Campaign to replay
+	CampaignEntry Entry;
+	unsigned int Seed;
+} Demo;
+extern Demo gDemo;
+
+// Start recording to a file; the header is written with the first mission
+bool DemoRecordStart(Demo *d, const char *filename);
+// Open a demo for replay and read its header, applying its config
+bool DemoReplayStart(Demo *d, const char *filename);
+void DemoTerminate(Demo *d);
+
+// Record the start of a mission, after the players have been equipped
+void DemoRecordMission(
+	Demo *d, const CampaignOptions *co, const unsigned int gameSeed);
+// Record the commands sampled for one sim tick
+void DemoRecordTick(Demo *d, const int *cmds);
+
+// Load the campaign the demo was recorded with
+bool DemoReplayLoadCampaign(Demo *d, CampaignOptions *co);
+// Read the next mission, skipping any ticks left over from the last one,
+// and set up the players as they were recorded
+// Returns false at the end of the demo
+bool DemoReplayMission(Demo *d, int *missionIndex, unsigned int *gameSeed);
+// Read the commands for the next sim tick
+// Returns false when there are no more ticks for this mission
+bool DemoReplayTick(Demo *d, int *cmds);
+
+#endif
@@ -103,7 +103,9 @@ void FixBuffer(DrawBuffer *buffer)
 				if (mapTile.x >= 0 && mapTile.x < gMap.Size.x &&
 					mapTile.y >= 0 && mapTile.y < gMap.Size.y)
 				{
-					MapMarkAsVisited(&gMap, mapTile);
+					// Only for drawing; the game marks the map's visited
+					// tiles itself, so that replays don't depend on what
+					// was drawn
 					tile->flags &= ~MAPTILE_OUT_OF_SIGHT;
 					tile->isVisited = true;
 				}
@@ -179,8 +181,31 @@ void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra)
 	}
 }
 
+// Multiply a tile's area of the screen by a mask colour
+static void MaskTile(GraphicsDevice *g, const Vec2i pos, const color_t mask)
+{
+	const Uint32 maskPixel = PixelFromColor(g, mask);
+	const int left = MAX(pos.x, g->clipping.left);
+	const int right = MIN(pos.x + TILE_WIDTH - 1, g->clipping.right);
+	const int top = MAX(pos.y, g->clipping.top);
+	const int bottom = MIN(pos.y + TILE_HEIGHT - 1, g->clipping.bottom);
+	for (int y = top; y <= bottom; y++)
+	{
+		Uint32 *p = g->buf + y * g->cachedConfig.Res.x;
+		for (int x = left; x <= right; x++)
+		{
+			p[x] = PixelMult(p[x], maskPixel);
+		}
+	}
+}
 static void DrawFloor(DrawBuffer *b, Vec2i offset)
 {
+	// Copy the floor from the cache, then darken what's out of sight
+	FloorCacheDraw(
+		&b->Floor, &gMap, b->g,
+		Vec2iNew(b->xTop - offset.x, b->yTop - offset.y),
+		Vec2iNew(b->dx + offset.x, b->dy + offset.y),
+		Vec2iNew(b->Size.x * TILE_WIDTH, Y_TILES * TILE_HEIGHT));
 	int x, y;
 	Vec2i pos;
 	Tile *tile = &b->tiles[0][0];
@@ -195,12 +220,11 @@ static void DrawFloor(DrawBuffer *b, Vec2i offset)
 			if (tile->pic != NULL && PicIsNotNone(tile->pic) &&
 				!(tile->flags & MAPTILE_IS_WALL))
 			{
-				BlitMasked(
-					&gGraphicsDevice,
-					tile->pic,
-					pos,
-					GetTileLOSMask(tile),
-					0);
+				const color_t mask = GetTileLOSMask(tile);
+				if (!ColorEquals(mask, colorWhite))
+				{
+					MaskTile(b->g, pos, mask);
+				}
 			}
 		}
 		tile += X_TILES - b->Size.x;
@@ -219,10 +243,10 @@ static void DrawDebris(DrawBuffer *b, Vec2i offset)
 			{
 				continue;
 			}
-			for (int i = 0; i < (int)tile->things.size; i++)
+			for (int i = 0; i < (int)tile->things->size; i++)
 			{
 				TTileItem *ti =
-					ThingIdGetTileItem(CArrayGet(&tile->things, i));
+					ThingIdGetTileItem(CArrayGet(tile->things, i));
 				if (ti->flags & TILEITEM_IS_WRECK)
 				{
 					CArrayPushBack(&b->displaylist, &ti);
@@ -280,7 +304,7 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 				// Drawing doors
 				BlitMasked(
 					&gGraphicsDevice,
-					&tile->picAlt,
+					tile->picAlt,
 					pos,
 					GetTileLOSMask(tile),
 					0);
@@ -288,10 +312,10 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 			if (!(tile->flags & MAPTILE_OUT_OF_SIGHT))
 			{
 				// Draw the items that are in LOS
-				for (int i = 0; i < (int)tile->things.size; i++)
+				for (int i = 0; i < (int)tile->things->size; i++)
 				{
 					TTileItem *ti =
-						ThingIdGetTileItem(CArrayGet(&tile->things, i));
+						ThingIdGetTileItem(CArrayGet(tile->things, i));
 					if (!(ti->flags & TILEITEM_IS_WRECK))
 					{
 						CArrayPushBack(&b->displaylist, &ti);
@@ -425,10 +449,10 @@ static void DrawObjectiveHighlights(DrawBuffer *b, Vec2i offset)
 		for (int x = 0; x < b->Size.x; x++, tile++)
 		{
 			// Draw the items that are in LOS
-			for (int i = 0; i < (int)tile->things.size; i++)
+			for (int i = 0; i < (int)tile->things->size; i++)
 			{
 				TTileItem *ti =
-					ThingIdGetTileItem(CArrayGet(&tile->things, i));
+					ThingIdGetTileItem(CArrayGet(tile->things, i));
 				DrawObjectiveHighlight(ti, tile, b, offset);
 			}
 		}
@@ -50,7 +50,7 @@
 
 #include <assert.h>
 
-#include "algorithms.h"
+#include "visibility.h"
 
 
 void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g)
@@ -66,6 +66,7 @@ void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g)
 	b->g = g;
 	CArrayInit(&b->displaylist, sizeof(TTileItem *));
 	CArrayReserve(&b->displaylist, 32);
+	FloorCacheInit(&b->Floor);
 	debug(D_MAX, "Initialised draw buffer %dx%d\n", size.x, size.y);
 }
 void DrawBufferTerminate(DrawBuffer *b)
@@ -73,6 +74,7 @@ void DrawBufferTerminate(DrawBuffer *b)
 	CFREE(b->tiles[0]);
 	CFREE(b->tiles);
 	CArrayTerminate(&b->displaylist);
+	FloorCacheTerminate(&b->Floor);
 }
 
 void DrawBufferSetFromMap(
@@ -110,7 +112,7 @@ void DrawBufferSetFromMap(
 		{
 			if (x >= 0 && x < map->Size.x && y >= 0 && y < map->Size.y)
 			{
-				*bufTile = *MapGetTile(map, Vec2iNew(x, y));
+				*bufTile = MapGetTile(map, Vec2iNew(x, y));
 			}
 			else
 			{
@@ -131,146 +133,26 @@ static Tile *GetTile(DrawBuffer *buffer, Vec2i pos)
 	return &buffer->tiles[0][0] + pos.y * buffer->OrigSize.x + pos.x;
 }
 
-typedef struct
-{
-	DrawBuffer *b;
-	Vec2i center;
-	int sightRange2;
-} LOSData;
-static bool IsNextTileBlockedAndSetVisibility(void *data, Vec2i pos)
-{
-	LOSData *lData = data;
-	// Check sight range
-	if (lData->sightRange2 > 0 &&
-		DistanceSquared(lData->center, pos) >= lData->sightRange2)
-	{
-		return true;
-	}
-	// Check buffer range
-	Tile *tile = GetTile(lData->b, pos);
-	if (!tile)
-	{
-		return true;
-	}
-	tile->flags |= MAPTILE_IS_VISIBLE;
-	// Check if this tile is an obstruction
-	return tile->flags & MAPTILE_NO_SEE;
-}
-
-static bool IsTileVisibleNonObstruction(DrawBuffer *buffer, Vec2i pos)
-{
-	Tile *tile = GetTile(buffer, pos);
-	if (!tile)
-	{
-		return false;
-	}
-	return !(tile->flags & MAPTILE_NO_SEE) &&
-		(tile->flags & MAPTILE_IS_VISIBLE);
-}
-
-static void SetObstructionVisible(DrawBuffer *buffer, Vec2i pos, Tile *tile)
-{
-	Vec2i d;
-	for (d.x = -1; d.x < 2; d.x++)
-	{
-		for (d.y = -1; d.y < 2; d.y++)
-		{
-			if (IsTileVisibleNonObstruction(buffer, Vec2iAdd(pos, d)))
-			{
-				tile->flags |= MAPTILE_IS_VISIBLE;
-				return;
-			}
-		}
-	}
-}
-
-// Perform LOS by casting rays from the centre to the edges, terminating
-// whenever an obstruction or out-of-range is reached.
+// Mark the tiles in line of sight as visible, using the cached field of
+// view from the centre across the buffer
 void DrawBufferLOS(DrawBuffer *buffer, Vec2i center)
 {
-	int sightRange = gConfig.Game.SightRange;	// Note: can be zero
-	LOSData data;
-	data.b = buffer;
-	data.center.x = center.x / TILE_WIDTH - buffer->xStart;
-	data.center.y = center.y / TILE_HEIGHT - buffer->yStart;
-	data.sightRange2 = sightRange * sightRange;
+	const int sightRange = gConfig.Game.SightRange;	// Note: can be zero
+	const Vec2i viewer =
+		Vec2iNew(center.x / TILE_WIDTH, center.y / TILE_HEIGHT);
+	const Vec2i start = Vec2iNew(buffer->xStart, buffer->yStart);
+	const VisibilityView *view = VisibilityGet(
+		&gVisibility, &gMap, viewer, start, buffer->Size, sightRange);
 
-	// First mark center tile and all adjacent tiles as visible
-	// +-+-+-+
-	// |V|V|V|
-	// +-+-+-+
-	// |V|C|V|
-	// +-+-+-+
-	// |V|V|V|  (C=center, V=visible)
-	// +-+-+-+
-	Vec2i end;
-	for (end.x = data.center.x - 1; end.x < data.center.x + 2; end.x++)
+	Vec2i v;
+	for (v.y = 0; v.y < buffer->Size.y; v.y++)
 	{
-		for (end.y = data.center.y - 1; end.y < data.center.y + 2; end.y++)
+		for (v.x = 0; v.x < buffer->Size.x; v.x++)
 		{
-			Tile *tile = GetTile(buffer, end);
-			if (tile)
-			{
-				tile->flags |= MAPTILE_IS_VISIBLE;
-			}
-		}
-	}
-
-	// Work out the perimeter of the LOS casts
-	Vec2i origin = Vec2iZero();
-	if (sightRange > 0)
-	{
-		// Limit the perimeter to the sight range
-		origin.x = MAX(origin.x, data.center.x - sightRange);
-		origin.y = MAX(origin.y, data.center.y - sightRange);
-	}
-	Vec2i perimSize = Vec2iScale(Vec2iMinus(data.center, origin), 2);
-
-	// Start from the top-left cell, and proceed clockwise around
-	end = origin;
-	HasClearLineData lineData;
-	lineData.IsBlocked = IsNextTileBlockedAndSetVisibility;
-	lineData.data = &data;
-	// Top edge
-	for (; end.x < origin.x + perimSize.x; end.x++)
-	{
-		HasClearLineXiaolinWu(data.center, end, &lineData);
-	}
-	// right edge
-	for (; end.y < origin.y + perimSize.y; end.y++)
-	{
-		HasClearLineXiaolinWu(data.center, end, &lineData);
-	}
-	// bottom edge
-	for (; end.x > origin.x; end.x--)
-	{
-		HasClearLineXiaolinWu(data.center, end, &lineData);
-	}
-	// left edge
-	for (; end.y > origin.y; end.y--)
-	{
-		HasClearLineXiaolinWu(data.center, end, &lineData);
-	}
-
-	// Second pass: make any non-visible obstructions that are adjacent to
-	// visible non-obstructions visible too
-	// This is to ensure runs of walls stay visible
-	for (end.y = origin.y; end.y < origin.y + perimSize.y; end.y++)
-	{
-		for (end.x = origin.x; end.x < origin.x + perimSize.x; end.x++)
-		{
-			Tile *tile = GetTile(buffer, end);
-			if (!tile || !(tile->flags & MAPTILE_NO_SEE))
-			{
-				continue;
-			}
-			// Check sight range
-			if (data.sightRange2 > 0 &&
-				DistanceSquared(data.center, end) >= data.sightRange2)
+			if (VisibilityViewIsVisible(view, Vec2iAdd(v, start)))
 			{
-				continue;
+				GetTile(buffer, v)->flags |= MAPTILE_IS_VISIBLE;
 			}
-			SetObstructionVisible(buffer, end, tile);
 		}
 	}
 }
@@ -49,6 +49,7 @@
 #ifndef __DRAW_BUFFER
 #define __DRAW_BUFFER
 
+#include "floor_cache.h"
 #include "map.h"
 
 typedef struct
@@ -61,6 +62,7 @@ typedef struct
 	Vec2i Size;	// size in tiles
 	Tile **tiles;
 	CArray displaylist;	// of TTileItem *, to determine draw order
+	FloorCache Floor;
 } DrawBuffer;
 
 void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g);
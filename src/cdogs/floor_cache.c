@@ -0,0 +1,220 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "floor_cache.h"
+
+#include <string.h>
+
+#include "blit.h"
+#include "utils.h"
+
+#define CHUNK_W (MAP_PICS_CHUNK * TILE_WIDTH)
+#define CHUNK_H (MAP_PICS_CHUNK * TILE_HEIGHT)
+
+
+void FloorCacheInit(FloorCache *c)
+{
+	memset(c, 0, sizeof *c);
+	CArrayInit(&c->Chunks, sizeof(FloorCacheChunk));
+}
+static void FreeChunks(FloorCache *c)
+{
+	for (int i = 0; i < (int)c->Chunks.size; i++)
+	{
+		FloorCacheChunk *ch = CArrayGet(&c->Chunks, i);
+		CFREE(ch->Pixels);
+	}
+	CArrayClear(&c->Chunks);
+}
+void FloorCacheTerminate(FloorCache *c)
+{
+	FreeChunks(c);
+	CArrayTerminate(&c->Chunks);
+}
+
+bool FloorCacheIsTileDrawn(Map *map, const Vec2i tile)
+{
+	if (!MapIsTileIn(map, tile))
+	{
+		return false;
+	}
+	Pic *pic = MapGetTilePics(map, tile)->pic;
+	const int flags = MapGetTileFlags(map, tile);
+	if (pic == NULL || !PicIsNotNone(pic) || (flags & MAPTILE_IS_WALL))
+	{
+		return false;
+	}
+	const int flagsBelow =
+		MapGetTileFlags(map, Vec2iNew(tile.x, tile.y + 1));
+	return (flags & MAPTILE_OFFSET_PIC) || !(flagsBelow & MAPTILE_IS_WALL);
+}
+
+// Draw a pic into a chunk, as a masked blit would
+static void DrawChunkPic(
+	Uint32 *pixels, const Pic *pic, const Vec2i pos, const Uint32 mask,
+	const bool isTransparent)
+{
+	const int left = MAX(0, -pos.x);
+	const int right = MIN(pic->size.x, CHUNK_W - pos.x);
+	const int top = MAX(0, -pos.y);
+	const int bottom = MIN(pic->size.y, CHUNK_H - pos.y);
+	for (int y = top; y < bottom; y++)
+	{
+		const Uint32 *src = pic->Data + y * pic->size.x;
+		Uint32 *dst = pixels + (pos.y + y) * CHUNK_W + pos.x;
+		for (int x = left; x < right; x++)
+		{
+			if (isTransparent && src[x] == 0)
+			{
+				continue;
+			}
+			dst[x] = PixelMult(src[x], mask);
+		}
+	}
+}
+static void DrawChunk(
+	FloorCacheChunk *ch, Map *map, GraphicsDevice *g, const Vec2i chunk)
+{
+	if (ch->Pixels == NULL)
+	{
+		CMALLOC(ch->Pixels, CHUNK_W * CHUNK_H * sizeof *ch->Pixels);
+	}
+	// Undrawn parts are left as they would be on the cleared screen
+	const Uint32 black = PixelFromColor(g, colorBlack);
+	for (int i = 0; i < CHUNK_W * CHUNK_H; i++)
+	{
+		ch->Pixels[i] = black;
+	}
+	const Uint32 white = PixelFromColor(g, colorWhite);
+	const Vec2i origin = Vec2iScale(chunk, MAP_PICS_CHUNK);
+	// Include the tiles just outside the chunk, in case their pics
+	// overhang, and draw in the same order as the screen is drawn
+	Vec2i v;
+	for (v.y = origin.y - 1; v.y <= origin.y + MAP_PICS_CHUNK; v.y++)
+	{
+		for (v.x = origin.x - 1; v.x <= origin.x + MAP_PICS_CHUNK; v.x++)
+		{
+			if (!FloorCacheIsTileDrawn(map, v))
+			{
+				continue;
+			}
+			const Pic *pic = MapGetTilePics(map, v)->pic;
+			const Vec2i pos = Vec2iNew(
+				(v.x - origin.x) * TILE_WIDTH + pic->offset.x,
+				(v.y - origin.y) * TILE_HEIGHT + pic->offset.y);
+			DrawChunkPic(ch->Pixels, pic, pos, white, false);
+		}
+	}
+	ch->Revision = MapGetPicsRevision(map, chunk);
+	ch->NumDecals = 0;
+}
+static void DrawChunkDecals(
+	FloorCacheChunk *ch, Map *map, GraphicsDevice *g, const Vec2i chunk)
+{
+	const CArray *decals = MapGetDecals(map, chunk);
+	const Vec2i origin = Vec2iNew(chunk.x * CHUNK_W, chunk.y * CHUNK_H);
+	for (; ch->NumDecals < (int)decals->size; ch->NumDecals++)
+	{
+		const MapDecal *d = CArrayGet(decals, ch->NumDecals);
+		DrawChunkPic(
+			ch->Pixels, d->Pic, Vec2iMinus(d->Pos, origin),
+			PixelFromColor(g, d->Mask), true);
+	}
+}
+
+void FloorCacheDraw(
+	FloorCache *c, Map *map, GraphicsDevice *g,
+	const Vec2i mapOffset, const Vec2i screenPos, const Vec2i screenSize)
+{
+	const Vec2i chunks = MapGetPicsChunks(map);
+	if (!Vec2iEqual(chunks, c->Size))
+	{
+		FreeChunks(c);
+		c->Size = chunks;
+		FloorCacheChunk ch;
+		memset(&ch, 0, sizeof ch);
+		for (int i = 0; i < chunks.x * chunks.y; i++)
+		{
+			CArrayPushBack(&c->Chunks, &ch);
+		}
+	}
+
+	// Fill the given area, within the clipping and the map
+	const int left = MAX(MAX(g->clipping.left, screenPos.x), -mapOffset.x);
+	const int right = MIN(
+		MIN(g->clipping.right, screenPos.x + screenSize.x - 1),
+		map->Size.x * TILE_WIDTH - 1 - mapOffset.x);
+	const int top = MAX(MAX(g->clipping.top, screenPos.y), -mapOffset.y);
+	const int bottom = MIN(
+		MIN(g->clipping.bottom, screenPos.y + screenSize.y - 1),
+		map->Size.y * TILE_HEIGHT - 1 - mapOffset.y);
+	if (left > right || top > bottom)
+	{
+		return;
+	}
+
+	// Bring the chunks in view up to date
+	Vec2i v;
+	for (v.y = (top + mapOffset.y) / CHUNK_H;
+		v.y <= (bottom + mapOffset.y) / CHUNK_H;
+		v.y++)
+	{
+		for (v.x = (left + mapOffset.x) / CHUNK_W;
+			v.x <= (right + mapOffset.x) / CHUNK_W;
+			v.x++)
+		{
+			FloorCacheChunk *ch =
+				CArrayGet(&c->Chunks, v.y * c->Size.x + v.x);
+			if (ch->Pixels == NULL ||
+				ch->Revision != MapGetPicsRevision(map, v))
+			{
+				DrawChunk(ch, map, g, v);
+			}
+			DrawChunkDecals(ch, map, g, v);
+		}
+	}
+
+	// Copy a row at a time, a span per chunk
+	const int stride = g->cachedConfig.Res.x;
+	for (int y = top; y <= bottom; y++)
+	{
+		const int mapY = y + mapOffset.y;
+		const int chunkY = mapY / CHUNK_H;
+		const int row = mapY % CHUNK_H;
+		for (int x = left; x <= right;)
+		{
+			const int mapX = x + mapOffset.x;
+			const int col = mapX % CHUNK_W;
+			const int n = MIN(right - x + 1, CHUNK_W - col);
+			const FloorCacheChunk *ch = CArrayGet(
+				&c->Chunks, chunkY * c->Size.x + mapX / CHUNK_W);
+			memcpy(
+				g->buf + y * stride + x,
+				ch->Pixels + row * CHUNK_W + col,
+				n * sizeof *g->buf);
+			x += n;
+		}
+	}
+}
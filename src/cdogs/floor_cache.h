@@ -0,0 +1,68 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __FLOOR_CACHE
+#define __FLOOR_CACHE
+
+#include "c_array.h"
+#include "grafx.h"
+#include "map.h"
+
+// The map's floor tiles, drawn once into off-screen chunks of
+// MAP_PICS_CHUNK tiles, so that each frame the visible part can be copied
+// a row at a time instead of blitting every tile.
+// Chunks are drawn when first needed, and redrawn when the map says their
+// tiles have changed (see MapMarkTilePicsChanged).
+// Walls aren't cached as they are drawn in order with the things around
+// them.
+// The map's decals are drawn on top; new ones are added to the chunk as
+// they are stamped.
+typedef struct
+{
+	Uint32 *Pixels;	// NULL until first drawn
+	int Revision;	// of the map chunk when drawn
+	int NumDecals;	// drawn so far
+} FloorCacheChunk;
+
+typedef struct
+{
+	Vec2i Size;	// in chunks
+	CArray Chunks;	// of FloorCacheChunk
+} FloorCache;
+
+void FloorCacheInit(FloorCache *c);
+void FloorCacheTerminate(FloorCache *c);
+
+// Whether a tile has its floor drawn; the tile above a wall is covered
+// by the wall, and is left out
+bool FloorCacheIsTileDrawn(Map *map, const Vec2i tile);
+
+// Copy the floor to the screen, within the blit clipping and the given
+// screen area. mapOffset is the map position of the screen's top left.
+void FloorCacheDraw(
+	FloorCache *c, Map *map, GraphicsDevice *g,
+	const Vec2i mapOffset, const Vec2i screenPos, const Vec2i screenSize);
+
+#endif
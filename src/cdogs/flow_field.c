@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "flow_field.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+
+void FlowFieldInit(FlowField *f, Vec2i size)
+{
+	memset(f, 0, sizeof *f);
+	f->Size = size;
+	CArrayInit(&f->Cells, sizeof(FlowFieldCell));
+	CArrayReserve(&f->Cells, size.x * size.y);
+	FlowFieldCell c;
+	c.Dist = -1;
+	c.Next = -1;
+	for (int i = 0; i < size.x * size.y; i++)
+	{
+		CArrayPushBack(&f->Cells, &c);
+	}
+	CArrayInit(&f->Queue, sizeof(int));
+	CArrayReserve(&f->Queue, size.x * size.y);
+	FlowFieldReset(f);
+}
+void FlowFieldTerminate(FlowField *f)
+{
+	CArrayTerminate(&f->Cells);
+	CArrayTerminate(&f->Queue);
+	memset(f, 0, sizeof *f);
+}
+void FlowFieldReset(FlowField *f)
+{
+	f->Target = Vec2iNew(-1, -1);
+}
+
+static bool IsIn(const FlowField *f, const Vec2i v)
+{
+	return v.x >= 0 && v.x < f->Size.x && v.y >= 0 && v.y < f->Size.y;
+}
+static FlowFieldCell *GetCell(const FlowField *f, const int index)
+{
+	return CArrayGet(&f->Cells, index);
+}
+
+// Axis-aligned neighbours first, so that ties prefer straight moves
+static const Vec2i sNeighbors[] =
+{
+	{ 0, -1 }, { -1, 0 }, { 1, 0 }, { 0, 1 },
+	{ -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }
+};
+#define NUM_NEIGHBORS ((int)(sizeof sNeighbors / sizeof sNeighbors[0]))
+bool FlowFieldUpdate(
+	FlowField *f, const Vec2i target, const int revision,
+	FlowFieldTileFunc isTileOk, void *data)
+{
+	if (Vec2iEqual(f->Target, target) && f->Revision == revision)
+	{
+		return false;
+	}
+	f->Target = target;
+	f->Revision = revision;
+	for (int i = 0; i < (int)f->Cells.size; i++)
+	{
+		FlowFieldCell *c = GetCell(f, i);
+		c->Dist = -1;
+		c->Next = -1;
+	}
+	if (!IsIn(f, target))
+	{
+		return true;
+	}
+
+	// Breadth-first search outwards from the target; each tile's next step
+	// is the tile it was reached from
+	CArrayClear(&f->Queue);
+	const int targetIndex = target.y * f->Size.x + target.x;
+	GetCell(f, targetIndex)->Dist = 0;
+	CArrayPushBack(&f->Queue, &targetIndex);
+	for (int q = 0; q < (int)f->Queue.size; q++)
+	{
+		const int index = *(int *)CArrayGet(&f->Queue, q);
+		const Vec2i v = Vec2iNew(index % f->Size.x, index / f->Size.x);
+		const int dist = GetCell(f, index)->Dist;
+		for (int i = 0; i < NUM_NEIGHBORS; i++)
+		{
+			const Vec2i n = Vec2iAdd(v, sNeighbors[i]);
+			if (!IsIn(f, n))
+			{
+				continue;
+			}
+			const int nIndex = n.y * f->Size.x + n.x;
+			FlowFieldCell *c = GetCell(f, nIndex);
+			if (c->Dist >= 0)
+			{
+				continue;
+			}
+			if (!isTileOk(data, n) ||
+				!isTileOk(data, Vec2iNew(v.x, n.y)) ||
+				!isTileOk(data, Vec2iNew(n.x, v.y)))
+			{
+				continue;
+			}
+			c->Dist = dist + 1;
+			c->Next = index;
+			CArrayPushBack(&f->Queue, &nIndex);
+		}
+	}
+	return true;
+}
+
+bool FlowFieldIsValid(const FlowField *f)
+{
+	return IsIn(f, f->Target);
+}
+bool FlowFieldGetNext(const FlowField *f, const Vec2i tile, Vec2i *next)
+{
+	if (!FlowFieldIsValid(f) || !IsIn(f, tile))
+	{
+		return false;
+	}
+	const int nextIndex = GetCell(f, tile.y * f->Size.x + tile.x)->Next;
+	if (nextIndex < 0)
+	{
+		return false;
+	}
+	*next = Vec2iNew(nextIndex % f->Size.x, nextIndex / f->Size.x);
+	return true;
+}
+int FlowFieldGetDistance(const FlowField *f, const Vec2i tile)
+{
+	if (!FlowFieldIsValid(f) || !IsIn(f, tile))
+	{
+		return -1;
+	}
+	return GetCell(f, tile.y * f->Size.x + tile.x)->Dist;
+}
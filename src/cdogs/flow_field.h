@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __FLOW_FIELD
+#define __FLOW_FIELD
+
+#include <stdbool.h>
+
+#include "c_array.h"
+#include "vector.h"
+
+// A field over the tile grid giving, for every tile, the next tile to move
+// to in order to reach a target tile by the fewest steps.
+// One field can be shared by any number of movers heading to the same
+// target, each reading its next step in constant time; the field is only
+// recomputed when the target changes tile or walkability changes.
+// Movement is in 8 directions; diagonal moves require both adjacent
+// axis-aligned tiles to be walkable as well.
+typedef struct
+{
+	int Dist;	// steps to the target, or -1 if unreachable
+	int Next;	// tile index of the next step, or -1 if none
+} FlowFieldCell;
+typedef struct
+{
+	Vec2i Size;
+	Vec2i Target;	// tile; -1,-1 if the field isn't computed
+	int Revision;	// walkability revision the field was computed for
+	CArray Cells;	// of FlowFieldCell
+	CArray Queue;	// of int; scratch for computing the field
+} FlowField;
+
+typedef bool (*FlowFieldTileFunc)(void *data, Vec2i tile);
+
+void FlowFieldInit(FlowField *f, Vec2i size);
+void FlowFieldTerminate(FlowField *f);
+// Mark the field as out of date, e.g. when its target has gone away
+void FlowFieldReset(FlowField *f);
+
+// Recompute the field, if the target tile or walkability revision has
+// changed since the last time it was computed
+// Returns whether the field was recomputed
+bool FlowFieldUpdate(
+	FlowField *f, const Vec2i target, const int revision,
+	FlowFieldTileFunc isTileOk, void *data);
+
+bool FlowFieldIsValid(const FlowField *f);
+// Get the next tile to move to from a tile
+// Returns false if the target is unreachable, or if already at the target
+bool FlowFieldGetNext(const FlowField *f, const Vec2i tile, Vec2i *next);
+// Number of steps from a tile to the target, or -1 if unreachable
+int FlowFieldGetDistance(const FlowField *f, const Vec2i tile);
+
+#endif
@@ -32,28 +32,111 @@
 
 #include "utils.h"
 
-CArray gGameEvents;
+GameEventStore gGameEvents;
 
-void GameEventsInit(CArray *store)
+// Payloads contain pointers and doubles; keep them aligned
+#define PAYLOAD_ALIGN 8
+#define PAYLOAD_SIZE(_member) sizeof(((GameEvent *)NULL)->u._member)
+
+static size_t GameEventPayloadSize(const GameEventType type)
 {
-	CArrayInit(store, sizeof(GameEvent));
+	switch (type)
+	{
+	case GAME_EVENT_SCORE:
+		return PAYLOAD_SIZE(Score);
+	case GAME_EVENT_SOUND_AT:
+		return PAYLOAD_SIZE(SoundAt);
+	case GAME_EVENT_SCREEN_SHAKE:
+		return PAYLOAD_SIZE(ShakeAmount);
+	case GAME_EVENT_SET_MESSAGE:
+		return PAYLOAD_SIZE(SetMessage);
+	case GAME_EVENT_ADD_HEALTH_PICKUP:
+		return PAYLOAD_SIZE(AddPos);
+	case GAME_EVENT_TAKE_HEALTH_PICKUP:
+		return PAYLOAD_SIZE(PickupPlayer);
+	case GAME_EVENT_MOBILE_OBJECT_REMOVE:
+		return PAYLOAD_SIZE(MobileObjectRemove);
+	case GAME_EVENT_PARTICLE_REMOVE:
+		return PAYLOAD_SIZE(ParticleRemove);
+	case GAME_EVENT_ADD_BULLET:
+		return PAYLOAD_SIZE(AddBullet);
+	case GAME_EVENT_ADD_PARTICLE:
+		return PAYLOAD_SIZE(AddParticle);
+	case GAME_EVENT_HIT_CHARACTER:
+		return PAYLOAD_SIZE(HitCharacter);
+	case GAME_EVENT_ACTOR_IMPULSE:
+		return PAYLOAD_SIZE(ActorImpulse);
+	case GAME_EVENT_DAMAGE_CHARACTER:
+		return PAYLOAD_SIZE(DamageCharacter);
+	case GAME_EVENT_TRIGGER:
+		return PAYLOAD_SIZE(Trigger);
+	case GAME_EVENT_UPDATE_OBJECTIVE:
+		return PAYLOAD_SIZE(UpdateObjective);
+	default:
+		// Events with no payload
+		return 0;
+	}
 }
-void GameEventsTerminate(CArray *store)
+
+void GameEventsInit(GameEventStore *store)
 {
-	CArrayTerminate(store);
+	CArrayInit(&store->Headers, sizeof(GameEventHeader));
+	CArrayInit(&store->Payloads, sizeof(char));
 }
-void GameEventsEnqueue(CArray *store, GameEvent e)
+void GameEventsTerminate(GameEventStore *store)
+{
+	CArrayTerminate(&store->Headers);
+	CArrayTerminate(&store->Payloads);
+}
+void GameEventsEnqueue(GameEventStore *store, GameEvent e)
 {
 	// Hack: sometimes trigger events are added by placing enemies
 	// before the game events has been initialised
 	// Just ignore for now
-	if (store->elemSize == 0)
+	if (store->Headers.elemSize == 0)
 	{
 		return;
 	}
-	CArrayPushBack(store, &e);
+	GameEventHeader h;
+	h.Type = e.Type;
+	h.Offset = (int)store->Payloads.size;
+	h.Offset = (h.Offset + PAYLOAD_ALIGN - 1) / PAYLOAD_ALIGN * PAYLOAD_ALIGN;
+	const size_t size = GameEventPayloadSize(e.Type);
+	const size_t end = h.Offset + size;
+	if (end > store->Payloads.capacity)
+	{
+		CArrayReserve(&store->Payloads, MAX(end, store->Payloads.capacity * 2));
+	}
+	store->Payloads.size = end;
+	memcpy((char *)store->Payloads.data + h.Offset, &e.u, size);
+	CArrayPushBack(&store->Headers, &h);
+}
+void GameEventsClear(GameEventStore *store)
+{
+	CArrayClear(&store->Headers);
+	CArrayClear(&store->Payloads);
+}
+
+int GameEventsCount(const GameEventStore *store)
+{
+	return (int)store->Headers.size;
+}
+GameEventType GameEventsType(const GameEventStore *store, int index)
+{
+	return ((const GameEventHeader *)CArrayGet(
+		&store->Headers, index))->Type;
+}
+const void *GameEventsPayload(const GameEventStore *store, int index)
+{
+	const GameEventHeader *h = CArrayGet(&store->Headers, index);
+	// Note: events without payloads may be at the end of the arena
+	return (const char *)store->Payloads.data + h->Offset;
 }
-void GameEventsClear(CArray *store)
+void GameEventsGet(const GameEventStore *store, int index, GameEvent *e)
 {
-	CArrayClear(store);
+	e->Type = GameEventsType(store, index);
+	memcpy(
+		&e->u,
+		GameEventsPayload(store, index),
+		GameEventPayloadSize(e->Type));
 }
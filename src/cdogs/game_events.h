@@ -71,6 +71,18 @@ typedef enum
 	GAME_EVENT_MISSION_END
 } GameEventType;
 
+typedef struct
+{
+	Mix_Chunk *Sound;
+	Vec2i Pos;
+} SoundAt;
+// Removals carry the pool slot's generation as of when they were queued,
+// so that they don't remove whatever has reused the slot since
+typedef struct
+{
+	int Id;
+	unsigned int Generation;
+} PoolRemove;
 typedef struct
 {
 	GameEventType Type;
@@ -81,11 +93,7 @@ typedef struct
 			int PlayerIndex;
 			int Score;
 		} Score;
-		struct
-		{
-			Mix_Chunk *Sound;
-			Vec2i Pos;
-		} SoundAt;
+		SoundAt SoundAt;
 		int ShakeAmount;
 		struct
 		{
@@ -94,8 +102,8 @@ typedef struct
 		} SetMessage;
 		Vec2i AddPos;
 		int PickupPlayer;
-		int MobileObjectRemoveId;
-		int ParticleRemoveId;
+		PoolRemove MobileObjectRemove;
+		PoolRemove ParticleRemove;
 		AddBullet AddBullet;
 		AddParticle AddParticle;
 		struct
@@ -130,11 +138,34 @@ typedef struct
 	} u;
 } GameEvent;
 
-extern CArray gGameEvents;	// of GameEvent
+// Queued events are stored as a small header, plus a payload holding only
+// the union member used by that event type, packed into a byte arena.
+// This keeps the common small events (sounds, particles, removals) cheap
+// to queue regardless of the size of the largest event.
+typedef struct
+{
+	GameEventType Type;
+	int Offset;	// of the payload in the arena
+} GameEventHeader;
+typedef struct
+{
+	CArray Headers;	// of GameEventHeader, in the order queued
+	CArray Payloads;	// of char
+} GameEventStore;
+
+extern GameEventStore gGameEvents;
+
+void GameEventsInit(GameEventStore *store);
+void GameEventsTerminate(GameEventStore *store);
+void GameEventsEnqueue(GameEventStore *store, GameEvent e);
+void GameEventsClear(GameEventStore *store);
 
-void GameEventsInit(CArray *store);
-void GameEventsTerminate(CArray *store);
-void GameEventsEnqueue(CArray *store, GameEvent e);
-void GameEventsClear(CArray *store);
+int GameEventsCount(const GameEventStore *store);
+GameEventType GameEventsType(const GameEventStore *store, int index);
+// Address of the payload of a queued event, i.e. its union member
+// Only valid until the next event is queued
+const void *GameEventsPayload(const GameEventStore *store, int index);
+// Copy out a queued event; only the union member for its type is set
+void GameEventsGet(const GameEventStore *store, int index, GameEvent *e);
 
 #endif
@@ -189,6 +189,7 @@ void GraphicsInit(GraphicsDevice *device)
 	device->buf = NULL;
 	device->bkg = NULL;
 	hqxInit();
+	BlitSpanInit();
 }
 
 void AddSupportedModesForBPP(GraphicsDevice *device, int bpp)
@@ -355,6 +356,7 @@ void GraphicsInitialize(
 void GraphicsTerminate(GraphicsDevice *device)
 {
 	debug(D_NORMAL, "Shutting down video...\n");
+	BlitFlipTerminate();
 	SDL_FreeSurface(device->icon);
 	SDL_FreeSurface(device->screen);
 	SDL_VideoQuit();
@@ -74,6 +74,10 @@ typedef struct
 	int ScaleFactor;
 	int ShakeMultiplier;
 	ScaleMode ScaleMode;
+	// Threads to brighten and scale the screen on; 0 for one per processor
+	int ScaleThreads;
+	// Frames drawn per second at most, or 0 for no limit
+	int MaxFPS;
 
 	int IsEditor;
 } GraphicsConfig;
@@ -101,7 +101,7 @@ static bool TryPlacePickup(HealthPickups *h)
 	for (int i = 0; i < 100; i++)
 	{
 		const Vec2i v = MapGenerateFreePosition(h->map, size);
-		if (!Vec2iIsZero(v) && !MapGetTile(h->map, Vec2iToTile(v))->isVisited)
+		if (!Vec2iIsZero(v) && MapTileIsUnexplored(h->map, Vec2iToTile(v)))
 		{
 			MapPlaceHealth(v);
 			return true;
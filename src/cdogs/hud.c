@@ -569,11 +569,10 @@ static void DrawObjectiveCompass(
 	{
 		for (tilePos.x = 0; tilePos.x < map->Size.x; tilePos.x++)
 		{
-			Tile *tile = MapGetTile(map, tilePos);
-			for (int i = 0; i < (int)tile->things.size; i++)
+			const CArray *things = MapGetTileThings(map, tilePos);
+			for (int i = 0; i < (int)things->size; i++)
 			{
-				TTileItem *ti =
-					ThingIdGetTileItem(CArrayGet(&tile->things, i));
+				TTileItem *ti = ThingIdGetTileItem(CArrayGet(things, i));
 				if (!(ti->flags & TILEITEM_OBJECTIVE))
 				{
 					continue;
@@ -586,7 +585,7 @@ static void DrawObjectiveCompass(
 					continue;
 				}
 				if (!(mo->Flags & OBJECTIVE_POSKNOWN) &&
-					!tile->isVisited)
+					MapTileIsUnexplored(map, tilePos))
 				{
 					continue;
 				}
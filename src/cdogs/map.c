@@ -58,6 +58,7 @@
 #include "map_classic.h"
 #include "map_static.h"
 #include "pic_manager.h"
+#include "rng.h"
 #include "objs.h"
 #include "triggers.h"
 #include "sounds.h"
@@ -74,6 +75,9 @@
 
 Map gMap;
 
+// Last tile pics revision handed out; see MapMarkTilePicsChanged
+static int sPicsRevision = 0;
+
 
 const char *IMapTypeStr(IMapType t)
 {
@@ -110,13 +114,85 @@ unsigned short GetAccessMask(int k)
 	return MAP_ACCESS_YELLOW << k;
 }
 
-Tile *MapGetTile(Map *map, Vec2i pos)
+static int TileIndex(const Map *map, const Vec2i pos)
 {
-	if (pos.x < 0 || pos.x >= map->Size.x || pos.y < 0 || pos.y >= map->Size.y)
+	return pos.y * map->Size.x + pos.x;
+}
+Tile MapGetTile(Map *map, Vec2i pos)
+{
+	if (!MapIsTileIn(map, pos))
+	{
+		return TileNone();
+	}
+	const int idx = TileIndex(map, pos);
+	const TilePics *pics = CArrayGet(&map->TilePics, idx);
+	Tile t;
+	t.pic = pics->pic;
+	t.picAlt = &pics->picAlt;
+	t.flags = *(unsigned short *)CArrayGet(&map->TileFlags, idx);
+	t.isVisited = BitGridGet(&map->Visited, pos);
+	t.things = CArrayGet(&map->TileThings, idx);
+	return t;
+}
+int MapGetTileFlags(const Map *map, const Vec2i pos)
+{
+	if (!MapIsTileIn(map, pos))
+	{
+		return TileNone().flags;
+	}
+	return *(unsigned short *)CArrayGet(&map->TileFlags, TileIndex(map, pos));
+}
+TilePics *MapGetTilePics(Map *map, const Vec2i pos)
+{
+	if (!MapIsTileIn(map, pos))
 	{
 		return NULL;
 	}
-	return CArrayGet(&map->Tiles, pos.y * map->Size.x + pos.x);
+	return CArrayGet(&map->TilePics, TileIndex(map, pos));
+}
+const CArray *MapGetTileThings(const Map *map, const Vec2i pos)
+{
+	if (!MapIsTileIn(map, pos))
+	{
+		return TileNone().things;
+	}
+	return CArrayGet(&map->TileThings, TileIndex(map, pos));
+}
+// Find where a tile's triggers are or would be in the sorted trigger table
+static int FindTileTriggers(const Map *map, const int idx)
+{
+	int lo = 0;
+	int hi = (int)map->TileTriggers.size;
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) / 2;
+		const TileTriggers *tt = CArrayGet(&map->TileTriggers, mid);
+		if (tt->Index < idx)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+const CArray *MapGetTileTriggers(const Map *map, const Vec2i pos)
+{
+	static CArray noTriggers;
+	if (!MapIsTileIn(map, pos))
+	{
+		return &noTriggers;
+	}
+	const int idx = TileIndex(map, pos);
+	const int i = FindTileTriggers(map, idx);
+	if (i == (int)map->TileTriggers.size)
+	{
+		return &noTriggers;
+	}
+	const TileTriggers *tt = CArrayGet(&map->TileTriggers, i);
+	return tt->Index == idx ? &tt->Triggers : &noTriggers;
 }
 
 bool MapIsTileIn(const Map *map, const Vec2i pos)
@@ -144,13 +220,13 @@ bool MapIsTileInExit(Map *map, TTileItem *tile)
 		tile->y / TILE_HEIGHT <= map->ExitEnd.y;
 }
 
-static Tile *MapGetTileOfItem(Map *map, TTileItem *t)
+static CArray *MapGetThingsOfItem(Map *map, TTileItem *t)
 {
 	Vec2i pos = Vec2iToTile(Vec2iNew(t->x, t->y));
-	return MapGetTile(map, pos);
+	return CArrayGet(&map->TileThings, TileIndex(map, pos));
 }
 
-static void AddItemToTile(TTileItem *t, Tile *tile);
+static void AddItemToTile(TTileItem *t, CArray *things);
 bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos)
 {
 	// Check if we can move to new position
@@ -167,6 +243,7 @@ bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos)
 	{
 		t->x = pos.x;
 		t->y = pos.y;
+		SpatialHashUpdate(&map->Broadphase, t);
 		return true;
 	}
 	// Moving; remove from old tile...
@@ -175,24 +252,31 @@ bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos)
 		MapRemoveTileItem(map, t);
 	}
 	// ...move and add to new tile
+	if (!doRemove)
+	{
+		// Newly placed; don't interpolate from the old position
+		t->LastPos = pos;
+	}
 	t->x = pos.x;
 	t->y = pos.y;
-	AddItemToTile(t, MapGetTile(map, t2));
+	AddItemToTile(t, CArrayGet(&map->TileThings, TileIndex(map, t2)));
+	SpatialHashAdd(&map->Broadphase, t);
 	return true;
 }
-static void AddItemToTile(TTileItem *t, Tile *tile)
+static void AddItemToTile(TTileItem *t, CArray *things)
 {
 	// Lazy initialisation
-	if (tile->things.elemSize == 0)
+	if (things->elemSize == 0)
 	{
-		CArrayInit(&tile->things, sizeof(ThingId));
+		CArrayInit(things, sizeof(ThingId));
 	}
 	ThingId tid;
 	tid.Id = t->id;
 	tid.Kind = t->kind;
 	CASSERT(tid.Id >= 0, "invalid ThingId");
 	CASSERT(tid.Kind >= 0 && tid.Kind <= KIND_OBJECT, "unknown thing kind");
-	CArrayPushBack(&tile->things, &tid);
+	t->ThingIndex = (int)things->size;
+	CArrayPushBack(things, &tid);
 }
 
 void MapRemoveTileItem(Map *map, TTileItem *t)
@@ -201,29 +285,48 @@ void MapRemoveTileItem(Map *map, TTileItem *t)
 	{
 		return;
 	}
-	Tile *tile = MapGetTileOfItem(map, t);
-	for (int i = 0; i < (int)tile->things.size; i++)
-	{
-		ThingId *tid = CArrayGet(&tile->things, i);
-		if (tid->Id == t->id && tid->Kind == t->kind)
-		{
-			CArrayDelete(&tile->things, i);
-			return;
-		}
-	}
-	CASSERT(false, "Did not find element to delete");
+	SpatialHashRemove(&map->Broadphase, t);
+	CArray *things = MapGetThingsOfItem(map, t);
+	const int i = t->ThingIndex;
+	CASSERT(i >= 0 && i < (int)things->size, "Did not find element to delete");
+	ThingId *tid = CArrayGet(things, i);
+	CASSERT(
+		tid->Id == t->id && tid->Kind == t->kind,
+		"Did not find element to delete");
+	// Swap the last thing into the removed one's place; this avoids
+	// shifting the list, which matters for fast bullets that change
+	// tiles almost every tick
+	const int last = (int)things->size - 1;
+	if (i != last)
+	{
+		*tid = *(ThingId *)CArrayGet(things, last);
+		ThingIdGetTileItem(tid)->ThingIndex = i;
+	}
+	CArrayDelete(things, last);
+	t->ThingIndex = -1;
 }
 
+void MapUpdateTileItem(Map *map, TTileItem *t)
+{
+	SpatialHashUpdate(&map->Broadphase, t);
+}
+
+// Draw x before y; the order of evaluating arguments is unspecified,
+// and the same seed must give the same map on every platform
 static Vec2i GuessCoords(Map *map)
 {
-	return Vec2iNew(rand() % map->Size.x, rand() % map->Size.y);
+	Vec2i v;
+	v.x = RngInt(&gRngMap, map->Size.x);
+	v.y = RngInt(&gRngMap, map->Size.y);
+	return v;
 }
 
-static Vec2i GuessPixelCoords(Map *map)
+static Vec2i GuessPixelCoords(Map *map, Rng *rng)
 {
-	return Vec2iNew(
-		rand() % (map->Size.x * TILE_WIDTH),
-		rand() % (map->Size.y * TILE_HEIGHT));
+	Vec2i v;
+	v.x = RngInt(rng, map->Size.x * TILE_WIDTH);
+	v.y = RngInt(rng, map->Size.y * TILE_HEIGHT);
+	return v;
 }
 
 unsigned short IMapGet(Map *map, Vec2i pos)
@@ -246,9 +349,18 @@ static void PicLoadOffset(Pic *picAlt, int idx)
 		PicManagerGetFromOld(&gPicManager, cGeneralPics[idx].picIndex);
 	picAlt->size = oldPic->size;
 	picAlt->Data = oldPic->Data;
+	picAlt->Spans = oldPic->Spans;
+	picAlt->RowSpans = oldPic->RowSpans;
 	picAlt->offset = Vec2iNew(cGeneralPics[idx].dx, cGeneralPics[idx].dy);
 }
 
+static void SetAlternateFloor(Map *map, const Vec2i pos, Pic *p)
+{
+	MapGetTilePics(map, pos)->pic = p;
+	MapSetTileFlags(
+		map, pos, MapGetTileFlags(map, pos) & ~MAPTILE_IS_NORMAL_FLOOR);
+}
+
 static void MapSetupTilesAndWalls(Map *map, Mission *m)
 {
 	Vec2i v;
@@ -264,14 +376,14 @@ static void MapSetupTilesAndWalls(Map *map, Mission *m)
 	for (int i = 0; i < 50; i++)
 	{
 		// Make sure drain tiles aren't next to each other
-		Tile *t = MapGetTile(map, Vec2iNew(
-			(rand() % map->Size.x) & 0xFFFFFE,
-			(rand() % map->Size.y) & 0xFFFFFE));
-		if (TileIsNormalFloor(t))
+		v = GuessCoords(map);
+		v = Vec2iNew(v.x & 0xFFFFFE, v.y & 0xFFFFFE);
+		if (MapGetTileFlags(map, v) & MAPTILE_IS_NORMAL_FLOOR)
 		{
-			TileSetAlternateFloor(t, PicManagerGetFromOld(
+			SetAlternateFloor(map, v, PicManagerGetFromOld(
 				&gPicManager, PIC_DRAINAGE));
-			t->flags |= MAPTILE_IS_DRAINAGE;
+			MapSetTileFlags(
+				map, v, MapGetTileFlags(map, v) | MAPTILE_IS_DRAINAGE);
 		}
 	}
 
@@ -279,21 +391,19 @@ static void MapSetupTilesAndWalls(Map *map, Mission *m)
 	// Randomly change normal floor tiles to alternative floor tiles
 	for (int i = 0; i < 100; i++)
 	{
-		Tile *t = MapGetTile(
-			map, Vec2iNew(rand() % map->Size.x, rand() % map->Size.y));
-		if (TileIsNormalFloor(t))
+		v = GuessCoords(map);
+		if (MapGetTileFlags(map, v) & MAPTILE_IS_NORMAL_FLOOR)
 		{
-			TileSetAlternateFloor(t, PicManagerGetFromOld(
+			SetAlternateFloor(map, v, PicManagerGetFromOld(
 				&gPicManager, cFloorPics[floor][FLOOR_1]));
 		}
 	}
 	for (int i = 0; i < 150; i++)
 	{
-		Tile *t = MapGetTile(
-			map, Vec2iNew(rand() % map->Size.x, rand() % map->Size.y));
-		if (TileIsNormalFloor(t))
+		v = GuessCoords(map);
+		if (MapGetTileFlags(map, v) & MAPTILE_IS_NORMAL_FLOOR)
 		{
-			TileSetAlternateFloor(t, PicManagerGetFromOld(
+			SetAlternateFloor(map, v, PicManagerGetFromOld(
 				&gPicManager, cFloorPics[floor][FLOOR_2]));
 		}
 	}
@@ -301,13 +411,13 @@ static void MapSetupTilesAndWalls(Map *map, Mission *m)
 
 void MapChangeFloor(Map *map, Vec2i pos, Pic *normal, Pic *shadow)
 {
-	Tile *tAbove = MapGetTile(map, Vec2iNew(pos.x, pos.y - 1));
-	int canSeeTileAbove = !(pos.y > 0 && !TileCanSee(tAbove));
-	Tile *t = MapGetTile(map, pos);
-	if (t->flags & MAPTILE_IS_DRAINAGE)
+	const int flagsAbove = MapGetTileFlags(map, Vec2iNew(pos.x, pos.y - 1));
+	int canSeeTileAbove = !(pos.y > 0 && (flagsAbove & MAPTILE_NO_SEE));
+	if (MapGetTileFlags(map, pos) & MAPTILE_IS_DRAINAGE)
 	{
 		return;
 	}
+	TilePics *t = MapGetTilePics(map, pos);
 	switch (IMapGet(map, pos) & MAP_MASKACCESS)
 	{
 	case MAP_FLOOR:
@@ -326,6 +436,7 @@ void MapChangeFloor(Map *map, Vec2i pos, Pic *normal, Pic *shadow)
 		// do nothing
 		break;
 	}
+	MapMarkTilePicsChanged(map, pos);
 }
 
 void MapShowExitArea(Map *map)
@@ -374,19 +485,19 @@ static int MapGetNumWallsAdjacentTile(Map *map, Vec2i v)
 	int count = 0;
 	if (v.x > 0 && v.y > 0 && v.x < map->Size.x - 1 && v.y < map->Size.y - 1)
 	{
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x - 1, v.y))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x - 1, v.y)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x + 1, v.y))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x + 1, v.y)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x, v.y - 1))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x, v.y - 1)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x, v.y + 1))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x, v.y + 1)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
@@ -401,19 +512,19 @@ static int MapGetNumWallsAroundTile(Map *map, Vec2i v)
 	if (v.x > 0 && v.y > 0 && v.x < map->Size.x - 1 && v.y < map->Size.y - 1)
 	{
 		// Having checked the adjacencies, check the diagonals
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x - 1, v.y - 1))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x - 1, v.y - 1)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x + 1, v.y + 1))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x + 1, v.y + 1)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x + 1, v.y - 1))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x + 1, v.y - 1)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
-		if (!TileCanWalk(MapGetTile(map, Vec2iNew(v.x - 1, v.y + 1))))
+		if ((MapGetTileFlags(map, Vec2iNew(v.x - 1, v.y + 1)) & MAPTILE_NO_WALK))
 		{
 			count++;
 		}
@@ -428,10 +539,10 @@ int MapTryPlaceOneObject(
 	int oFlags = 0;
 	Vec2i realPos = Vec2iCenterOfTile(v);
 	int tileFlags = 0;
-	Tile *t = MapGetTile(map, v);
+	const Tile t = MapGetTile(map, v);
 	unsigned short iMap = IMapGet(map, v);
 
-	bool isEmpty = !(t->flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(t);
+	bool isEmpty = !(t.flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(&t);
 	if (isStrictMode && !MapObjectIsTileOKStrict(
 			mo, iMap, isEmpty,
 			IMapGet(map, Vec2iNew(v.x, v.y - 1)),
@@ -494,19 +605,34 @@ int MapTryPlaceOneObject(
 
 void MapPlaceWreck(Map *map, Vec2i v, MapObject *mo)
 {
-	Tile *t = MapGetTile(map, v);
+	const Tile t = MapGetTile(map, v);
 	unsigned short iMap = IMapGet(map, v);
-	bool isEmpty = !(t->flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(t);
+	bool isEmpty = !(t.flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(&t);
 	if (!MapObjectIsTileOK(
 		mo, iMap, isEmpty, IMapGet(map, Vec2iNew(v.x, v.y - 1))))
 	{
 		return;
 	}
-	ObjAddDestructible(
-		Vec2iCenterOfTile(v), Vec2iNew(mo->width, mo->height),
-		&cGeneralPics[mo->wreckedPic], &cGeneralPics[mo->wreckedPic],
-		mo->picName,
-		0, 0, TILEITEM_IS_WRECK);
+	// Keep the pic map-placed wrecks had as tile items: the object's
+	// new-style pic if it has one, placed with the wrecked pic's offset
+	const TOffsetPic *ofpic = &cGeneralPics[mo->wreckedPic];
+	const Pic *pic = NULL;
+	if (mo->picName != NULL && mo->picName[0] != '\0')
+	{
+		pic = PicManagerGetPic(&gPicManager, mo->picName);
+	}
+	if (pic == NULL)
+	{
+		pic = PicManagerGetFromOld(&gPicManager, ofpic->picIndex);
+	}
+	if (pic == NULL)
+	{
+		return;
+	}
+	const Vec2i pos = Vec2iAdd(
+		Vec2iCenterOfTile(v),
+		Vec2iAdd(Vec2iNew(ofpic->dx, ofpic->dy), pic->offset));
+	MapAddDecal(map, pic, pos, colorWhite);
 }
 
 int MapHasLockedRooms(Map *map)
@@ -544,7 +670,7 @@ static int MapTryPlaceCollectible(
 
 	while (i)
 	{
-		Vec2i v = GuessPixelCoords(map);
+		Vec2i v = GuessPixelCoords(map, &gRngMap);
 		Vec2i size = Vec2iNew(COLLECTABLE_W, COLLECTABLE_H);
 		if (!IsCollisionWithWall(v, size))
 		{
@@ -572,7 +698,7 @@ Vec2i MapGenerateFreePosition(Map *map, Vec2i size)
 {
 	for (int i = 0; i < 100; i++)
 	{
-		Vec2i v = GuessPixelCoords(map);
+		Vec2i v = GuessPixelCoords(map, &gRngSim);
 		if (!IsCollisionWithWall(v, size))
 		{
 			return v;
@@ -629,16 +755,13 @@ static void MapPlaceCard(Map *map, int keyIndex, int map_access)
 	for (;;)
 	{
 		Vec2i v = GuessCoords(map);
-		Tile *t;
-		Tile *tBelow;
-		unsigned short iMap;
-		t = MapGetTile(map, v);
-		iMap = IMapGet(map, v);
-		tBelow = MapGetTile(map, Vec2iNew(v.x, v.y + 1));
-		if (!(t->flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(t) &&
+		const Tile t = MapGetTile(map, v);
+		const unsigned short iMap = IMapGet(map, v);
+		const Tile tBelow = MapGetTile(map, Vec2iNew(v.x, v.y + 1));
+		if (!(t.flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(&t) &&
 			(iMap & 0xF00) == map_access &&
 			(iMap & MAP_MASKACCESS) == MAP_ROOM &&
-			!(tBelow->flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(tBelow))
+			!(tBelow.flags & ~MAPTILE_IS_NORMAL_FLOOR) && TileIsClear(&tBelow))
 		{
 			MapPlaceKey(map, &gMission, v, keyIndex);
 			return;
@@ -759,13 +882,24 @@ static Trigger *MapNewTrigger(Map *map)
 	t->id = map->triggerId++;
 	return t;
 }
-static void TileAddTrigger(Tile *t, Trigger *tr)
+static void MapAddTileTrigger(Map *map, const Vec2i pos, Trigger *tr)
 {
-	if (t->triggers.elemSize == 0)
+	const int idx = TileIndex(map, pos);
+	const int i = FindTileTriggers(map, idx);
+	TileTriggers *tt = NULL;
+	if (i < (int)map->TileTriggers.size)
 	{
-		CArrayInit(&t->triggers, sizeof(Trigger *));
+		tt = CArrayGet(&map->TileTriggers, i);
 	}
-	CArrayPushBack(&t->triggers, &tr);
+	if (tt == NULL || tt->Index != idx)
+	{
+		TileTriggers newTT;
+		newTT.Index = idx;
+		CArrayInit(&newTT.Triggers, sizeof(Trigger *));
+		CArrayInsert(&map->TileTriggers, i, &newTT);
+		tt = CArrayGet(&map->TileTriggers, i);
+	}
+	CArrayPushBack(&tt->Triggers, &tr);
 }
 static Trigger *CreateOpenDoorTrigger(
 	Map *map, Vec2i v,
@@ -851,9 +985,9 @@ static Trigger *CreateOpenDoorTrigger(
 	{
 		Vec2i vI = Vec2iNew(v.x + dv.x * i, v.y + dv.y * i);
 		Vec2i vAside = Vec2iNew(vI.x - dAside.x, vI.y - dAside.y);
-		TileAddTrigger(MapGetTile(map, vAside), t);
+		MapAddTileTrigger(map, vAside, t);
 		vAside = Vec2iNew(vI.x + dAside.x, vI.y + dAside.y);
-		TileAddTrigger(MapGetTile(map, vAside), t);
+		MapAddTileTrigger(map, vAside, t);
 	}
 
 	return t;
@@ -911,19 +1045,20 @@ static void MapAddDoorGroup(Map *map, Vec2i v, int floor, int room, int flags)
 	for (int i = 0; i < doorGroupCount; i++)
 	{
 		Vec2i vI = Vec2iNew(v.x + dv.x * i, v.y + dv.y * i);
-		Tile *tile = MapGetTile(map, vI);
+		TilePics *tile = MapGetTilePics(map, vI);
 		PicLoadOffset(&tile->picAlt, pic);
 		tile->pic = PicManagerGetFromOld(
 			&gPicManager, cRoomPics[room][ROOMFLOOR_SHADOW]);
-		tile->flags = tileFlags;
+		MapSetTileFlags(map, vI, tileFlags);
 		if (isHorizontal)
 		{
 			Vec2i vB = Vec2iNew(vI.x + dAside.x, vI.y + dAside.y);
-			Tile *tileB = MapGetTile(map, vB);
-			assert(TileCanWalk(MapGetTile(
-				map, Vec2iNew(vI.x - dAside.x, vI.y - dAside.y))) &&
+			TilePics *tileB = MapGetTilePics(map, vB);
+			assert(!(MapGetTileFlags(
+				map, Vec2iNew(vI.x - dAside.x, vI.y - dAside.y)) &
+				MAPTILE_NO_WALK) &&
 				"map gen error: entrance should be clear");
-			assert(TileCanWalk(tileB) &&
+			assert(!(MapGetTileFlags(map, vB) & MAPTILE_NO_WALK) &&
 				"map gen error: entrance should be clear");
 			// Change the tile below to shadow, cast by this door
 			if (IMapGet(map, vB) == MAP_FLOOR)
@@ -1045,32 +1180,63 @@ static void MapSetupPerimeter(Map *map)
 	}
 }
 
+static void UpdateFlagPlanes(Map *map, const Vec2i pos, const int flags)
+{
+	BitGridSet(&map->NoWalk, pos, flags & MAPTILE_NO_WALK);
+	BitGridSet(&map->NoShoot, pos, flags & MAPTILE_NO_SHOOT);
+	BitGridSet(&map->NoSee, pos, flags & MAPTILE_NO_SEE);
+}
+
 void MapInit(Map *map)
 {
 	memset(map, 0, sizeof *map);
-	CArrayInit(&map->Tiles, sizeof(Tile));
+	CArrayInit(&map->TileFlags, sizeof(unsigned short));
+	CArrayInit(&map->TilePics, sizeof(TilePics));
+	CArrayInit(&map->PicsRevisions, sizeof(int));
+	CArrayInit(&map->Decals, sizeof(CArray));
+	CArrayInit(&map->TileThings, sizeof(CArray));
+	CArrayInit(&map->TileTriggers, sizeof(TileTriggers));
 	CArrayInit(&map->iMap, sizeof(unsigned short));
 	CArrayInit(&map->triggers, sizeof(Trigger *));
 }
 void MapTerminate(Map *map)
 {
-	Vec2i v;
 	int i;
 	for (i = 0; i < (int)map->triggers.size; i++)
 	{
 		TriggerTerminate(*(Trigger **)CArrayGet(&map->triggers, i));
 	}
 	CArrayTerminate(&map->triggers);
-	for (v.y = 0; v.y < map->Size.y; v.y++)
+	for (i = 0; i < (int)map->TileThings.size; i++)
 	{
-		for (v.x = 0; v.x < map->Size.x; v.x++)
+		CArray *things = CArrayGet(&map->TileThings, i);
+		if (things->elemSize > 0)
 		{
-			Tile *t = MapGetTile(map, v);
-			TileDestroy(t);
+			CArrayTerminate(things);
 		}
 	}
-	CArrayTerminate(&map->Tiles);
+	CArrayTerminate(&map->TileThings);
+	for (i = 0; i < (int)map->TileTriggers.size; i++)
+	{
+		TileTriggers *tt = CArrayGet(&map->TileTriggers, i);
+		CArrayTerminate(&tt->Triggers);
+	}
+	CArrayTerminate(&map->TileTriggers);
+	CArrayTerminate(&map->TileFlags);
+	CArrayTerminate(&map->TilePics);
+	CArrayTerminate(&map->PicsRevisions);
+	for (i = 0; i < (int)map->Decals.size; i++)
+	{
+		CArrayTerminate(CArrayGet(&map->Decals, i));
+	}
+	CArrayTerminate(&map->Decals);
+	BitGridTerminate(&map->Visited);
 	CArrayTerminate(&map->iMap);
+	SpatialHashTerminate(&map->Broadphase);
+	RoomGraphTerminate(&map->RoomGraph);
+	BitGridTerminate(&map->NoWalk);
+	BitGridTerminate(&map->NoShoot);
+	BitGridTerminate(&map->NoSee);
 }
 void MapLoad(Map *map, struct MissionOptions *mo, CharacterStore *store)
 {
@@ -1084,14 +1250,35 @@ void MapLoad(Map *map, struct MissionOptions *mo, CharacterStore *store)
 	MapTerminate(map);
 	MapInit(map);
 	map->Size = mission->Size;
+	SpatialHashInit(&map->Broadphase, map->Size);
+	// Wrecks are stamped as decals while the map is being built
+	const Vec2i chunks = MapGetPicsChunks(map);
+	for (i = 0; i < chunks.x * chunks.y; i++)
+	{
+		CArray decals;
+		CArrayInit(&decals, sizeof(MapDecal));
+		CArrayPushBack(&map->Decals, &decals);
+	}
+	RoomGraphInit(&map->RoomGraph);
+	BitGridInit(&map->NoWalk, map->Size);
+	BitGridInit(&map->NoShoot, map->Size);
+	BitGridInit(&map->NoSee, map->Size);
+	BitGridInit(&map->Visited, map->Size);
 	for (v.y = 0; v.y < map->Size.y; v.y++)
 	{
 		for (v.x = 0; v.x < map->Size.x; v.x++)
 		{
-			Tile t;
+			const unsigned short flags = 0;
+			CArrayPushBack(&map->TileFlags, &flags);
+			TilePics pics;
+			TilePicsInit(&pics);
+			CArrayPushBack(&map->TilePics, &pics);
+			// lazy initialise the arrays of things
+			// it's very slow to do 128x128 mallocs!
+			CArray things;
+			memset(&things, 0, sizeof things);
+			CArrayPushBack(&map->TileThings, &things);
 			unsigned short tI = MAP_FLOOR;
-			TileInit(&t);
-			CArrayPushBack(&map->Tiles, &t);
 			CArrayPushBack(&map->iMap, &tI);
 		}
 	}
@@ -1122,8 +1309,7 @@ void MapLoad(Map *map, struct MissionOptions *mo, CharacterStore *store)
 		for (j = 0; j < (itemDensity * map->Size.x * map->Size.y) / 1000; j++)
 		{
 			MapObject *mapObj = CArrayGet(&mo->MapObjects, i);
-			MapTryPlaceOneObject(map, Vec2iNew(
-				rand() % map->Size.x, rand() % map->Size.y), mapObj, 0, 1);
+			MapTryPlaceOneObject(map, GuessCoords(map), mapObj, 0, 1);
 		}
 	}
 
@@ -1182,13 +1368,22 @@ void MapLoad(Map *map, struct MissionOptions *mo, CharacterStore *store)
 		MapPlaceCard(map, 0, 0);
 	}
 
+	MapUpdateRoomGraph(map);
+
+	// Everything has changed as far as any drawing caches are concerned
+	sPicsRevision++;
+	for (i = 0; i < chunks.x * chunks.y; i++)
+	{
+		CArrayPushBack(&map->PicsRevisions, &sPicsRevision);
+	}
+
 	// Count total number of reachable tiles, for explored %
 	map->NumExplorableTiles = 0;
 	for (v.y = 0; v.y < map->Size.y; v.y++)
 	{
 		for (v.x = 0; v.x < map->Size.x; v.x++)
 		{
-			if (!(MapGetTile(map, v)->flags & MAPTILE_NO_WALK))
+			if (!BitGridGet(&map->NoWalk, v))
 			{
 				map->NumExplorableTiles++;
 			}
@@ -1196,6 +1391,106 @@ void MapLoad(Map *map, struct MissionOptions *mo, CharacterStore *store)
 	}
 }
 
+void MapMarkTilePicsChanged(Map *map, const Vec2i pos)
+{
+	sPicsRevision++;
+	// The tile above is drawn differently depending on whether this
+	// tile is a wall
+	for (int y = pos.y - 1; y <= pos.y; y++)
+	{
+		const Vec2i v = Vec2iNew(pos.x, y);
+		if (!MapIsTileIn(map, v))
+		{
+			continue;
+		}
+		const Vec2i chunks = MapGetPicsChunks(map);
+		*(int *)CArrayGet(
+			&map->PicsRevisions,
+			v.y / MAP_PICS_CHUNK * chunks.x + v.x / MAP_PICS_CHUNK) =
+			sPicsRevision;
+	}
+}
+Vec2i MapGetPicsChunks(const Map *map)
+{
+	return Vec2iNew(
+		(map->Size.x + MAP_PICS_CHUNK - 1) / MAP_PICS_CHUNK,
+		(map->Size.y + MAP_PICS_CHUNK - 1) / MAP_PICS_CHUNK);
+}
+int MapGetPicsRevision(const Map *map, const Vec2i chunk)
+{
+	const Vec2i chunks = MapGetPicsChunks(map);
+	return *(int *)CArrayGet(
+		&map->PicsRevisions, chunk.y * chunks.x + chunk.x);
+}
+void MapAddDecal(
+	Map *map, const Pic *pic, const Vec2i pos, const color_t mask)
+{
+	if (pic == NULL)
+	{
+		return;
+	}
+	MapDecal d;
+	d.Pic = pic;
+	d.Pos = pos;
+	d.Mask = mask;
+	// Add to every chunk the pic overlaps, so each can be drawn alone
+	const Vec2i chunks = MapGetPicsChunks(map);
+	const int chunkW = MAP_PICS_CHUNK * TILE_WIDTH;
+	const int chunkH = MAP_PICS_CHUNK * TILE_HEIGHT;
+	const int left = MAX(0, pos.x / chunkW);
+	const int right = MIN(chunks.x - 1, (pos.x + pic->size.x - 1) / chunkW);
+	const int top = MAX(0, pos.y / chunkH);
+	const int bottom =
+		MIN(chunks.y - 1, (pos.y + pic->size.y - 1) / chunkH);
+	Vec2i v;
+	for (v.y = top; v.y <= bottom; v.y++)
+	{
+		for (v.x = left; v.x <= right; v.x++)
+		{
+			CArrayPushBack(
+				CArrayGet(&map->Decals, v.y * chunks.x + v.x), &d);
+		}
+	}
+}
+const CArray *MapGetDecals(const Map *map, const Vec2i chunk)
+{
+	const Vec2i chunks = MapGetPicsChunks(map);
+	return CArrayGet(&map->Decals, chunk.y * chunks.x + chunk.x);
+}
+
+void MapSetTileFlags(Map *map, const Vec2i pos, const int flags)
+{
+	*(unsigned short *)CArrayGet(&map->TileFlags, TileIndex(map, pos)) =
+		(unsigned short)flags;
+	UpdateFlagPlanes(map, pos, flags);
+	map->TileFlagsRevision++;
+}
+
+static int GetRoomGraphTile(void *data, Vec2i tile)
+{
+	Map *map = data;
+	// Doors are recorded as such, open or closed
+	if ((IMapGet(map, tile) & MAP_MASKACCESS) == MAP_DOOR)
+	{
+		return MapGetDoorKeycardFlag(map, tile);
+	}
+	if (BitGridGet(&map->NoWalk, tile))
+	{
+		return ROOM_GRAPH_BLOCKED;
+	}
+	return 0;
+}
+void MapUpdateRoomGraph(Map *map)
+{
+	if (RoomGraphIsBuilt(&map->RoomGraph, map->Size, map->TileFlagsRevision))
+	{
+		return;
+	}
+	RoomGraphBuild(
+		&map->RoomGraph, map->Size, map->TileFlagsRevision,
+		GetRoomGraphTile, map);
+}
+
 bool MapIsFullPosOKforPlayer(Map *map, Vec2i pos, bool allowAllTiles)
 {
 	Vec2i tilePos = Vec2iToTile(Vec2iFull2Real(pos));
@@ -1213,24 +1508,16 @@ bool MapIsFullPosOKforPlayer(Map *map, Vec2i pos, bool allowAllTiles)
 
 void MapMarkAsVisited(Map *map, Vec2i pos)
 {
-	Tile *t = MapGetTile(map, pos);
-	if (!t->isVisited && !(t->flags & MAPTILE_NO_WALK))
+	if (!BitGridGet(&map->Visited, pos) && !BitGridGet(&map->NoWalk, pos))
 	{
 		map->tilesSeen++;
 	}
-	t->isVisited = true;
+	BitGridSet(&map->Visited, pos, true);
 }
 
 void MapMarkAllAsVisited(Map *map)
 {
-	Vec2i pos;
-	for (pos.y = 0; pos.y < map->Size.y; pos.y++)
-	{
-		for (pos.x = 0; pos.x < map->Size.x; pos.x++)
-		{
-			MapGetTile(map, pos)->isVisited = true;
-		}
-	}
+	BitGridSetAll(&map->Visited, true);
 }
 
 int MapGetExploredPercentage(Map *map)
@@ -1281,5 +1568,5 @@ Vec2i MapSearchTileAround(Map *map, Vec2i start, TileSelectFunc func)
 }
 bool MapTileIsUnexplored(Map *map, Vec2i tile)
 {
-	return !MapGetTile(map, tile)->isVisited;
+	return !BitGridGet(&map->Visited, tile);
 }
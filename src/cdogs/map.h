@@ -51,9 +51,12 @@
 
 #include <stdbool.h>
 
+#include "bit_grid.h"
 #include "map_object.h"
 #include "mission.h"
 #include "pic.h"
+#include "room_graph.h"
+#include "spatial_hash.h"
 #include "tile.h"
 #include "vector.h"
 
@@ -81,10 +84,47 @@ IMapType StrIMapType(const char *s);
 
 #define MAP_LEAVEFREE       4096
 
+// Changes to tile pics are tracked in square chunks of this many tiles,
+// so that caches of the drawn map know which parts to redraw
+#define MAP_PICS_CHUNK 16
+
+// A pic stamped onto the floor for good, such as blood, brass or a wreck;
+// see MapAddDecal
+typedef struct
+{
+	const Pic *Pic;
+	Vec2i Pos;	// real position of the pic's top left
+	color_t Mask;
+} MapDecal;
+
 typedef struct
 {
-	CArray Tiles;	// of Tile
 	Vec2i Size;
+	// Tile data is split into separate arrays by how it is used, so that
+	// loops over one kind (e.g. flags) don't pull the rest into cache
+	// Read and write it through the MapGetTile* functions
+	CArray TileFlags;	// of unsigned short
+	BitGrid Visited;
+	CArray TilePics;	// of TilePics
+	// Revision of each chunk of tile pics; see MapMarkTilePicsChanged
+	CArray PicsRevisions;	// of int
+	// Decals overlapping each chunk of tile pics, in the order stamped
+	CArray Decals;	// of CArray of MapDecal
+	CArray TileThings;	// of CArray of ThingId, lazily initialised
+	CArray TileTriggers;	// of TileTriggers, sorted by Index; sparse
+
+	// Collision broad-phase, kept in sync with the tile items
+	SpatialHash Broadphase;
+	// Rooms and doors, for planning long paths; see MapUpdateRoomGraph
+	RoomGraph RoomGraph;
+	// Incremented whenever tile flags change during the game,
+	// so that anything derived from them knows to recompute
+	int TileFlagsRevision;
+	// The most frequently checked tile flags, one bit per tile,
+	// kept in sync with the tiles; see MapSetTileFlags
+	BitGrid NoWalk;
+	BitGrid NoShoot;
+	BitGrid NoSee;
 
 	// internal data structure to help build the map
 	CArray iMap;	// of unsigned short
@@ -101,11 +141,24 @@ typedef struct
 	int NumExplorableTiles;
 } Map;
 
+// The triggers on one tile
+typedef struct
+{
+	int Index;	// of the tile, y * width + x
+	CArray Triggers;	// of Trigger *
+} TileTriggers;
+
 extern Map gMap;
 
 unsigned short GetAccessMask(int k);
 
-Tile *MapGetTile(Map *map, Vec2i pos);
+// Copy of all of a tile's data; tiles outside the map are TileNone
+Tile MapGetTile(Map *map, Vec2i pos);
+// Flags of a tile; tiles outside the map are TileNone
+int MapGetTileFlags(const Map *map, const Vec2i pos);
+TilePics *MapGetTilePics(Map *map, const Vec2i pos);
+const CArray *MapGetTileThings(const Map *map, const Vec2i pos);	// of ThingId
+const CArray *MapGetTileTriggers(const Map *map, const Vec2i pos);	// of Trigger *
 bool MapIsTileIn(const Map *map, const Vec2i pos);
 bool MapIsRealPosIn(const Map *map, const Vec2i realPos);
 bool MapIsTileInExit(Map *map, TTileItem *t);
@@ -113,10 +166,30 @@ bool MapIsTileInExit(Map *map, TTileItem *t);
 int MapHasLockedRooms(Map *map);
 int MapPosIsHighAccess(Map *map, int x, int y);
 int MapGetDoorKeycardFlag(Map *map, Vec2i pos);
+// Set a tile's flags, keeping the flag planes in sync
+void MapSetTileFlags(Map *map, const Vec2i pos, const int flags);
+// Rebuild the room graph if the tile flags have changed since it was built
+void MapUpdateRoomGraph(Map *map);
+// Call after changing a tile's pics or whether it is a wall during the
+// game, so that it gets redrawn
+void MapMarkTilePicsChanged(Map *map, const Vec2i pos);
+// Size of the map in chunks of MAP_PICS_CHUNK tiles
+Vec2i MapGetPicsChunks(const Map *map);
+// Revisions are unique across map loads, and never 0
+int MapGetPicsRevision(const Map *map, const Vec2i chunk);
+// Stamp a pic onto the floor, drawn masked and transparent like a
+// particle. Decals are drawn with the floor and never removed, so things
+// that come to rest for good can be stamped instead of being kept around
+// and drawn every frame.
+void MapAddDecal(
+	Map *map, const Pic *pic, const Vec2i pos, const color_t mask);
+const CArray *MapGetDecals(const Map *map, const Vec2i chunk);	// of MapDecal
 
 // Return false if cannot move to new position
 bool MapTryMoveTileItem(Map *map, TTileItem *t, Vec2i pos);
 void MapRemoveTileItem(Map *map, TTileItem *t);
+// Call after changing a tile item's flags, or a character's team
+void MapUpdateTileItem(Map *map, TTileItem *t);
 
 void MapInit(Map *map);
 void MapTerminate(Map *map);
@@ -48,6 +48,8 @@
 */
 #include "map_build.h"
 
+#include "rng.h"
+
 
 #define EXIT_WIDTH  8
 #define EXIT_HEIGHT 8
@@ -75,9 +77,9 @@ void MapSetupTile(Map *map, Vec2i pos, Mission *m)
 	int floor = m->FloorStyle % FLOOR_STYLE_COUNT;
 	int wall = m->WallStyle % WALL_STYLE_COUNT;
 	int room = m->RoomStyle % ROOMFLOOR_COUNT;
-	Tile *tAbove = MapGetTile(map, Vec2iNew(pos.x, pos.y - 1));
-	bool canSeeTileAbove = !(tAbove != NULL && !TileCanSee(tAbove));
-	Tile *t = MapGetTile(map, pos);
+	const int flagsAbove = MapGetTileFlags(map, Vec2iNew(pos.x, pos.y - 1));
+	bool canSeeTileAbove = !(flagsAbove & MAPTILE_NO_SEE);
+	TilePics *t = MapGetTilePics(map, pos);
 	if (!t)
 	{
 		return;
@@ -97,7 +99,9 @@ void MapSetupTile(Map *map, Vec2i pos, Mission *m)
 				&gPicManager, cFloorPics[floor][FLOOR_NORMAL]);
 			// Normal floor tiles can be replaced randomly with
 			// special floor tiles such as drainage
-			t->flags |= MAPTILE_IS_NORMAL_FLOOR;
+			MapSetTileFlags(
+				map, pos,
+				MapGetTileFlags(map, pos) | MAPTILE_IS_NORMAL_FLOOR);
 		}
 		break;
 
@@ -119,15 +123,15 @@ void MapSetupTile(Map *map, Vec2i pos, Mission *m)
 		t->pic = PicManagerGetFromOld(
 			&gPicManager,
 			cWallPics[wall][MapGetWallPic(map, pos)]);
-		t->flags =
+		MapSetTileFlags(
+			map, pos,
 			MAPTILE_NO_WALK | MAPTILE_NO_SHOOT |
-			MAPTILE_NO_SEE | MAPTILE_IS_WALL;
+			MAPTILE_NO_SEE | MAPTILE_IS_WALL);
 		break;
 
 	case MAP_NOTHING:
 		t->pic = NULL;
-		t->flags =
-			MAPTILE_NO_WALK | MAPTILE_IS_NOTHING;
+		MapSetTileFlags(map, pos, MAPTILE_NO_WALK | MAPTILE_IS_NOTHING);
 		break;
 	}
 }
@@ -294,7 +298,7 @@ void MapPlaceDoors(
 	if (doors[0])
 	{
 		int doorSize = MIN(
-			(doorMax > doorMin ? (rand() % (doorMax - doorMin + 1)) : 0) + doorMin,
+			RngRange(&gRngMap, doorMin, doorMax + 1),
 			size.y - 4);
 		for (i = -doorSize / 2; i < (doorSize + 1) / 2; i++)
 		{
@@ -309,7 +313,7 @@ void MapPlaceDoors(
 	if (doors[1])
 	{
 		int doorSize = MIN(
-			(doorMax > doorMin ? (rand() % (doorMax - doorMin + 1)) : 0) + doorMin,
+			RngRange(&gRngMap, doorMin, doorMax + 1),
 			size.y - 4);
 		for (i = -doorSize / 2; i < (doorSize + 1) / 2; i++)
 		{
@@ -324,7 +328,7 @@ void MapPlaceDoors(
 	if (doors[2])
 	{
 		int doorSize = MIN(
-			(doorMax > doorMin ? (rand() % (doorMax - doorMin + 1)) : 0) + doorMin,
+			RngRange(&gRngMap, doorMin, doorMax + 1),
 			size.x - 4);
 		for (i = -doorSize / 2; i < (doorSize + 1) / 2; i++)
 		{
@@ -339,7 +343,7 @@ void MapPlaceDoors(
 	if (doors[3])
 	{
 		int doorSize = MIN(
-			(doorMax > doorMin ? (rand() % (doorMax - doorMin + 1)) : 0) + doorMin,
+			RngRange(&gRngMap, doorMin, doorMax + 1),
 			size.x - 4);
 		for (i = -doorSize / 2; i < (doorSize + 1) / 2; i++)
 		{
@@ -685,7 +689,7 @@ void MapMakePillar(Map *map, Vec2i pos, Vec2i size)
 unsigned short GenerateAccessMask(int *accessLevel)
 {
 	unsigned short accessMask = 0;
-	switch (rand() % 20)
+	switch (RngInt(&gRngMap, 20))
 	{
 	case 0:
 		if (*accessLevel >= 4)
@@ -736,17 +740,17 @@ unsigned short GenerateAccessMask(int *accessLevel)
 
 void MapGenerateRandomExitArea(Map *map)
 {
-	const Tile *t = NULL;
-	for (int i = 0; i < 10000 && (t == NULL ||!TileCanWalk(t)); i++)
+	int flags = MAPTILE_NO_WALK;
+	for (int i = 0; i < 10000 && (flags & MAPTILE_NO_WALK); i++)
 	{
-		map->ExitStart.x = (rand() % (abs(map->Size.x) - EXIT_WIDTH - 1));
+		map->ExitStart.x = RngInt(&gRngMap, abs(map->Size.x) - EXIT_WIDTH - 1);
 		map->ExitEnd.x = map->ExitStart.x + EXIT_WIDTH + 1;
-		map->ExitStart.y = (rand() % (abs(map->Size.y) - EXIT_HEIGHT - 1));
+		map->ExitStart.y = RngInt(&gRngMap, abs(map->Size.y) - EXIT_HEIGHT - 1);
 		map->ExitEnd.y = map->ExitStart.y + EXIT_HEIGHT + 1;
 		// Check that the exit area is walkable
 		const Vec2i center = Vec2iNew(
 			(map->ExitStart.x + map->ExitEnd.x) / 2,
 			(map->ExitStart.y + map->ExitEnd.y) / 2);
-		t = MapGetTile(map, center);
+		flags = MapGetTileFlags(map, center);
 	}
 }
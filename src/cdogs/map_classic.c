@@ -52,6 +52,7 @@
 
 #include "gamedata.h"
 #include "map_build.h"
+#include "rng.h"
 
 
 static int MapTryBuildSquare(Map *map);
@@ -140,7 +141,9 @@ static Vec2i GuessCoords(Map *map);
 static int MapTryBuildSquare(Map *map)
 {
 	Vec2i v = GuessCoords(map);
-	Vec2i size = Vec2iNew(rand() % 9 + 8, rand() % 9 + 8);
+	Vec2i size;
+	size.x = RngRange(&gRngMap, 8, 17);
+	size.y = RngRange(&gRngMap, 8, 17);
 	if (MapIsAreaClear(map, v, size))
 	{
 		MapMakeSquare(map, v, size);
@@ -158,8 +161,8 @@ static int MapTryBuildRoom(
 	// make sure room is large enough to accommodate doors
 	int roomMin = MAX(m->u.Classic.Rooms.Min, doorMin + 4);
 	int roomMax = MAX(m->u.Classic.Rooms.Max, doorMin + 4);
-	int w = rand() % (roomMax - roomMin + 1) + roomMin;
-	int h = rand() % (roomMax - roomMin + 1) + roomMin;
+	int w = RngRange(&gRngMap, roomMin, roomMax + 1);
+	int h = RngRange(&gRngMap, roomMin, roomMax + 1);
 	Vec2i pos = GuessCoords(map);
 	Vec2i clearPos = Vec2iNew(pos.x - pad, pos.y - pad);
 	Vec2i clearSize = Vec2iNew(w + 2 * pad, h + 2 * pad);
@@ -213,7 +216,7 @@ static int MapTryBuildRoom(
 	}
 	if (isClear)
 	{
-		int doormask = rand() % 15 + 1;
+		int doormask = RngRange(&gRngMap, 1, 16);
 		int doors[4];
 		int doorsUnplaced = 0;
 		int i;
@@ -299,9 +302,9 @@ static int MapTryBuildPillar(Map *map, Mission *m, int pad)
 {
 	int pillarMin = m->u.Classic.Pillars.Min;
 	int pillarMax = m->u.Classic.Pillars.Max;
-	Vec2i size = Vec2iNew(
-		rand() % (pillarMax - pillarMin + 1) + pillarMin,
-		rand() % (pillarMax - pillarMin + 1) + pillarMin);
+	Vec2i size;
+	size.x = RngRange(&gRngMap, pillarMin, pillarMax + 1);
+	size.y = RngRange(&gRngMap, pillarMin, pillarMax + 1);
 	Vec2i pos = GuessCoords(map);
 	Vec2i clearPos = Vec2iNew(pos.x - pad, pos.y - pad);
 	Vec2i clearSize = Vec2iNew(size.x + 2 * pad, size.y + 2 * pad);
@@ -363,7 +366,8 @@ static int MapTryBuildWall(
 	if (MapIsValidStartForWall(map, v.x, v.y, tileType, pad))
 	{
 		MapMakeWall(map, v);
-		MapGrowWall(map, v.x, v.y, tileType, pad, rand() & 3, wallLength);
+		MapGrowWall(
+			map, v.x, v.y, tileType, pad, RngInt(&gRngMap, 4), wallLength);
 		return 1;
 	}
 	return 0;
@@ -466,11 +470,11 @@ static void MapGrowWall(
 	}
 	MapMakeWall(map, Vec2iNew(x, y));
 	length--;
-	if (length > 0 && (rand() & 3) == 0)
+	if (length > 0 && RngInt(&gRngMap, 4) == 0)
 	{
 		// Randomly try to grow the wall in a different direction
-		l = rand() % length;
-		MapGrowWall(map, x, y, tileType, pad, rand() & 3, l);
+		l = RngInt(&gRngMap, length);
+		MapGrowWall(map, x, y, tileType, pad, RngInt(&gRngMap, 4), l);
 		length -= l;
 	}
 	// Keep growing wall in same direction
@@ -479,7 +483,10 @@ static void MapGrowWall(
 
 static Vec2i GuessCoords(Map *map)
 {
-	return Vec2iNew(rand() % map->Size.x, rand() % map->Size.y);
+	Vec2i v;
+	v.x = RngInt(&gRngMap, map->Size.x);
+	v.y = RngInt(&gRngMap, map->Size.y);
+	return v;
 }
 
 static int MapFindWallRun(Map *map, Vec2i start, Vec2i d, int len)
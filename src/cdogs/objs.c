@@ -61,6 +61,7 @@
 #include "screen_shake.h"
 #include "blit.h"
 #include "pic_manager.h"
+#include "rng.h"
 #include "defs.h"
 #include "actors.h"
 #include "gamedata.h"
@@ -71,15 +72,15 @@
 #define SOUND_LOCK_MOBILE_OBJECT 12
 #define SHOT_IMPULSE_DIVISOR 25
 
-CArray gObjs;
-CArray gMobObjs;
+CPool gObjs;
+CPool gMobObjs;
 
 
 // Draw functions
 
 const Pic *GetObjectPic(const int id, Vec2i *offset)
 {
-	const TObject *obj = CArrayGet(&gObjs, id);
+	const TObject *obj = CPoolGet(&gObjs, id);
 
 	Pic *pic = NULL;
 	// Try to get new pic if available
@@ -116,7 +117,7 @@ static void DamageObject(
 	const int power, const int flags, const int player, const int uid,
 	TTileItem *target)
 {
-	TObject *object = CArrayGet(&gObjs, target->id);
+	TObject *object = CPoolGet(&gObjs, target->id);
 	// Don't bother if object already destroyed
 	if (object->structure <= 0)
 	{
@@ -194,14 +195,12 @@ static void DamageObject(
 		}
 		if (object->wreckedPic)
 		{
-			object->tileItem.flags = TILEITEM_IS_WRECK;
-			object->pic = object->wreckedPic;
-			object->picName = "";
-		}
-		else
-		{
-			ObjDestroy(object->tileItem.id);
+			// Wrecks don't interact with anything; leave one on the floor
+			AddDecalOld(
+				Vec2iNew(object->tileItem.x, object->tileItem.y),
+				object->wreckedPic);
 		}
+		ObjDestroy(object->tileItem.id);
 	}
 }
 
@@ -352,19 +351,26 @@ static bool DoDamageCharacter(
 					if (gConfig.Game.ShotsPushback)
 					{
 						eb.u.AddParticle.Vel = Vec2iScaleDiv(
-							Vec2iScale(hitVector, (rand() % 8 + 8) * power),
+							Vec2iScale(
+								hitVector, RngRange(&gRngCosmetic, 8, 16) * power),
 							15 * SHOT_IMPULSE_DIVISOR);
 					}
 					else
 					{
 						eb.u.AddParticle.Vel = Vec2iScaleDiv(
-							Vec2iScale(hitVector, rand() % 8 + 8), 20);
+							Vec2iScale(
+								hitVector, RngRange(&gRngCosmetic, 8, 16)),
+							20);
 					}
-					eb.u.AddParticle.Vel.x += (rand() % 128) - 64;
-					eb.u.AddParticle.Vel.y += (rand() % 128) - 64;
-					eb.u.AddParticle.Angle = RAND_DOUBLE(0, PI * 2);
-					eb.u.AddParticle.DZ = (rand() % 6) + 6;
-					eb.u.AddParticle.Spin = RAND_DOUBLE(-0.1, 0.1);
+					eb.u.AddParticle.Vel.x +=
+						RngRange(&gRngCosmetic, -64, 64);
+					eb.u.AddParticle.Vel.y +=
+						RngRange(&gRngCosmetic, -64, 64);
+					eb.u.AddParticle.Angle =
+						RngDouble(&gRngCosmetic, 0, PI * 2);
+					eb.u.AddParticle.DZ = RngRange(&gRngCosmetic, 6, 12);
+					eb.u.AddParticle.Spin =
+						RngDouble(&gRngCosmetic, -0.1, 0.1);
 					GameEventsEnqueue(&gGameEvents, eb);
 					switch (gConfig.Game.Gore)
 					{
@@ -406,18 +412,16 @@ static bool DoDamageCharacter(
 
 void UpdateMobileObjects(int ticks)
 {
-	for (int i = 0; i < (int)gMobObjs.size; i++)
+	for (int i = 0; i < CPoolLiveCount(&gMobObjs); i++)
 	{
-		TMobileObject *obj = CArrayGet(&gMobObjs, i);
-		if (!obj->isInUse)
-		{
-			continue;
-		}
+		TMobileObject *obj = CPoolGetLive(&gMobObjs, i);
 		if ((*(obj->updateFunc))(obj, ticks) == 0)
 		{
 			GameEvent e;
 			e.Type = GAME_EVENT_MOBILE_OBJECT_REMOVE;
-			e.u.MobileObjectRemoveId = i;
+			e.u.MobileObjectRemove.Id = obj->tileItem.id;
+			e.u.MobileObjectRemove.Generation =
+				CPoolGeneration(&gMobObjs, obj->tileItem.id);
 			GameEventsEnqueue(&gGameEvents, e);
 		}
 		else
@@ -430,26 +434,22 @@ void UpdateMobileObjects(int ticks)
 
 void ObjsInit(void)
 {
-	CArrayInit(&gObjs, sizeof(TObject));
-	CArrayReserve(&gObjs, 1024);
+	CPoolInit(&gObjs, sizeof(TObject));
+	CPoolReserve(&gObjs, 1024);
 }
 void ObjsTerminate(void)
 {
-	for (int i = 0; i < (int)gObjs.size; i++)
+	for (int i = CPoolLiveCount(&gObjs) - 1; i >= 0; i--)
 	{
-		TObject *o = CArrayGet(&gObjs, i);
-		if (o->isInUse)
-		{
-			ObjDestroy(i);
-		}
+		ObjDestroy(CPoolLiveId(&gObjs, i));
 	}
-	CArrayTerminate(&gObjs);
+	CPoolTerminate(&gObjs);
 }
 void AddObjectOld(
 	int x, int y, Vec2i size,
 	const TOffsetPic * pic, PickupType type, int tileFlags)
 {
-	TObject *o = CArrayGet(&gObjs, ObjAdd(
+	TObject *o = CPoolGet(&gObjs, ObjAdd(
 		Vec2iNew(x, y), size, NULL, type, tileFlags));
 	o->pic = pic;
 	o->wreckedPic = NULL;
@@ -457,31 +457,23 @@ void AddObjectOld(
 	o->flags = 0;
 	MapTryMoveTileItem(&gMap, &o->tileItem, Vec2iFull2Real(Vec2iNew(x, y)));
 }
+void AddDecalOld(const Vec2i realPos, const TOffsetPic *pic)
+{
+	const Pic *p = PicManagerGetFromOld(&gPicManager, pic->picIndex);
+	if (p == NULL)
+	{
+		return;
+	}
+	const Vec2i pos = Vec2iAdd(
+		realPos, Vec2iAdd(Vec2iNew(pic->dx, pic->dy), p->offset));
+	MapAddDecal(&gMap, p, pos, colorWhite);
+}
 int ObjAdd(
 	Vec2i pos, Vec2i size,
 	const char *picName, PickupType type, int tileFlags)
 {
-	// Find an empty slot in actor list
-	TObject *o = NULL;
-	int i;
-	for (i = 0; i < (int)gObjs.size; i++)
-	{
-		TObject *obj = CArrayGet(&gObjs, i);
-		if (!obj->isInUse)
-		{
-			o = obj;
-			break;
-		}
-	}
-	if (o == NULL)
-	{
-		TObject obj;
-		memset(&obj, 0, sizeof obj);
-		CArrayPushBack(&gObjs, &obj);
-		i = (int)gObjs.size - 1;
-		o = CArrayGet(&gObjs, i);
-	}
-	memset(o, 0, sizeof *o);
+	const int i = CPoolAdd(&gObjs);
+	TObject *o = CPoolGet(&gObjs, i);
 	o->pic = NULL;
 	o->wreckedPic = NULL;
 	o->picName = picName;
@@ -507,7 +499,7 @@ void ObjAddDestructible(
 	int structure, int objFlags, int tileFlags)
 {
 	Vec2i fullPos = Vec2iReal2Full(pos);
-	TObject *o = CArrayGet(&gObjs, ObjAdd(
+	TObject *o = CPoolGet(&gObjs, ObjAdd(
 		fullPos, size, picName, OBJ_NONE, tileFlags));
 	o->pic = pic;
 	o->wreckedPic = wreckedPic;
@@ -516,10 +508,11 @@ void ObjAddDestructible(
 }
 void ObjDestroy(int id)
 {
-	TObject *o = CArrayGet(&gObjs, id);
+	TObject *o = CPoolGet(&gObjs, id);
 	CASSERT(o->isInUse, "Destroying in-use object");
 	MapRemoveTileItem(&gMap, &o->tileItem);
 	o->isInUse = false;
+	CPoolRemove(&gObjs, id);
 }
 
 
@@ -541,44 +534,21 @@ static void BogusDraw(Vec2i pos, TileItemDrawFuncData *data)
 
 void MobObjsInit(void)
 {
-	CArrayInit(&gMobObjs, sizeof(TMobileObject));
-	CArrayReserve(&gMobObjs, 1024);
+	CPoolInit(&gMobObjs, sizeof(TMobileObject));
+	CPoolReserve(&gMobObjs, 1024);
 }
 void MobObjsTerminate(void)
 {
-	for (int i = 0; i < (int)gMobObjs.size; i++)
+	for (int i = CPoolLiveCount(&gMobObjs) - 1; i >= 0; i--)
 	{
-		TMobileObject *m = CArrayGet(&gMobObjs, i);
-		if (m->isInUse)
-		{
-			MobObjDestroy(i);
-		}
+		MobObjDestroy(CPoolLiveId(&gMobObjs, i));
 	}
-	CArrayTerminate(&gMobObjs);
+	CPoolTerminate(&gMobObjs);
 }
 int MobObjAdd(const Vec2i fullpos, const int player, const int uid)
 {
-	// Find an empty slot in mobobj list
-	TMobileObject *obj = NULL;
-	int i;
-	for (i = 0; i < (int)gMobObjs.size; i++)
-	{
-		TMobileObject *m = CArrayGet(&gMobObjs, i);
-		if (!m->isInUse)
-		{
-			obj = m;
-			break;
-		}
-	}
-	if (obj == NULL)
-	{
-		TMobileObject m;
-		memset(&m, 0, sizeof m);
-		CArrayPushBack(&gMobObjs, &m);
-		i = (int)gMobObjs.size - 1;
-		obj = CArrayGet(&gMobObjs, i);
-	}
-	memset(obj, 0, sizeof *obj);
+	const int i = CPoolAdd(&gMobObjs);
+	TMobileObject *obj = CPoolGet(&gMobObjs, i);
 	obj->x = fullpos.x;
 	obj->y = fullpos.y;
 	obj->player = player;
@@ -598,10 +568,11 @@ int MobObjAdd(const Vec2i fullpos, const int player, const int uid)
 }
 void MobObjDestroy(int id)
 {
-	TMobileObject *m = CArrayGet(&gMobObjs, id);
+	TMobileObject *m = CPoolGet(&gMobObjs, id);
 	CASSERT(m->isInUse, "Destroying not-in-use mobobj");
 	MapRemoveTileItem(&gMap, &m->tileItem);
 	m->isInUse = false;
+	CPoolRemove(&gMobObjs, id);
 }
 
 typedef struct
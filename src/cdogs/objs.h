@@ -51,6 +51,7 @@
 
 #include "actors.h"
 #include "bullet_class.h"
+#include "c_pool.h"
 #include "map.h"
 #include "pics.h"
 #include "vector.h"
@@ -122,8 +123,8 @@ typedef struct MobileObject
 	bool isInUse;
 } TMobileObject;
 typedef int (*MobObjUpdateFunc)(TMobileObject *, int);
-extern CArray gMobObjs;	// of TMobileObject
-extern CArray gObjs;	// of TObject
+extern CPool gMobObjs;	// of TMobileObject
+extern CPool gObjs;	// of TObject
 
 
 bool DamageSomething(
@@ -142,6 +143,9 @@ void ObjsTerminate(void);
 void AddObjectOld(
 	int x, int y, Vec2i size,
 	const TOffsetPic * pic, PickupType type, int tileFlags);
+// Stamp an old pic onto the floor, where an object at realPos would
+// draw it
+void AddDecalOld(const Vec2i realPos, const TOffsetPic *pic);
 int ObjAdd(
 	Vec2i pos, Vec2i size,
 	const char *picName, PickupType type, int tileFlags);
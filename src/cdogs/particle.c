@@ -26,14 +26,15 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "particle.h"
-
+#include "activity.h"
 #include "collision.h"
 #include "game_events.h"
 #include "json_utils.h"
+#include "rng.h"
 
 
 ParticleClasses gParticleClasses;
-CArray gParticles;
+Particles gParticles;
 
 #define VERSION 1
 
@@ -181,190 +182,316 @@ const ParticleClass *StrParticleClass(
 	return NULL;
 }
 
-void ParticlesInit(CArray *particles)
+#define PARTICLES_INITIAL_CAPACITY 256
+static void ParticlesGrow(Particles *particles, const int capacity);
+void ParticlesInit(Particles *particles)
+{
+	memset(particles, 0, sizeof *particles);
+	CPoolInit(&particles->Pool, sizeof(Particle));
+	CPoolReserve(&particles->Pool, PARTICLES_INITIAL_CAPACITY);
+	ParticlesGrow(particles, PARTICLES_INITIAL_CAPACITY);
+}
+#define GROW_ARRAY(_arr, _capacity)\
+	CREALLOC(_arr, (_capacity) * sizeof *(_arr))
+static void ParticlesGrow(Particles *particles, const int capacity)
 {
-	CArrayInit(particles, sizeof(Particle));
-	CArrayReserve(particles, 256);
+	GROW_ARRAY(particles->X, capacity);
+	GROW_ARRAY(particles->Y, capacity);
+	GROW_ARRAY(particles->VelX, capacity);
+	GROW_ARRAY(particles->VelY, capacity);
+	GROW_ARRAY(particles->Z, capacity);
+	GROW_ARRAY(particles->DZ, capacity);
+	GROW_ARRAY(particles->Gravity, capacity);
+	GROW_ARRAY(particles->Bounces, capacity);
+	GROW_ARRAY(particles->Count, capacity);
+	GROW_ARRAY(particles->Range, capacity);
+	GROW_ARRAY(particles->Angle, capacity);
+	GROW_ARRAY(particles->Spin, capacity);
+	GROW_ARRAY(particles->StartX, capacity);
+	GROW_ARRAY(particles->StartY, capacity);
+	particles->Capacity = capacity;
 }
-void ParticlesTerminate(CArray *particles)
+void ParticlesTerminate(Particles *particles)
 {
-	for (int i = 0; i < (int)particles->size; i++)
+	for (int i = CPoolLiveCount(&particles->Pool) - 1; i >= 0; i--)
 	{
-		Particle *p = CArrayGet(particles, i);
-		if (p->isInUse)
-		{
-			ParticleDestroy(particles, i);
-		}
+		ParticleDestroy(particles, CPoolLiveId(&particles->Pool, i));
 	}
-	CArrayTerminate(particles);
+	CPoolTerminate(&particles->Pool);
+	CFREE(particles->X);
+	CFREE(particles->Y);
+	CFREE(particles->VelX);
+	CFREE(particles->VelY);
+	CFREE(particles->Z);
+	CFREE(particles->DZ);
+	CFREE(particles->Gravity);
+	CFREE(particles->Bounces);
+	CFREE(particles->Count);
+	CFREE(particles->Range);
+	CFREE(particles->Angle);
+	CFREE(particles->Spin);
+	CFREE(particles->StartX);
+	CFREE(particles->StartY);
+	memset(particles, 0, sizeof *particles);
 }
 
-static bool ParticleUpdate(Particle *p, const int ticks);
-void ParticlesUpdate(CArray *particles, const int ticks)
+static void ParticlesIntegrate(
+	Particles *particles, const int n, const int ticks);
+static bool ParticleUpdate(
+	Particles *particles, const int i, Particle *p);
+void ParticlesUpdate(Particles *particles, const int ticks)
 {
-	for (int i = 0; i < (int)particles->size; i++)
+	const int n = CPoolLiveCount(&particles->Pool);
+	memcpy(particles->StartX, particles->X, n * sizeof *particles->X);
+	memcpy(particles->StartY, particles->Y, n * sizeof *particles->Y);
+	ParticlesIntegrate(particles, n, ticks);
+	for (int i = 0; i < n; i++)
 	{
-		Particle *p = CArrayGet(particles, i);
-		if (!p->isInUse)
-		{
-			continue;
-		}
-		if (!ParticleUpdate(p, ticks))
+		Particle *p = CPoolGetLive(&particles->Pool, i);
+		if (!ParticleUpdate(particles, i, p))
 		{
 			GameEvent e;
 			e.Type = GAME_EVENT_PARTICLE_REMOVE;
-			e.u.ParticleRemoveId = i;
+			e.u.ParticleRemove.Id = p->tileItem.id;
+			e.u.ParticleRemove.Generation =
+				CPoolGeneration(&particles->Pool, p->tileItem.id);
 			GameEventsEnqueue(&gGameEvents, e);
 		}
 	}
 }
 
+#ifdef _MSC_VER
+#define restrict __restrict
+#endif
+// Movement, gravity and bouncing off the floor, for all particles.
+// The loop is kept branch-free, reading and writing every element
+// unconditionally, so that it can be vectorised; particles without gravity
+// take the same path with the gravity terms cancelling out.
+// The arrays are passed as restrict parameters so the compiler knows they
+// don't alias.
+static void IntegrateMotion(
+	int *restrict x, int *restrict y, int *restrict velX, int *restrict velY,
+	int *restrict z, int *restrict dz,
+	const int *restrict gravity, const int *restrict bounces,
+	const int n, const int ticks)
+{
+	for (int t = 0; t < ticks; t++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			const int g = gravity[i];
+			const int oldDZ = dz[i];
+			const int movedZ = z[i] + oldDZ;
+			const int landed = (g != 0) & (movedZ <= 0);
+			const int bounceDZ = (-oldDZ / 2) * bounces[i];
+			const int newDZ = landed ? bounceDZ : oldDZ - g;
+			const int newZ = landed ? 0 : movedZ;
+			const int resting = (g != 0) & (newDZ == 0) & (newZ == 0);
+			x[i] += velX[i];
+			y[i] += velY[i];
+			z[i] = newZ;
+			dz[i] = newDZ;
+			velX[i] *= !resting;
+			velY[i] *= !resting;
+		}
+	}
+}
+// Resting is a fixed point of the motion above, so whether the particle
+// came to rest can be checked once at the end
+static void IntegrateSpin(
+	double *restrict angle, double *restrict spin, int *restrict count,
+	const int *restrict z, const int *restrict dz,
+	const int *restrict gravity, const int n, const int ticks)
+{
+	for (int i = 0; i < n; i++)
+	{
+		count[i] += ticks;
+		const int resting = (gravity[i] != 0) & (dz[i] == 0) & (z[i] == 0);
+		spin[i] *= !resting;
+		double a = angle[i] + spin[i];
+		a = a > 2 * PI ? a - PI * 2 : a;
+		a = a < 0 ? a + PI * 2 : a;
+		angle[i] = a;
+	}
+}
+static void ParticlesIntegrate(
+	Particles *particles, const int n, const int ticks)
+{
+	IntegrateMotion(
+		particles->X, particles->Y, particles->VelX, particles->VelY,
+		particles->Z, particles->DZ, particles->Gravity, particles->Bounces,
+		n, ticks);
+	IntegrateSpin(
+		particles->Angle, particles->Spin, particles->Count,
+		particles->Z, particles->DZ, particles->Gravity, n, ticks);
+}
 
-static bool ParticleUpdate(Particle *p, const int ticks)
+static const Pic *GetParticlePic(
+	const Particles *particles, const int i, const Particle *p)
 {
-	p->Count += ticks;
-	const Vec2i startPos = p->Pos;
-	for (int i = 0; i < ticks; i++)
+	if (p->Class->Sprites == NULL)
 	{
-		p->Pos = Vec2iAdd(p->Pos, p->Vel);
-		p->Z += p->DZ;
-		if (p->Class->GravityFactor != 0)
+		return p->Class->Pic;
+	}
+	int frame = (int)RadiansToDirection(particles->Angle[i]);
+	if (p->Class->TicksPerFrame > 0)
+	{
+		frame = MIN(
+			particles->Count[i] / p->Class->TicksPerFrame,
+			(int)p->Class->Sprites->pics.size - 1);
+	}
+	return CArrayGet(&p->Class->Sprites->pics, frame);
+}
+// Whether a resting particle has finished animating, and will look the
+// same for the rest of its life
+static bool IsParticleSettled(
+	const Particles *particles, const int i, const Particle *p)
+{
+	return p->Class->Sprites == NULL || p->Class->TicksPerFrame == 0 ||
+		particles->Count[i] / p->Class->TicksPerFrame >=
+		(int)p->Class->Sprites->pics.size - 1;
+}
+
+// Per-particle work that depends on the class or the map
+static bool ParticleUpdate(
+	Particles *particles, const int i, Particle *p)
+{
+	if (particles->Gravity[i] != 0 &&
+		particles->DZ[i] == 0 && particles->Z[i] == 0)
+	{
+		if (IsParticleSettled(particles, i, p))
 		{
-			if (p->Z <= 0)
-			{
-				p->Z = 0;
-				if (p->Class->Bounces)
-				{
-					p->DZ = -p->DZ / 2;
-				}
-				else
-				{
-					p->DZ = 0;
-				}
-			}
-			else
+			// Stamp it onto the floor and retire it, instead of drawing
+			// it every frame until it expires
+			const Pic *pic = GetParticlePic(particles, i, p);
+			const Vec2i realPos = Vec2iFull2Real(
+				Vec2iNew(particles->X[i], particles->Y[i]));
+			if (pic != NULL && MapIsRealPosIn(&gMap, realPos))
 			{
-				p->DZ -= p->Class->GravityFactor;
-			}
-			if (p->DZ == 0 && p->Z == 0)
-			{
-				p->Vel = Vec2iZero();
-				p->Spin = 0;
-				// Set as wreck so that it gets drawn last
-				p->tileItem.flags |= TILEITEM_IS_WRECK;
+				const Vec2i picPos = Vec2iAdd(
+					Vec2iMinus(realPos, Vec2iScaleDiv(pic->size, 2)),
+					pic->offset);
+				MapAddDecal(&gMap, pic, picPos, p->Class->Mask);
 			}
+			return false;
 		}
+		// Set as wreck so that it gets drawn last
+		p->tileItem.flags |= TILEITEM_IS_WRECK;
 	}
+	Vec2i pos = Vec2iNew(particles->X[i], particles->Y[i]);
 	if (p->Class->HitsWalls)
 	{
-		const Vec2i realPos = Vec2iFull2Real(p->Pos);
+		const Vec2i realPos = Vec2iFull2Real(pos);
 		const bool hitWall =
 			MapIsRealPosIn(&gMap, realPos) && ShootWall(realPos.x, realPos.y);
 		if (hitWall)
 		{
+			Vec2i vel = Vec2iNew(particles->VelX[i], particles->VelY[i]);
 			if (p->Class->WallBounces)
 			{
-				p->Pos = GetWallBounceFullPos(startPos, p->Pos, &p->Vel);
+				const Vec2i startPos =
+					Vec2iNew(particles->StartX[i], particles->StartY[i]);
+				pos = GetWallBounceFullPos(startPos, pos, &vel);
+				particles->X[i] = pos.x;
+				particles->Y[i] = pos.y;
 			}
 			else
 			{
-				p->Vel = Vec2iZero();
+				vel = Vec2iZero();
 			}
+			particles->VelX[i] = vel.x;
+			particles->VelY[i] = vel.y;
 		}
 	}
-	const Vec2i realPos = Vec2iFull2Real(p->Pos);
-	if (!MapTryMoveTileItem(&gMap, &p->tileItem, realPos))
+	// Effects far from all the players would never be seen; drop them.
+	// Falling particles (gore, brass) are kept, as they settle into decals
+	// that are still there when a player arrives
+	if (particles->Gravity[i] == 0 && !ActivityIsActive(&gActivity, pos))
 	{
-		// Out of map; destroy
 		return false;
 	}
-
-	// Spin
-	p->Angle += p->Spin;
-	if (p->Angle > 2 * PI)
-	{
-		p->Angle -= PI * 2;
-	}
-	if (p->Angle < 0)
+	// Most particles stay in the same place or move within a tile;
+	// only update the map when the position changes
+	const Vec2i realPos = Vec2iFull2Real(pos);
+	if ((realPos.x != p->tileItem.x || realPos.y != p->tileItem.y) &&
+		!MapTryMoveTileItem(&gMap, &p->tileItem, realPos))
 	{
-		p->Angle += PI * 2;
+		// Out of map; destroy
+		return false;
 	}
 
-	return p->Count <= p->Range;
+	return particles->Count[i] <= particles->Range[i];
 }
 
 static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data);
-int ParticleAdd(CArray *particles, const AddParticle add)
+int ParticleAdd(Particles *particles, const AddParticle add)
 {
-	// Find an empty slot in list
-	Particle *p = NULL;
-	int i;
-	for (i = 0; i < (int)particles->size; i++)
-	{
-		Particle *pSlot = CArrayGet(particles, i);
-		if (!pSlot->isInUse)
-		{
-			p = pSlot;
-			break;
-		}
-	}
-	// If no empty slots, add a new one
-	if (p == NULL)
+	const int id = CPoolAdd(&particles->Pool);
+	const int i = CPoolLiveIndex(&particles->Pool, id);
+	if (i >= particles->Capacity)
 	{
-		Particle pNew;
-		memset(&pNew, 0, sizeof pNew);
-		CArrayPushBack(particles, &pNew);
-		i = (int)particles->size - 1;
-		p = CArrayGet(particles, i);
+		ParticlesGrow(particles, particles->Capacity * 2);
 	}
-	memset(p, 0, sizeof *p);
+	Particle *p = CPoolGet(&particles->Pool, id);
 	p->Class = add.Class;
-	p->Pos = add.FullPos;
-	p->Z = add.Z;
-	p->Angle = add.Angle;
-	p->Vel = add.Vel;
-	p->DZ = add.DZ;
-	p->Spin = add.Spin;
-	p->Range = RAND_INT(add.Class->RangeLow, add.Class->RangeHigh);
 	p->isInUse = true;
+	particles->X[i] = add.FullPos.x;
+	particles->Y[i] = add.FullPos.y;
+	particles->VelX[i] = add.Vel.x;
+	particles->VelY[i] = add.Vel.y;
+	particles->Z[i] = add.Z;
+	particles->DZ[i] = add.DZ;
+	particles->Gravity[i] = add.Class->GravityFactor;
+	particles->Bounces[i] = add.Class->Bounces;
+	particles->Count[i] = 0;
+	particles->Range[i] = RngRange(
+		&gRngCosmetic, add.Class->RangeLow, add.Class->RangeHigh);
+	particles->Angle[i] = add.Angle;
+	particles->Spin[i] = add.Spin;
 	p->tileItem.x = p->tileItem.y = -1;
 	p->tileItem.kind = KIND_PARTICLE;
-	p->tileItem.id = i;
+	p->tileItem.id = id;
 	p->tileItem.drawFunc = DrawParticle;
-	p->tileItem.drawData.MobObjId = i;
+	p->tileItem.drawData.MobObjId = id;
 	MapTryMoveTileItem(&gMap, &p->tileItem, Vec2iFull2Real(add.FullPos));
-	return i;
+	return id;
 }
-void ParticleDestroy(CArray *particles, const int id)
+#define MOVE_ELEM(_arr, _to, _from) (_arr)[_to] = (_arr)[_from]
+void ParticleDestroy(Particles *particles, const int id)
 {
-	Particle *p = CArrayGet(particles, id);
+	Particle *p = CPoolGet(&particles->Pool, id);
 	CASSERT(p->isInUse, "Destroying not-in-use particle");
 	MapRemoveTileItem(&gMap, &p->tileItem);
 	p->isInUse = false;
+	// The pool moves the last live particle into this one's place;
+	// do the same for the parallel arrays
+	const int i = CPoolLiveIndex(&particles->Pool, id);
+	const int last = CPoolLiveCount(&particles->Pool) - 1;
+	MOVE_ELEM(particles->X, i, last);
+	MOVE_ELEM(particles->Y, i, last);
+	MOVE_ELEM(particles->VelX, i, last);
+	MOVE_ELEM(particles->VelY, i, last);
+	MOVE_ELEM(particles->Z, i, last);
+	MOVE_ELEM(particles->DZ, i, last);
+	MOVE_ELEM(particles->Gravity, i, last);
+	MOVE_ELEM(particles->Bounces, i, last);
+	MOVE_ELEM(particles->Count, i, last);
+	MOVE_ELEM(particles->Range, i, last);
+	MOVE_ELEM(particles->Angle, i, last);
+	MOVE_ELEM(particles->Spin, i, last);
+	MOVE_ELEM(particles->StartX, i, last);
+	MOVE_ELEM(particles->StartY, i, last);
+	CPoolRemove(&particles->Pool, id);
 }
 
 static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data)
 {
-	const Particle *p = CArrayGet(&gParticles, data->MobObjId);
+	const Particle *p = CPoolGet(&gParticles.Pool, data->MobObjId);
 	CASSERT(p->isInUse, "Cannot draw non-existent particle");
-	const Pic *pic;
-	if (p->Class->Sprites)
-	{
-		int frame = (int)RadiansToDirection(p->Angle);
-		if (p->Class->TicksPerFrame > 0)
-		{
-			frame = MIN(
-				p->Count / p->Class->TicksPerFrame,
-				(int)p->Class->Sprites->pics.size - 1);
-		}
-		pic = CArrayGet(&p->Class->Sprites->pics, frame);
-	}
-	else
-	{
-		pic = p->Class->Pic;
-	}
+	const int i = CPoolLiveIndex(&gParticles.Pool, data->MobObjId);
+	const Pic *pic = GetParticlePic(&gParticles, i, p);
 	CASSERT(pic != NULL, "particle picture not found");
 	Vec2i picPos = Vec2iMinus(pos, Vec2iScaleDiv(pic->size, 2));
-	picPos.y -= p->Z / Z_FACTOR;
+	picPos.y -= gParticles.Z[i] / Z_FACTOR;
 	BlitMasked(&gGraphicsDevice, pic, picPos, p->Class->Mask, true);
 }
@@ -30,6 +30,7 @@
 
 #include <json/json.h>
 
+#include "c_pool.h"
 #include "pic.h"
 #include "tile.h"
 
@@ -58,19 +59,35 @@ extern ParticleClasses gParticleClasses;
 typedef struct
 {
 	const ParticleClass *Class;
-	// Coordinates are in full
-	Vec2i Pos;
-	int Z;
-	double Angle;
-	Vec2i Vel;
-	int DZ;
-	double Spin;
-	int Count;
-	int Range;
 	TTileItem tileItem;
 	bool isInUse;
 } Particle;
-extern CArray gParticles;	// of Particle
+// Particles are stored split in two: the pool holds the rarely-touched
+// parts (class, tile item), and the state that is updated every tick is
+// held in parallel arrays, indexed by the particle's live index in the
+// pool, so that updating is a dense pass over contiguous arrays.
+typedef struct
+{
+	CPool Pool;	// of Particle
+	int Capacity;
+	// Coordinates are in full
+	int *X;
+	int *Y;
+	int *VelX;
+	int *VelY;
+	int *Z;
+	int *DZ;
+	int *Gravity;	// copied from class
+	int *Bounces;	// copied from class
+	int *Count;
+	int *Range;
+	double *Angle;
+	double *Spin;
+	// Positions at the start of the update, for wall bouncing
+	int *StartX;
+	int *StartY;
+} Particles;
+extern Particles gParticles;
 
 typedef struct
 {
@@ -90,11 +107,11 @@ void ParticleClassesClear(CArray *classes);
 const ParticleClass *StrParticleClass(
 	const ParticleClasses *classes, const char *name);
 
-void ParticlesInit(CArray *particles);
-void ParticlesTerminate(CArray *particles);
-void ParticlesUpdate(CArray *particles, const int ticks);
+void ParticlesInit(Particles *particles);
+void ParticlesTerminate(Particles *particles);
+void ParticlesUpdate(Particles *particles, const int ticks);
 
-int ParticleAdd(CArray *particles, const AddParticle add);
-void ParticleDestroy(CArray *particles, const int id);
+int ParticleAdd(Particles *particles, const AddParticle add);
+void ParticleDestroy(Particles *particles, const int id);
 
 #endif
@@ -0,0 +1,281 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "path_grid.h"
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include "tile.h"
+#include "utils.h"
+
+typedef struct
+{
+	float F;	// estimated total cost through this node
+	int Index;	// tile index
+} PathGridOpen;
+
+
+bool PathGridInit(PathGrid *g, Vec2i size)
+{
+	memset(g, 0, sizeof *g);
+	// Tile indices are ints
+	if (size.x <= 0 || size.y <= 0 || size.x > INT_MAX / size.y)
+	{
+		return false;
+	}
+	g->Size = size;
+	CArrayInit(&g->Nodes, sizeof(PathGridNode));
+	CArrayReserve(&g->Nodes, size.x * size.y);
+	PathGridNode n;
+	memset(&n, 0, sizeof n);
+	for (int i = 0; i < size.x * size.y; i++)
+	{
+		CArrayPushBack(&g->Nodes, &n);
+	}
+	CArrayInit(&g->Open, sizeof(PathGridOpen));
+	g->Generation = 1;
+	return true;
+}
+void PathGridTerminate(PathGrid *g)
+{
+	CArrayTerminate(&g->Nodes);
+	CArrayTerminate(&g->Open);
+	memset(g, 0, sizeof *g);
+}
+bool PathGridIsInit(const PathGrid *g, Vec2i size)
+{
+	return g->Generation != 0 && Vec2iEqual(g->Size, size);
+}
+
+// Start a new search; invalidates all nodes at once
+static void NewSearch(PathGrid *g)
+{
+	g->Generation++;
+	if (g->Generation == 0)
+	{
+		// Wrapped around; need to clear the stamps for real
+		for (int i = 0; i < (int)g->Nodes.size; i++)
+		{
+			((PathGridNode *)CArrayGet(&g->Nodes, i))->Generation = 0;
+		}
+		g->Generation = 1;
+	}
+	CArrayClear(&g->Open);
+}
+static PathGridNode *GetNode(PathGrid *g, const int index)
+{
+	PathGridNode *n = CArrayGet(&g->Nodes, index);
+	if (n->Generation != g->Generation)
+	{
+		n->Generation = g->Generation;
+		n->IsClosed = false;
+		n->Parent = -1;
+		n->G = -1;
+	}
+	return n;
+}
+
+static void OpenPush(CArray *heap, const PathGridOpen o)
+{
+	CArrayPushBack(heap, &o);
+	PathGridOpen *items = heap->data;
+	int i = (int)heap->size - 1;
+	while (i > 0)
+	{
+		const int parent = (i - 1) / 2;
+		if (items[parent].F <= items[i].F)
+		{
+			break;
+		}
+		const PathGridOpen tmp = items[parent];
+		items[parent] = items[i];
+		items[i] = tmp;
+		i = parent;
+	}
+}
+static PathGridOpen OpenPop(CArray *heap)
+{
+	PathGridOpen *items = heap->data;
+	const PathGridOpen top = items[0];
+	heap->size--;
+	const int size = (int)heap->size;
+	if (size > 0)
+	{
+		items[0] = items[size];
+		int i = 0;
+		for (;;)
+		{
+			const int left = 2 * i + 1;
+			const int right = left + 1;
+			int smallest = i;
+			if (left < size && items[left].F < items[smallest].F)
+			{
+				smallest = left;
+			}
+			if (right < size && items[right].F < items[smallest].F)
+			{
+				smallest = right;
+			}
+			if (smallest == i)
+			{
+				break;
+			}
+			const PathGridOpen tmp = items[smallest];
+			items[smallest] = items[i];
+			items[i] = tmp;
+			i = smallest;
+		}
+	}
+	return top;
+}
+
+static bool IsIn(const PathGrid *g, const Vec2i v)
+{
+	return v.x >= 0 && v.x < g->Size.x && v.y >= 0 && v.y < g->Size.y;
+}
+static float Heuristic(const Vec2i from, const Vec2i to)
+{
+	// Simple Euclidean
+	return (float)sqrt(DistanceSquared(
+		Vec2iCenterOfTile(from), Vec2iCenterOfTile(to)));
+}
+static void ReconstructPath(PathGrid *g, const int goal, CArray *path);
+bool PathGridFind(
+	PathGrid *g, const Vec2i from, const Vec2i to,
+	PathGridTileFunc isTileOk, void *data, CArray *path)
+{
+	CArrayClear(path);
+	if (!IsIn(g, from) || !IsIn(g, to))
+	{
+		return false;
+	}
+	NewSearch(g);
+	const int start = from.y * g->Size.x + from.x;
+	const int goal = to.y * g->Size.x + to.x;
+	PathGridNode *n = GetNode(g, start);
+	n->G = 0;
+	PathGridOpen o;
+	o.F = Heuristic(from, to);
+	o.Index = start;
+	OpenPush(&g->Open, o);
+	while (g->Open.size > 0)
+	{
+		const PathGridOpen current = OpenPop(&g->Open);
+		n = GetNode(g, current.Index);
+		// Nodes are pushed again when a cheaper route is found, rather
+		// than updated in the heap; skip the stale copies
+		if (n->IsClosed)
+		{
+			continue;
+		}
+		n->IsClosed = true;
+		if (current.Index == goal)
+		{
+			ReconstructPath(g, goal, path);
+			return true;
+		}
+		const Vec2i v = Vec2iNew(
+			current.Index % g->Size.x, current.Index / g->Size.x);
+		const float g0 = n->G;
+		for (int y = v.y - 1; y <= v.y + 1; y++)
+		{
+			if (y < 0 || y >= g->Size.y)
+			{
+				continue;
+			}
+			for (int x = v.x - 1; x <= v.x + 1; x++)
+			{
+				if (x < 0 || x >= g->Size.x)
+				{
+					continue;
+				}
+				if (x == v.x && y == v.y)
+				{
+					continue;
+				}
+				const int index = y * g->Size.x + x;
+				PathGridNode *neighbor = GetNode(g, index);
+				if (neighbor->IsClosed)
+				{
+					continue;
+				}
+				// if we're moving diagonally,
+				// need to check the axis-aligned neighbours are also clear
+				if (!isTileOk(data, Vec2iNew(x, y)) ||
+					!isTileOk(data, Vec2iNew(v.x, y)) ||
+					!isTileOk(data, Vec2iNew(x, v.y)))
+				{
+					continue;
+				}
+				// Calculate cost of direction
+				// Note that there are different horizontal and vertical
+				// costs, due to the tiles being non-square
+				// Slightly prefer axes instead of diagonals
+				float cost;
+				if (x != v.x && y != v.y)
+				{
+					cost = TILE_WIDTH * 1.1f;
+				}
+				else if (x != v.x)
+				{
+					cost = TILE_WIDTH;
+				}
+				else
+				{
+					cost = TILE_HEIGHT;
+				}
+				const float g1 = g0 + cost;
+				if (neighbor->G >= 0 && neighbor->G <= g1)
+				{
+					continue;
+				}
+				neighbor->G = g1;
+				neighbor->Parent = current.Index;
+				o.F = g1 + Heuristic(Vec2iNew(x, y), to);
+				o.Index = index;
+				OpenPush(&g->Open, o);
+			}
+		}
+	}
+	return false;
+}
+static void ReconstructPath(PathGrid *g, const int goal, CArray *path)
+{
+	for (int i = goal; i >= 0; i = GetNode(g, i)->Parent)
+	{
+		const Vec2i v = Vec2iNew(i % g->Size.x, i / g->Size.x);
+		CArrayPushBack(path, &v);
+	}
+	// Reverse so that it runs from start to goal
+	Vec2i *tiles = path->data;
+	for (int i = 0, j = (int)path->size - 1; i < j; i++, j--)
+	{
+		const Vec2i tmp = tiles[i];
+		tiles[i] = tiles[j];
+		tiles[j] = tmp;
+	}
+}
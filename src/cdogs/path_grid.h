@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __PATH_GRID
+#define __PATH_GRID
+
+#include <stdbool.h>
+
+#include "c_array.h"
+#include "vector.h"
+
+// A* pathfinding specialised for the tile grid
+// Node state is stored densely per tile and reset lazily by bumping a
+// generation counter, and the open set is a binary heap; all of this is
+// scratch memory kept between searches, so pathfinding doesn't allocate
+// once the arrays have grown to size.
+typedef struct
+{
+	unsigned int Generation;	// node is only valid if equal to the grid's
+	bool IsClosed;
+	int Parent;	// tile index, or -1 for the start
+	float G;	// cost from start
+} PathGridNode;
+typedef struct
+{
+	Vec2i Size;
+	CArray Nodes;	// of PathGridNode, one per tile
+	CArray Open;	// binary heap of PathGridOpen
+	unsigned int Generation;
+} PathGrid;
+
+typedef bool (*PathGridTileFunc)(void *data, Vec2i tile);
+
+// Returns whether the grid could be set up for a map of this size;
+// if not, the grid is left uninitialised
+bool PathGridInit(PathGrid *g, Vec2i size);
+void PathGridTerminate(PathGrid *g);
+bool PathGridIsInit(const PathGrid *g, Vec2i size);
+
+// Find a path between two tiles, moving in 8 directions; diagonal moves
+// require both adjacent axis-aligned tiles to be walkable as well.
+// The path, including the start and goal tiles, is written to path
+// (of Vec2i), which is left empty if there is no path.
+// Returns whether a path was found
+bool PathGridFind(
+	PathGrid *g, const Vec2i from, const Vec2i to,
+	PathGridTileFunc isTileOk, void *data, CArray *path);
+
+#endif
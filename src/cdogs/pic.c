@@ -29,9 +29,10 @@
 
 #include "blit.h"
 #include "palette.h"
+#include "rng.h"
 #include "utils.h"
 
-Pic picNone = { { 0, 0 }, { 0, 0 }, NULL };
+Pic picNone = { { 0, 0 }, { 0, 0 }, NULL, NULL, NULL };
 
 PicType StrPicType(const char *s)
 {
@@ -43,12 +44,59 @@ PicType StrPicType(const char *s)
 	return PICTYPE_NORMAL;
 }
 
+// Find the runs of non-zero pixels; call after making or changing the
+// pixels
+static void PicMakeSpans(Pic *p)
+{
+	CFREE(p->Spans);
+	CFREE(p->RowSpans);
+	CMALLOC(p->RowSpans, (p->size.y + 1) * sizeof *p->RowSpans);
+	// Count them first, to allocate the spans in one go
+	int count = 0;
+	for (int y = 0; y < p->size.y; y++)
+	{
+		const Uint32 *row = p->Data + y * p->size.x;
+		for (int x = 0; x < p->size.x; x++)
+		{
+			if (row[x] != 0 && (x == 0 || row[x - 1] == 0))
+			{
+				count++;
+			}
+		}
+	}
+	CMALLOC(p->Spans, MAX(count, 1) * sizeof *p->Spans);
+	count = 0;
+	for (int y = 0; y < p->size.y; y++)
+	{
+		p->RowSpans[y] = count;
+		const Uint32 *row = p->Data + y * p->size.x;
+		for (int x = 0; x < p->size.x;)
+		{
+			if (row[x] == 0)
+			{
+				x++;
+				continue;
+			}
+			PicSpan *span = &p->Spans[count++];
+			span->Start = x;
+			while (x < p->size.x && row[x] != 0)
+			{
+				x++;
+			}
+			span->Length = x - span->Start;
+		}
+	}
+	p->RowSpans[p->size.y] = count;
+}
+
 void PicLoad(
 	Pic *p, const Vec2i size, const Vec2i offset,
 	const SDL_Surface *image, const SDL_Surface *s)
 {
 	p->size = size;
 	p->offset = Vec2iZero();
+	p->Spans = NULL;
+	p->RowSpans = NULL;
 	CMALLOC(p->Data, size.x * size.y * sizeof(((Pic *)0)->Data));
 	// Manually copy the pixels and replace the alpha component,
 	// since our gfx device format has no alpha
@@ -76,12 +124,15 @@ void PicLoad(
 			srcI += image->w - size.x;
 		}
 	}
+	PicMakeSpans(p);
 }
 
 void PicFromPicPaletted(GraphicsDevice *g, Pic *pic, PicPaletted *picP)
 {
 	pic->size = Vec2iNew(picP->w, picP->h);
 	pic->offset = Vec2iZero();
+	pic->Spans = NULL;
+	pic->RowSpans = NULL;
 	CMALLOC(pic->Data, pic->size.x * pic->size.y * sizeof *pic->Data);
 	for (int i = 0; i < pic->size.x * pic->size.y; i++)
 	{
@@ -93,6 +144,7 @@ void PicFromPicPaletted(GraphicsDevice *g, Pic *pic, PicPaletted *picP)
 			pic->Data[i] = 0;
 		}
 	}
+	PicMakeSpans(pic);
 }
 
 void PicCopy(Pic *dst, const Pic *src)
@@ -102,11 +154,16 @@ void PicCopy(Pic *dst, const Pic *src)
 	size_t size = dst->size.x * dst->size.y * sizeof *dst->Data;
 	CMALLOC(dst->Data, size);
 	memcpy(dst->Data, src->Data, size);
+	dst->Spans = NULL;
+	dst->RowSpans = NULL;
+	PicMakeSpans(dst);
 }
 
 void PicFree(Pic *pic)
 {
 	CFREE(pic->Data);
+	CFREE(pic->Spans);
+	CFREE(pic->RowSpans);
 }
 
 int PicIsNotNone(Pic *pic)
@@ -167,6 +224,7 @@ void PicTrim(Pic *pic, const bool xTrim, const bool yTrim)
 	pic->Data = newData;
 	pic->size = newSize;
 	pic->offset = Vec2iZero();
+	PicMakeSpans(pic);
 }
 
 bool PicPxIsEdge(const Pic *pic, const Vec2i pos, const bool isPixel)
@@ -239,7 +297,8 @@ void CPicUpdate(CPic *p, const int ticks)
 		p->u.Animated.Count += ticks;
 		if (p->u.Animated.Count >= p->u.Animated.TicksPerFrame)
 		{
-			p->u.Animated.Frame = rand() % (int)p->u.Animated.Sprites->size;
+			p->u.Animated.Frame = RngInt(
+				&gRngCosmetic, (int)p->u.Animated.Sprites->size);
 			p->u.Animated.Count = 0;
 		}
 		break;
@@ -35,11 +35,23 @@
 #include "pic_file.h"
 #include "vector.h"
 
+// A run of non-zero pixels in a pic row
+typedef struct
+{
+	int Start;
+	int Length;
+} PicSpan;
 typedef struct
 {
 	Vec2i size;
 	Vec2i offset;
 	Uint32 *Data;
+	// The runs of non-zero pixels, row by row, so that blitting can skip
+	// the transparent parts. Row y's runs are from RowSpans[y] up to
+	// RowSpans[y + 1]. Both NULL if not made; shared by shallow copies,
+	// like Data.
+	PicSpan *Spans;
+	int *RowSpans;
 } Pic;
 typedef struct
 {
@@ -418,5 +418,7 @@ Pic PicFromTOffsetPic(PicManager *pm, TOffsetPic op)
 	pic.size = opPic->size;
 	pic.offset = Vec2iNew(op.dx, op.dy);
 	pic.Data = opPic->Data;
+	pic.Spans = opPic->Spans;
+	pic.RowSpans = opPic->RowSpans;
 	return pic;
 }
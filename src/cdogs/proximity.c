@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "proximity.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+
+void ProximityGridInit(
+	ProximityGrid *g, const Vec2i size, const Vec2i cellSize)
+{
+	memset(g, 0, sizeof *g);
+	g->Size = Vec2iNew(MAX(size.x, 1), MAX(size.y, 1));
+	g->CellSize = cellSize;
+	CArrayInit(&g->CellStarts, sizeof(int));
+	const int start = 0;
+	for (int i = 0; i < g->Size.x * g->Size.y + 1; i++)
+	{
+		CArrayPushBack(&g->CellStarts, &start);
+	}
+	CArrayInit(&g->Items, sizeof(ProximityItem));
+	CArrayInit(&g->Pending, sizeof(ProximityItem));
+}
+void ProximityGridTerminate(ProximityGrid *g)
+{
+	CArrayTerminate(&g->CellStarts);
+	CArrayTerminate(&g->Items);
+	CArrayTerminate(&g->Pending);
+	memset(g, 0, sizeof *g);
+}
+
+void ProximityGridAdd(ProximityGrid *g, const int id, const Vec2i pos)
+{
+	ProximityItem item;
+	item.Id = id;
+	item.Pos = pos;
+	CArrayPushBack(&g->Pending, &item);
+}
+
+// Positions outside the grid are clamped to the edge cells; this is safe
+// for queries as they can only be further away than the cell suggests
+static Vec2i GetCell(const ProximityGrid *g, const Vec2i pos)
+{
+	return Vec2iNew(
+		CLAMP(pos.x / g->CellSize.x, 0, g->Size.x - 1),
+		CLAMP(pos.y / g->CellSize.y, 0, g->Size.y - 1));
+}
+static int GetCellIndex(const ProximityGrid *g, const Vec2i pos)
+{
+	const Vec2i cell = GetCell(g, pos);
+	return cell.y * g->Size.x + cell.x;
+}
+void ProximityGridBuild(ProximityGrid *g)
+{
+	// Counting sort of the pending items into cells
+	int *starts = g->CellStarts.data;
+	const int numCells = g->Size.x * g->Size.y;
+	const int n = (int)g->Pending.size;
+	memset(starts, 0, sizeof(int) * (numCells + 1));
+	const ProximityItem *pending = g->Pending.data;
+	for (int i = 0; i < n; i++)
+	{
+		starts[GetCellIndex(g, pending[i].Pos)]++;
+	}
+	// Running totals give the end of each cell...
+	for (int i = 1; i < numCells; i++)
+	{
+		starts[i] += starts[i - 1];
+	}
+	// ...then fill each cell backwards, which leaves the starts behind,
+	// and keeps items within a cell in the order they were added
+	CArrayReserve(&g->Items, n);
+	g->Items.size = n;
+	ProximityItem *items = g->Items.data;
+	for (int i = n - 1; i >= 0; i--)
+	{
+		items[--starts[GetCellIndex(g, pending[i].Pos)]] = pending[i];
+	}
+	starts[numCells] = n;
+	CArrayClear(&g->Pending);
+}
+
+static void SearchCell(
+	const ProximityGrid *g, const int cell, const Vec2i from,
+	ProximityFilterFunc filter, void *data, int *closest, int *minDistance)
+{
+	const int *starts = g->CellStarts.data;
+	const ProximityItem *items = g->Items.data;
+	for (int i = starts[cell]; i < starts[cell + 1]; i++)
+	{
+		const ProximityItem *item = &items[i];
+		const int distance = CHEBYSHEV_DISTANCE(
+			from.x, from.y, item->Pos.x, item->Pos.y);
+		if (*closest >= 0 &&
+			(distance > *minDistance ||
+			(distance == *minDistance && item->Id > *closest)))
+		{
+			continue;
+		}
+		if (filter != NULL && !filter(data, item->Id))
+		{
+			continue;
+		}
+		*closest = item->Id;
+		*minDistance = distance;
+	}
+}
+int ProximityGridFindClosest(
+	const ProximityGrid *g, const Vec2i from,
+	ProximityFilterFunc filter, void *data, int *distance)
+{
+	int closest = -1;
+	int minDistance = 0;
+	if (g->Items.size > 0)
+	{
+		const Vec2i c = GetCell(g, from);
+		const int maxRing = MAX(
+			MAX(c.x, g->Size.x - 1 - c.x), MAX(c.y, g->Size.y - 1 - c.y));
+		const int cellSize = MIN(g->CellSize.x, g->CellSize.y);
+		for (int r = 0; r <= maxRing; r++)
+		{
+			// Visit the cells exactly r cells away
+			for (int y = c.y - r; y <= c.y + r; y++)
+			{
+				if (y < 0 || y >= g->Size.y)
+				{
+					continue;
+				}
+				const bool isEdgeRow = y == c.y - r || y == c.y + r;
+				const int dx = isEdgeRow ? 1 : 2 * r;
+				for (int x = c.x - r; x <= c.x + r; x += dx)
+				{
+					if (x < 0 || x >= g->Size.x)
+					{
+						continue;
+					}
+					SearchCell(
+						g, y * g->Size.x + x, from, filter, data,
+						&closest, &minDistance);
+				}
+			}
+			// Anything in the next ring is more than r cells away
+			if (closest >= 0 && minDistance <= r * cellSize)
+			{
+				break;
+			}
+		}
+	}
+	if (distance != NULL)
+	{
+		*distance = minDistance;
+	}
+	return closest;
+}
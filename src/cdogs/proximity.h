@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __PROXIMITY
+#define __PROXIMITY
+
+#include <stdbool.h>
+
+#include "c_array.h"
+#include "vector.h"
+
+// Bucket grid for nearest-neighbour queries, rebuilt from scratch whenever
+// the items move (e.g. once per game tick).
+// Items are stored contiguously, sorted by cell, so building is a counting
+// sort and queries only visit the cells in expanding rings around the
+// query position until no closer item can exist.
+// Distances are Chebyshev, and ties go to the lowest id, so results are
+// the same as a linear search over items in id order.
+typedef struct
+{
+	int Id;
+	Vec2i Pos;
+} ProximityItem;
+typedef struct
+{
+	Vec2i Size;	// in cells
+	Vec2i CellSize;	// in position units
+	CArray CellStarts;	// of int, one per cell plus one; index into Items
+	CArray Items;	// of ProximityItem, sorted by cell
+	CArray Pending;	// of ProximityItem, added since the last build
+} ProximityGrid;
+
+// Return whether an item should be considered by a query
+typedef bool (*ProximityFilterFunc)(void *data, int id);
+
+void ProximityGridInit(
+	ProximityGrid *g, const Vec2i size, const Vec2i cellSize);
+void ProximityGridTerminate(ProximityGrid *g);
+
+// Add items, then build to make them available to queries;
+// building replaces all the items from the previous build
+void ProximityGridAdd(ProximityGrid *g, const int id, const Vec2i pos);
+void ProximityGridBuild(ProximityGrid *g);
+
+// Get the id of the closest item that passes the filter (which can be
+// NULL), or -1 if none. If distance is not NULL, it is set to the
+// distance to that item
+int ProximityGridFindClosest(
+	const ProximityGrid *g, const Vec2i from,
+	ProximityFilterFunc filter, void *data, int *distance);
+
+#endif
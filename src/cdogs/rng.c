@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rng.h"
+
+Rng gRngMap;
+Rng gRngSim;
+Rng gRngAI;
+Rng gRngCosmetic;
+
+typedef enum
+{
+	RNG_STREAM_MAP = 1,
+	RNG_STREAM_SIM,
+	RNG_STREAM_AI,
+	RNG_STREAM_COSMETIC
+} RngStream;
+
+void RngSeedAll(const uint32_t seed)
+{
+	RngSeed(&gRngMap, seed, RNG_STREAM_MAP);
+	RngSeedGame(seed);
+}
+void RngSeedGame(const uint32_t seed)
+{
+	RngSeed(&gRngSim, seed, RNG_STREAM_SIM);
+	RngSeed(&gRngAI, seed, RNG_STREAM_AI);
+	RngSeed(&gRngCosmetic, seed, RNG_STREAM_COSMETIC);
+}
+
+// SplitMix32, to spread seeds over the whole state
+static uint32_t SplitMix(uint32_t *x)
+{
+	uint32_t z = (*x += 0x9e3779b9U);
+	z = (z ^ (z >> 16)) * 0x85ebca6bU;
+	z = (z ^ (z >> 13)) * 0xc2b2ae35U;
+	return z ^ (z >> 16);
+}
+void RngSeed(Rng *r, const uint32_t seed, const uint32_t stream)
+{
+	uint32_t x = seed;
+	uint32_t s = stream;
+	x ^= SplitMix(&s);
+	for (int i = 0; i < 4; i++)
+	{
+		r->S[i] = SplitMix(&x);
+	}
+	// The all-zero state is the only one that never leaves itself
+	if ((r->S[0] | r->S[1] | r->S[2] | r->S[3]) == 0)
+	{
+		r->S[0] = 1;
+	}
+}
+void RngSeedFrom(Rng *r, Rng *parent)
+{
+	const uint32_t seed = RngNext(parent);
+	RngSeed(r, seed, RngNext(parent));
+}
+
+static uint32_t Rotl(const uint32_t x, const int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+uint32_t RngNext(Rng *r)
+{
+	uint32_t *s = r->S;
+	const uint32_t result = Rotl(s[1] * 5, 7) * 9;
+	const uint32_t t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = Rotl(s[3], 11);
+	return result;
+}
+int RngInt(Rng *r, const int n)
+{
+	if (n <= 0)
+	{
+		return 0;
+	}
+	// Scale rather than take the remainder; the low bits are the weakest
+	return (int)(((uint64_t)RngNext(r) * (uint32_t)n) >> 32);
+}
+int RngRange(Rng *r, const int low, const int high)
+{
+	if (high <= low)
+	{
+		return low;
+	}
+	return low + RngInt(r, high - low);
+}
+double RngDouble(Rng *r, const double low, const double high)
+{
+	// Use the top 32 bits as a fraction in [0, 1)
+	return low + RngNext(r) * (1.0 / 4294967296.0) * (high - low);
+}
@@ -0,0 +1,66 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __RNG
+#define __RNG
+
+#include <stdint.h>
+
+// Small, fast pseudo-random number generators (xoshiro128**)
+// Unlike rand(), each generator has its own state, so that separate parts
+// of the game draw from separate streams: what happens in one (e.g. how
+// many particles are drawn) doesn't change the numbers drawn by another
+// (e.g. the simulation), and streams can be used from several threads.
+typedef struct
+{
+	uint32_t S[4];
+} Rng;
+
+// Streams for the whole game
+extern Rng gRngMap;	// map generation and placement at load
+extern Rng gRngSim;	// the simulation; bullets, weapons, spawning
+extern Rng gRngAI;	// AI, and seeding the actors' own streams
+extern Rng gRngCosmetic;	// effects that never affect the simulation
+
+// Seed all the streams; mission setup does this from the campaign seed
+void RngSeedAll(const uint32_t seed);
+// Seed all but the map stream, e.g. after the map is loaded
+void RngSeedGame(const uint32_t seed);
+
+// Seed a generator from a seed and a stream number; generators with
+// the same seed but different stream numbers are independent
+void RngSeed(Rng *r, const uint32_t seed, const uint32_t stream);
+// Seed a sub-stream, drawing its seed from a parent stream
+void RngSeedFrom(Rng *r, Rng *parent);
+
+uint32_t RngNext(Rng *r);
+// Integer in [0, n), or 0 if n <= 0
+int RngInt(Rng *r, const int n);
+// Integer in [low, high), or low if high <= low
+int RngRange(Rng *r, const int low, const int high);
+// Real number in [low, high)
+double RngDouble(Rng *r, const double low, const double high);
+
+#endif
@@ -0,0 +1,500 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "room_graph.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tile.h"
+#include "utils.h"
+
+typedef struct
+{
+	float F;	// estimated total cost through this area
+	int Index;	// area index
+} RoomGraphOpen;
+
+
+void RoomGraphInit(RoomGraph *g)
+{
+	memset(g, 0, sizeof *g);
+	CArrayInit(&g->AreaOfTile, sizeof(int));
+	CArrayInit(&g->Areas, sizeof(RoomGraphArea));
+	CArrayInit(&g->Edges, sizeof(RoomGraphEdge));
+}
+void RoomGraphTerminate(RoomGraph *g)
+{
+	CArrayTerminate(&g->AreaOfTile);
+	CArrayTerminate(&g->Areas);
+	CArrayTerminate(&g->Edges);
+	memset(g, 0, sizeof *g);
+}
+
+void RoomGraphSearchInit(RoomGraphSearch *s)
+{
+	memset(s, 0, sizeof *s);
+	CArrayInit(&s->Nodes, sizeof(RoomGraphNode));
+	CArrayInit(&s->Open, sizeof(RoomGraphOpen));
+}
+void RoomGraphSearchTerminate(RoomGraphSearch *s)
+{
+	CArrayTerminate(&s->Nodes);
+	CArrayTerminate(&s->Open);
+	memset(s, 0, sizeof *s);
+}
+
+static bool IsIn(const Vec2i size, const Vec2i v)
+{
+	return v.x >= 0 && v.x < size.x && v.y >= 0 && v.y < size.y;
+}
+static void AddArea(
+	RoomGraph *g, const CArray *masks, CArray *stack,
+	const Vec2i start, const Vec2i clusterStart, const Vec2i clusterEnd);
+static void AddEdges(RoomGraph *g);
+void RoomGraphBuild(
+	RoomGraph *g, const Vec2i size, const int revision,
+	RoomGraphTileFunc tileFunc, void *data)
+{
+	g->Size = size;
+	g->Revision = revision;
+	g->IsBuilt = true;
+	CArrayClear(&g->AreaOfTile);
+	CArrayClear(&g->Areas);
+	CArrayClear(&g->Edges);
+
+	// Query the tiles once up front; the flood fill visits them repeatedly
+	CArray masks;
+	CArrayInit(&masks, sizeof(int));
+	CArrayReserve(&masks, size.x * size.y);
+	CArrayReserve(&g->AreaOfTile, size.x * size.y);
+	Vec2i v;
+	for (v.y = 0; v.y < size.y; v.y++)
+	{
+		for (v.x = 0; v.x < size.x; v.x++)
+		{
+			const int mask = tileFunc(data, v);
+			const int area = -1;
+			CArrayPushBack(&masks, &mask);
+			CArrayPushBack(&g->AreaOfTile, &area);
+		}
+	}
+
+	// Flood fill areas, never crossing cluster boundaries
+	CArray stack;
+	CArrayInit(&stack, sizeof(Vec2i));
+	Vec2i c;
+	for (c.y = 0; c.y < size.y; c.y += ROOM_GRAPH_CLUSTER_SIZE)
+	{
+		for (c.x = 0; c.x < size.x; c.x += ROOM_GRAPH_CLUSTER_SIZE)
+		{
+			const Vec2i cEnd = Vec2iNew(
+				MIN(c.x + ROOM_GRAPH_CLUSTER_SIZE, size.x),
+				MIN(c.y + ROOM_GRAPH_CLUSTER_SIZE, size.y));
+			for (v.y = c.y; v.y < cEnd.y; v.y++)
+			{
+				for (v.x = c.x; v.x < cEnd.x; v.x++)
+				{
+					const int i = v.y * size.x + v.x;
+					if (*(int *)CArrayGet(&masks, i) != ROOM_GRAPH_BLOCKED &&
+						*(int *)CArrayGet(&g->AreaOfTile, i) < 0)
+					{
+						AddArea(g, &masks, &stack, v, c, cEnd);
+					}
+				}
+			}
+		}
+	}
+	CArrayTerminate(&stack);
+	CArrayTerminate(&masks);
+
+	AddEdges(g);
+}
+static void AddArea(
+	RoomGraph *g, const CArray *masks, CArray *stack,
+	const Vec2i start, const Vec2i clusterStart, const Vec2i clusterEnd)
+{
+	const int index = (int)g->Areas.size;
+	RoomGraphArea a;
+	memset(&a, 0, sizeof a);
+	a.Mask = *(int *)CArrayGet(masks, start.y * g->Size.x + start.x);
+	Vec2i sum = Vec2iZero();
+	int count = 0;
+
+	*(int *)CArrayGet(&g->AreaOfTile, start.y * g->Size.x + start.x) = index;
+	CArrayClear(stack);
+	CArrayPushBack(stack, &start);
+	while (stack->size > 0)
+	{
+		const Vec2i v = *(Vec2i *)CArrayGet(stack, (int)stack->size - 1);
+		stack->size--;
+		sum = Vec2iAdd(sum, Vec2iCenterOfTile(v));
+		count++;
+		const Vec2i neighbors[] =
+		{
+			{ v.x - 1, v.y }, { v.x + 1, v.y },
+			{ v.x, v.y - 1 }, { v.x, v.y + 1 }
+		};
+		for (int i = 0; i < 4; i++)
+		{
+			const Vec2i n = neighbors[i];
+			if (n.x < clusterStart.x || n.x >= clusterEnd.x ||
+				n.y < clusterStart.y || n.y >= clusterEnd.y)
+			{
+				continue;
+			}
+			const int ni = n.y * g->Size.x + n.x;
+			int *nArea = CArrayGet(&g->AreaOfTile, ni);
+			if (*nArea >= 0 || *(int *)CArrayGet(masks, ni) != a.Mask)
+			{
+				continue;
+			}
+			*nArea = index;
+			CArrayPushBack(stack, &n);
+		}
+	}
+	a.Center = Vec2iNew(sum.x / count, sum.y / count);
+	CArrayPushBack(&g->Areas, &a);
+}
+typedef struct
+{
+	int From;
+	int To;
+} AreaPair;
+static int CompareAreaPairs(const void *v1, const void *v2)
+{
+	const AreaPair *p1 = v1;
+	const AreaPair *p2 = v2;
+	if (p1->From != p2->From)
+	{
+		return p1->From - p2->From;
+	}
+	return p1->To - p2->To;
+}
+static void AddPair(CArray *pairs, const int a, const int b)
+{
+	AreaPair p;
+	p.From = a;
+	p.To = b;
+	CArrayPushBack(pairs, &p);
+	p.From = b;
+	p.To = a;
+	CArrayPushBack(pairs, &p);
+}
+static float AreaDistance(const RoomGraphArea *a1, const RoomGraphArea *a2)
+{
+	return (float)sqrt(DistanceSquared(a1->Center, a2->Center));
+}
+static void AddEdges(RoomGraph *g)
+{
+	// Areas are adjacent if any of their tiles are orthogonally adjacent;
+	// diagonal moves need both orthogonal tiles to be walkable too,
+	// so they never connect areas that aren't already connected
+	CArray pairs;
+	CArrayInit(&pairs, sizeof(AreaPair));
+	const int *areaOfTile = g->AreaOfTile.data;
+	for (int y = 0; y < g->Size.y; y++)
+	{
+		for (int x = 0; x < g->Size.x; x++)
+		{
+			const int a = areaOfTile[y * g->Size.x + x];
+			if (a < 0)
+			{
+				continue;
+			}
+			if (x + 1 < g->Size.x)
+			{
+				const int b = areaOfTile[y * g->Size.x + x + 1];
+				if (b >= 0 && b != a)
+				{
+					AddPair(&pairs, a, b);
+				}
+			}
+			if (y + 1 < g->Size.y)
+			{
+				const int b = areaOfTile[(y + 1) * g->Size.x + x];
+				if (b >= 0 && b != a)
+				{
+					AddPair(&pairs, a, b);
+				}
+			}
+		}
+	}
+	if (pairs.size > 0)
+	{
+		qsort(pairs.data, pairs.size, pairs.elemSize, CompareAreaPairs);
+	}
+
+	// Store the unique edges, grouped by source area
+	for (int i = 0; i < (int)pairs.size; i++)
+	{
+		const AreaPair *p = CArrayGet(&pairs, i);
+		if (i > 0 && CompareAreaPairs(p, CArrayGet(&pairs, i - 1)) == 0)
+		{
+			continue;
+		}
+		RoomGraphArea *from = CArrayGet(&g->Areas, p->From);
+		if (from->EdgeCount == 0)
+		{
+			from->EdgeStart = (int)g->Edges.size;
+		}
+		from->EdgeCount++;
+		RoomGraphEdge e;
+		e.To = p->To;
+		e.Cost = AreaDistance(from, CArrayGet(&g->Areas, p->To));
+		CArrayPushBack(&g->Edges, &e);
+	}
+	CArrayTerminate(&pairs);
+}
+
+bool RoomGraphIsBuilt(const RoomGraph *g, const Vec2i size, const int revision)
+{
+	return g->IsBuilt && Vec2iEqual(g->Size, size) && g->Revision == revision;
+}
+
+int RoomGraphGetArea(const RoomGraph *g, const Vec2i tile)
+{
+	if (!g->IsBuilt || !IsIn(g->Size, tile))
+	{
+		return -1;
+	}
+	return *(int *)CArrayGet(&g->AreaOfTile, tile.y * g->Size.x + tile.x);
+}
+
+// Make sure there is a node per area, e.g. after the graph is rebuilt
+static void ResizeNodes(RoomGraphSearch *s, const RoomGraph *g)
+{
+	if (s->Nodes.size == g->Areas.size)
+	{
+		return;
+	}
+	CArrayReserve(&s->Nodes, g->Areas.size);
+	s->Nodes.size = g->Areas.size;
+	memset(s->Nodes.data, 0, s->Nodes.size * s->Nodes.elemSize);
+	s->Generation = 0;
+	s->Corridor = 0;
+}
+// Start a new search; invalidates all search state at once
+static void NewSearch(RoomGraphSearch *s, const RoomGraph *g)
+{
+	ResizeNodes(s, g);
+	s->Generation++;
+	if (s->Generation == 0)
+	{
+		// Wrapped around; need to clear the stamps for real
+		for (int i = 0; i < (int)s->Nodes.size; i++)
+		{
+			((RoomGraphNode *)CArrayGet(&s->Nodes, i))->Generation = 0;
+		}
+		s->Generation = 1;
+	}
+	CArrayClear(&s->Open);
+}
+static RoomGraphNode *GetNode(RoomGraphSearch *s, const int index)
+{
+	RoomGraphNode *n = CArrayGet(&s->Nodes, index);
+	if (n->Generation != s->Generation)
+	{
+		n->Generation = s->Generation;
+		n->IsClosed = false;
+		n->Parent = -1;
+		n->G = -1;
+	}
+	return n;
+}
+
+static void OpenPush(CArray *heap, const RoomGraphOpen o)
+{
+	CArrayPushBack(heap, &o);
+	RoomGraphOpen *items = heap->data;
+	int i = (int)heap->size - 1;
+	while (i > 0)
+	{
+		const int parent = (i - 1) / 2;
+		if (items[parent].F <= items[i].F)
+		{
+			break;
+		}
+		const RoomGraphOpen tmp = items[parent];
+		items[parent] = items[i];
+		items[i] = tmp;
+		i = parent;
+	}
+}
+static RoomGraphOpen OpenPop(CArray *heap)
+{
+	RoomGraphOpen *items = heap->data;
+	const RoomGraphOpen top = items[0];
+	heap->size--;
+	const int size = (int)heap->size;
+	if (size > 0)
+	{
+		items[0] = items[size];
+		int i = 0;
+		for (;;)
+		{
+			const int left = 2 * i + 1;
+			const int right = left + 1;
+			int smallest = i;
+			if (left < size && items[left].F < items[smallest].F)
+			{
+				smallest = left;
+			}
+			if (right < size && items[right].F < items[smallest].F)
+			{
+				smallest = right;
+			}
+			if (smallest == i)
+			{
+				break;
+			}
+			const RoomGraphOpen tmp = items[smallest];
+			items[smallest] = items[i];
+			items[i] = tmp;
+			i = smallest;
+		}
+	}
+	return top;
+}
+
+static bool CanEnter(const RoomGraphArea *a, const int keyFlags)
+{
+	return (a->Mask & keyFlags) == a->Mask;
+}
+static void ReconstructPath(
+	RoomGraphSearch *s, const int goal, CArray *areas);
+bool RoomGraphFind(
+	const RoomGraph *g, RoomGraphSearch *s,
+	const int from, const int to, const int keyFlags, CArray *areas)
+{
+	CArrayClear(areas);
+	if (from < 0 || from >= (int)g->Areas.size ||
+		to < 0 || to >= (int)g->Areas.size)
+	{
+		return false;
+	}
+	NewSearch(s, g);
+	const RoomGraphArea *goal = CArrayGet(&g->Areas, to);
+	if (!CanEnter(goal, keyFlags))
+	{
+		return false;
+	}
+	RoomGraphNode *n = GetNode(s, from);
+	n->G = 0;
+	RoomGraphOpen o;
+	o.F = AreaDistance(CArrayGet(&g->Areas, from), goal);
+	o.Index = from;
+	OpenPush(&s->Open, o);
+	while (s->Open.size > 0)
+	{
+		const RoomGraphOpen current = OpenPop(&s->Open);
+		n = GetNode(s, current.Index);
+		// Areas are pushed again when a cheaper route is found, rather
+		// than updated in the heap; skip the stale copies
+		if (n->IsClosed)
+		{
+			continue;
+		}
+		n->IsClosed = true;
+		if (current.Index == to)
+		{
+			ReconstructPath(s, to, areas);
+			return true;
+		}
+		const float g0 = n->G;
+		const RoomGraphArea *a = CArrayGet(&g->Areas, current.Index);
+		for (int i = 0; i < a->EdgeCount; i++)
+		{
+			const RoomGraphEdge *e = CArrayGet(&g->Edges, a->EdgeStart + i);
+			const RoomGraphArea *neighbor = CArrayGet(&g->Areas, e->To);
+			RoomGraphNode *nn = GetNode(s, e->To);
+			if (nn->IsClosed || !CanEnter(neighbor, keyFlags))
+			{
+				continue;
+			}
+			const float g1 = g0 + e->Cost;
+			if (nn->G >= 0 && nn->G <= g1)
+			{
+				continue;
+			}
+			nn->G = g1;
+			nn->Parent = current.Index;
+			o.F = g1 + AreaDistance(neighbor, goal);
+			o.Index = e->To;
+			OpenPush(&s->Open, o);
+		}
+	}
+	return false;
+}
+static void ReconstructPath(
+	RoomGraphSearch *s, const int goal, CArray *areas)
+{
+	for (int i = goal; i >= 0; i = GetNode(s, i)->Parent)
+	{
+		CArrayPushBack(areas, &i);
+	}
+	// Reverse so that it runs from start to goal
+	int *indices = areas->data;
+	for (int i = 0, j = (int)areas->size - 1; i < j; i++, j--)
+	{
+		const int tmp = indices[i];
+		indices[i] = indices[j];
+		indices[j] = tmp;
+	}
+}
+
+void RoomGraphSetCorridor(
+	const RoomGraph *g, RoomGraphSearch *s, const CArray *areas)
+{
+	ResizeNodes(s, g);
+	s->Corridor++;
+	if (s->Corridor == 0)
+	{
+		// Wrapped around; need to clear the stamps for real
+		for (int i = 0; i < (int)s->Nodes.size; i++)
+		{
+			((RoomGraphNode *)CArrayGet(&s->Nodes, i))->Corridor = 0;
+		}
+		s->Corridor = 1;
+	}
+	for (int i = 0; i < (int)areas->size; i++)
+	{
+		const int index = *(int *)CArrayGet(areas, i);
+		((RoomGraphNode *)CArrayGet(&s->Nodes, index))->Corridor =
+			s->Corridor;
+	}
+}
+bool RoomGraphIsInCorridor(
+	const RoomGraph *g, const RoomGraphSearch *s, const Vec2i tile)
+{
+	const int index = RoomGraphGetArea(g, tile);
+	if (index < 0 || index >= (int)s->Nodes.size)
+	{
+		return false;
+	}
+	const RoomGraphNode *n = CArrayGet(&s->Nodes, index);
+	return s->Corridor != 0 && n->Corridor == s->Corridor;
+}
@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __ROOM_GRAPH
+#define __ROOM_GRAPH
+
+#include <stdbool.h>
+
+#include "c_array.h"
+#include "vector.h"
+
+// Abstract graph of the map for long-range pathfinding
+// The map is split into square clusters of tiles, and each cluster into
+// areas: groups of connected walkable tiles that need the same keycards.
+// Doors, which need keycards, end up in areas of their own, so the graph
+// is effectively rooms joined by portals.
+// Paths are planned over the areas first, and the tile pathfinder is then
+// only run over the areas along the way, so that searches cost in terms of
+// areas rather than tiles, and unreachable goals (e.g. behind locked doors)
+// are rejected without flooding the whole map.
+#define ROOM_GRAPH_CLUSTER_SIZE 16
+// Returned by the tile function for tiles that can never be walked on
+#define ROOM_GRAPH_BLOCKED (-1)
+
+typedef struct
+{
+	int Mask;	// keycard flags needed to enter; 0 for none
+	Vec2i Center;	// real coordinates of the centroid
+	int EdgeStart;	// index into edges
+	int EdgeCount;
+} RoomGraphArea;
+typedef struct
+{
+	int To;	// area index
+	float Cost;
+} RoomGraphEdge;
+typedef struct
+{
+	Vec2i Size;
+	int Revision;	// of the tile flags the graph was built from
+	bool IsBuilt;
+	CArray AreaOfTile;	// of int, one per tile; -1 if blocked
+	CArray Areas;	// of RoomGraphArea
+	CArray Edges;	// of RoomGraphEdge, grouped by source area
+} RoomGraph;
+
+// Per-area search state; only valid if generation equals the search's
+typedef struct
+{
+	unsigned int Generation;
+	bool IsClosed;
+	int Parent;	// area index, or -1 for the start
+	float G;	// cost from start
+	unsigned int Corridor;
+} RoomGraphNode;
+// Scratch memory for searching room graphs, kept apart from the graph so
+// that several threads can search the same graph at once, one each
+typedef struct
+{
+	CArray Nodes;	// of RoomGraphNode, one per area
+	CArray Open;	// binary heap of RoomGraphOpen
+	unsigned int Generation;
+	unsigned int Corridor;
+} RoomGraphSearch;
+
+// Returns the keycard flags needed to walk on the tile,
+// or ROOM_GRAPH_BLOCKED
+typedef int (*RoomGraphTileFunc)(void *data, Vec2i tile);
+
+void RoomGraphInit(RoomGraph *g);
+void RoomGraphTerminate(RoomGraph *g);
+void RoomGraphBuild(
+	RoomGraph *g, const Vec2i size, const int revision,
+	RoomGraphTileFunc tileFunc, void *data);
+bool RoomGraphIsBuilt(const RoomGraph *g, const Vec2i size, const int revision);
+
+void RoomGraphSearchInit(RoomGraphSearch *s);
+void RoomGraphSearchTerminate(RoomGraphSearch *s);
+
+// Returns the area index of a tile, or -1 if it is blocked
+int RoomGraphGetArea(const RoomGraph *g, const Vec2i tile);
+
+// Find a path between two areas, only entering areas whose keycards are
+// all in keyFlags. The path, including the start and goal areas, is
+// written to areas (of int), which is left empty if there is no path.
+// Returns whether a path was found
+bool RoomGraphFind(
+	const RoomGraph *g, RoomGraphSearch *s,
+	const int from, const int to, const int keyFlags, CArray *areas);
+
+// Mark a list of areas (of int), such as a path, as the search's current
+// corridor; this replaces its previous corridor
+void RoomGraphSetCorridor(
+	const RoomGraph *g, RoomGraphSearch *s, const CArray *areas);
+bool RoomGraphIsInCorridor(
+	const RoomGraph *g, const RoomGraphSearch *s, const Vec2i tile);
+
+#endif
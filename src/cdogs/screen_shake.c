@@ -30,6 +30,7 @@
 
 #include <string.h>
 
+#include "rng.h"
 #include "sys_config.h"
 
 #define MAX_SHAKE (100 * FPS_FRAMELIMIT / 100)
@@ -62,7 +63,10 @@ Vec2i ScreenShakeGetDelta(ScreenShake s)
 	{
 		return Vec2iZero();
 	}
-	return Vec2iNew(rand() % maxDelta, rand() % maxDelta);
+	Vec2i delta;
+	delta.x = RngInt(&gRngCosmetic, maxDelta);
+	delta.y = RngInt(&gRngCosmetic, maxDelta);
+	return delta;
 }
 
 ScreenShake ScreenShakeUpdate(ScreenShake s, int ticks)
@@ -0,0 +1,267 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "sim_checksum.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "actors.h"
+#include "gamedata.h"
+#include "map.h"
+#include "objs.h"
+
+SimChecksums gSimChecksums;
+
+static const char *partNames[SIM_CHECKSUM_COUNT] =
+{
+	"actors",
+	"mobile objects",
+	"objects",
+	"objectives"
+};
+
+
+bool SimChecksumsStart(SimChecksums *s, const char *filename)
+{
+	memset(s, 0, sizeof *s);
+	s->f = fopen(filename, "w");
+	if (s->f == NULL)
+	{
+		printf("Error: cannot open checksum file %s\n", filename);
+		return false;
+	}
+	return true;
+}
+void SimChecksumsTerminate(SimChecksums *s)
+{
+	if (s->f != NULL)
+	{
+		fclose(s->f);
+	}
+	memset(s, 0, sizeof *s);
+}
+bool SimChecksumsIsEnabled(const SimChecksums *s)
+{
+	return s->f != NULL;
+}
+
+
+// FNV-1a, a word at a time; quality isn't important, only that any
+// change shows up
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+static uint32_t HashInt(uint32_t h, const int v)
+{
+	return (h ^ (uint32_t)v) * FNV_PRIME;
+}
+static uint32_t HashVec2i(uint32_t h, const Vec2i v)
+{
+	return HashInt(HashInt(h, v.x), v.y);
+}
+
+// Pool elements are listed in removal order, which is an implementation
+// detail; add up the hashes of each element so that order doesn't matter
+static uint32_t HashActors(void)
+{
+	uint32_t sum = 0;
+	for (int i = 0; i < (int)gActors.size; i++)
+	{
+		const TActor *a = CArrayGet(&gActors, i);
+		if (!a->isInUse)
+		{
+			continue;
+		}
+		uint32_t h = HashInt(FNV_OFFSET, i);
+		h = HashVec2i(h, a->Pos);
+		h = HashVec2i(h, a->Vel);
+		h = HashInt(h, a->health);
+		h = HashInt(h, a->flags);
+		sum += h;
+	}
+	return sum;
+}
+static uint32_t HashMobileObjects(void)
+{
+	uint32_t sum = 0;
+	for (int i = 0; i < CPoolLiveCount(&gMobObjs); i++)
+	{
+		const TMobileObject *m = CPoolGetLive(&gMobObjs, i);
+		uint32_t h = HashInt(FNV_OFFSET, CPoolLiveId(&gMobObjs, i));
+		h = HashInt(h, m->x);
+		h = HashInt(h, m->y);
+		h = HashInt(h, m->z);
+		h = HashVec2i(h, m->vel);
+		h = HashInt(h, m->dz);
+		h = HashInt(h, m->count);
+		h = HashInt(h, m->range);
+		h = HashInt(h, m->flags);
+		sum += h;
+	}
+	return sum;
+}
+static uint32_t HashObjects(void)
+{
+	uint32_t sum = 0;
+	for (int i = 0; i < CPoolLiveCount(&gObjs); i++)
+	{
+		const TObject *o = CPoolGetLive(&gObjs, i);
+		uint32_t h = HashInt(FNV_OFFSET, CPoolLiveId(&gObjs, i));
+		h = HashInt(h, o->tileItem.x);
+		h = HashInt(h, o->tileItem.y);
+		h = HashInt(h, o->structure);
+		h = HashInt(h, o->flags);
+		h = HashInt(h, o->Type);
+		sum += h;
+	}
+	return sum;
+}
+static uint32_t HashObjectives(void)
+{
+	uint32_t h = FNV_OFFSET;
+	h = HashInt(h, gMission.state);
+	h = HashInt(h, gMission.time);
+	h = HashInt(h, gMission.pickupTime);
+	h = HashInt(h, gMap.tilesSeen);
+	for (int i = 0; i < (int)gMission.Objectives.size; i++)
+	{
+		const struct Objective *o = CArrayGet(&gMission.Objectives, i);
+		h = HashInt(h, o->placed);
+		h = HashInt(h, o->done);
+	}
+	return h;
+}
+
+static void Calc(uint32_t *parts)
+{
+	parts[SIM_CHECKSUM_ACTORS] = HashActors();
+	parts[SIM_CHECKSUM_MOBILE_OBJECTS] = HashMobileObjects();
+	parts[SIM_CHECKSUM_OBJECTS] = HashObjects();
+	parts[SIM_CHECKSUM_OBJECTIVES] = HashObjectives();
+}
+
+void SimChecksumsTick(SimChecksums *s)
+{
+	if (!SimChecksumsIsEnabled(s))
+	{
+		return;
+	}
+	uint32_t parts[SIM_CHECKSUM_COUNT];
+	Calc(parts);
+	fprintf(s->f, "%d %d", s->Ticks, gCampaign.MissionIndex);
+	for (int i = 0; i < SIM_CHECKSUM_COUNT; i++)
+	{
+		fprintf(s->f, " %08x", (unsigned int)parts[i]);
+	}
+	fputc('\n', s->f);
+	s->Ticks++;
+}
+
+
+// Read one line of checksums; returns false at end of file or on error
+static bool ReadLine(FILE *f, int *tick, int *mission, unsigned int *parts)
+{
+	if (fscanf(f, "%d %d", tick, mission) != 2)
+	{
+		return false;
+	}
+	for (int i = 0; i < SIM_CHECKSUM_COUNT; i++)
+	{
+		if (fscanf(f, "%x", &parts[i]) != 1)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SimChecksumsDiff(const char *filename1, const char *filename2)
+{
+	bool same = false;
+	FILE *f1 = fopen(filename1, "r");
+	FILE *f2 = fopen(filename2, "r");
+	if (f1 == NULL || f2 == NULL)
+	{
+		printf("Error: cannot open checksum file %s\n",
+			f1 == NULL ? filename1 : filename2);
+		goto bail;
+	}
+	for (;;)
+	{
+		int tick1, tick2, mission1, mission2;
+		unsigned int parts1[SIM_CHECKSUM_COUNT];
+		unsigned int parts2[SIM_CHECKSUM_COUNT];
+		const bool has1 = ReadLine(f1, &tick1, &mission1, parts1);
+		const bool has2 = ReadLine(f2, &tick2, &mission2, parts2);
+		if (!has1 && !has2)
+		{
+			printf("Checksums match\n");
+			same = true;
+			break;
+		}
+		if (has1 != has2)
+		{
+			printf("Checksums differ: %s ends at tick %d\n",
+				has1 ? filename2 : filename1, has1 ? tick1 : tick2);
+			break;
+		}
+		if (mission1 != mission2)
+		{
+			printf("Checksums differ at tick %d: mission %d vs %d\n",
+				tick1, mission1 + 1, mission2 + 1);
+			break;
+		}
+		bool differs = false;
+		for (int i = 0; i < SIM_CHECKSUM_COUNT; i++)
+		{
+			if (parts1[i] != parts2[i])
+			{
+				if (!differs)
+				{
+					printf("Checksums differ at tick %d (mission %d):",
+						tick1, mission1 + 1);
+					differs = true;
+				}
+				printf(" %s", partNames[i]);
+			}
+		}
+		if (differs)
+		{
+			printf("\n");
+			break;
+		}
+	}
+
+bail:
+	if (f1 != NULL)
+	{
+		fclose(f1);
+	}
+	if (f2 != NULL)
+	{
+		fclose(f2);
+	}
+	return same;
+}
@@ -0,0 +1,65 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __SIM_CHECKSUM
+#define __SIM_CHECKSUM
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Per-tick checksums of the simulation state, for checking that changes
+// to the code don't change how the game plays out.
+// Each sim tick writes one line to a side file:
+// <tick> <mission> <actors> <mobile objects> <objects> <objectives>
+// with the checksums in hex. Recording the same demo before and after a
+// change, and diffing the files, finds the first tick where they differ.
+typedef enum
+{
+	SIM_CHECKSUM_ACTORS,
+	SIM_CHECKSUM_MOBILE_OBJECTS,
+	SIM_CHECKSUM_OBJECTS,
+	SIM_CHECKSUM_OBJECTIVES,
+	SIM_CHECKSUM_COUNT
+} SimChecksumPart;
+
+typedef struct
+{
+	FILE *f;
+	int Ticks;
+} SimChecksums;
+extern SimChecksums gSimChecksums;
+
+bool SimChecksumsStart(SimChecksums *s, const char *filename);
+void SimChecksumsTerminate(SimChecksums *s);
+bool SimChecksumsIsEnabled(const SimChecksums *s);
+
+// Calculate and write the checksums for the current tick
+void SimChecksumsTick(SimChecksums *s);
+
+// Compare two checksum files and print the first tick that differs
+// Returns whether the files match
+bool SimChecksumsDiff(const char *filename1, const char *filename2);
+
+#endif
@@ -60,6 +60,7 @@
 
 #include "files.h"
 #include "music.h"
+#include "rng.h"
 #include "vector.h"
 
 SoundDevice gSoundDevice;
@@ -384,6 +385,7 @@ Mix_Chunk *StrSound(const char *s)
 Mix_Chunk *SoundGetRandomScream(const SoundDevice *device)
 {
 	Mix_Chunk **sound = CArrayGet(
-		&device->screamSounds, rand() % device->screamSounds.size);
+		&device->screamSounds,
+		RngInt(&gRngCosmetic, (int)device->screamSounds.size));
 	return *sound;
 }
@@ -0,0 +1,262 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "spatial_hash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "actors.h"
+#include "collision.h"
+#include "config.h"
+#include "utils.h"
+
+
+void SpatialHashInit(SpatialHash *h, const Vec2i size)
+{
+	h->Size = size;
+	CArrayInit(&h->Cells, sizeof(CArray));
+	CArrayReserve(&h->Cells, MAX(size.x * size.y, 1));
+	CArray empty;
+	memset(&empty, 0, sizeof empty);
+	for (int i = 0; i < size.x * size.y; i++)
+	{
+		CArrayPushBack(&h->Cells, &empty);
+	}
+}
+void SpatialHashTerminate(SpatialHash *h)
+{
+	for (int i = 0; i < (int)h->Cells.size; i++)
+	{
+		CArrayTerminate(CArrayGet(&h->Cells, i));
+	}
+	CArrayTerminate(&h->Cells);
+	memset(h, 0, sizeof *h);
+}
+
+static bool IsStored(const TileItemKind kind)
+{
+	return kind == KIND_CHARACTER || kind == KIND_OBJECT;
+}
+static CArray *GetCell(const SpatialHash *h, const Vec2i tile)
+{
+	if (tile.x < 0 || tile.x >= h->Size.x ||
+		tile.y < 0 || tile.y >= h->Size.y)
+	{
+		return NULL;
+	}
+	return CArrayGet(&h->Cells, tile.y * h->Size.x + tile.x);
+}
+static CArray *GetCellOfItem(const SpatialHash *h, const TTileItem *t)
+{
+	if (t->x < 0 || t->y < 0)
+	{
+		return NULL;
+	}
+	return GetCell(h, Vec2iToTile(Vec2iNew(t->x, t->y)));
+}
+static int FindRecord(const CArray *cell, const TTileItem *t)
+{
+	for (int i = 0; i < (int)cell->size; i++)
+	{
+		const SpatialRecord *r = CArrayGet(cell, i);
+		if (r->thing.Id == t->id && r->thing.Kind == t->kind)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+static void SetRecord(SpatialRecord *r, const TTileItem *t)
+{
+	r->x = t->x;
+	r->y = t->y;
+	r->w = t->w;
+	r->h = t->h;
+	r->flags = t->flags;
+	r->team = COLLISIONTEAM_NONE;
+	if (t->kind == KIND_CHARACTER)
+	{
+		r->team = CalcCollisionTeam(1, CArrayGet(&gActors, t->id));
+	}
+	r->thing.Id = t->id;
+	r->thing.Kind = t->kind;
+}
+
+void SpatialHashAdd(SpatialHash *h, const TTileItem *t)
+{
+	if (!IsStored(t->kind))
+	{
+		return;
+	}
+	CArray *cell = GetCellOfItem(h, t);
+	if (cell == NULL)
+	{
+		return;
+	}
+	// Lazy initialisation
+	if (cell->elemSize == 0)
+	{
+		CArrayInit(cell, sizeof(SpatialRecord));
+	}
+	SpatialRecord r;
+	SetRecord(&r, t);
+	CArrayPushBack(cell, &r);
+}
+void SpatialHashRemove(SpatialHash *h, const TTileItem *t)
+{
+	if (!IsStored(t->kind))
+	{
+		return;
+	}
+	CArray *cell = GetCellOfItem(h, t);
+	if (cell == NULL)
+	{
+		return;
+	}
+	const int i = FindRecord(cell, t);
+	CASSERT(i >= 0, "Did not find spatial record to delete");
+	if (i >= 0)
+	{
+		CArrayDelete(cell, i);
+	}
+}
+void SpatialHashUpdate(SpatialHash *h, const TTileItem *t)
+{
+	if (!IsStored(t->kind))
+	{
+		return;
+	}
+	CArray *cell = GetCellOfItem(h, t);
+	if (cell == NULL)
+	{
+		return;
+	}
+	const int i = FindRecord(cell, t);
+	CASSERT(i >= 0, "Did not find spatial record to update");
+	if (i >= 0)
+	{
+		SetRecord(CArrayGet(cell, i), t);
+	}
+}
+
+static bool IsOnSameTeam(const SpatialRecord *r, const SpatialQuery *q)
+{
+	if (gConfig.Game.AllyCollision == ALLYCOLLISION_NORMAL)
+	{
+		return false;
+	}
+	return
+		q->Team != COLLISIONTEAM_NONE &&
+		r->team != COLLISIONTEAM_NONE &&
+		q->Team == r->team &&
+		!q->IsDogfight;
+}
+// Same test as the narrow phase used to do on tile items:
+// overlapping at the new position, and not moving away
+static bool RecordCollides(const SpatialRecord *r, const SpatialQuery *q)
+{
+	const TTileItem *item = q->Item;
+	if (r->thing.Id == item->id && r->thing.Kind == item->kind)
+	{
+		return false;
+	}
+	if (!(r->flags & q->Mask) || IsOnSameTeam(r, q))
+	{
+		return false;
+	}
+	const int dx = abs(q->Pos.x - r->x);
+	const int dy = abs(q->Pos.y - r->y);
+	if (dx >= item->w + r->w || dy >= item->h + r->h)
+	{
+		return false;
+	}
+	return dx <= abs(item->x - r->x) || dy <= abs(item->y - r->y);
+}
+
+// Visit the records colliding with a query, in the order of the tiles
+// around the query position; stop if the visitor returns false
+typedef bool (*SpatialRecordFunc)(const SpatialRecord *, void *);
+static void QueryRecords(
+	const SpatialHash *h, const SpatialQuery *q,
+	SpatialRecordFunc func, void *data)
+{
+	const Vec2i tv = Vec2iToTile(q->Pos);
+	Vec2i dv;
+	for (dv.y = -1; dv.y <= 1; dv.y++)
+	{
+		for (dv.x = -1; dv.x <= 1; dv.x++)
+		{
+			const CArray *cell = GetCell(h, Vec2iAdd(tv, dv));
+			if (cell == NULL)
+			{
+				continue;
+			}
+			const SpatialRecord *r = cell->data;
+			for (int i = 0; i < (int)cell->size; i++, r++)
+			{
+				if (RecordCollides(r, q) && !func(r, data))
+				{
+					return;
+				}
+			}
+		}
+	}
+}
+
+static bool SetFirstFunc(const SpatialRecord *r, void *data)
+{
+	*(ThingId *)data = r->thing;
+	return false;
+}
+TTileItem *SpatialHashGetFirst(const SpatialHash *h, const SpatialQuery *q)
+{
+	ThingId tid;
+	tid.Id = -1;
+	QueryRecords(h, q, SetFirstFunc, &tid);
+	return tid.Id >= 0 ? ThingIdGetTileItem(&tid) : NULL;
+}
+
+static bool AppendFunc(const SpatialRecord *r, void *data)
+{
+	CArrayPushBack(data, &r->thing);
+	return true;
+}
+void SpatialHashGetAll(
+	const SpatialHash *h, const SpatialQuery *q, CArray *results)
+{
+	QueryRecords(h, q, AppendFunc, results);
+}
+
+void SpatialHashGetFirstBatch(
+	const SpatialHash *h, const SpatialQuery *queries, const int n,
+	ThingId *results)
+{
+	for (int i = 0; i < n; i++)
+	{
+		results[i].Id = -1;
+		QueryRecords(h, &queries[i], SetFirstFunc, &results[i]);
+	}
+}
@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __SPATIAL_HASH
+#define __SPATIAL_HASH
+
+#include <stdbool.h>
+
+#include "c_array.h"
+#include "tile.h"
+#include "vector.h"
+
+// Which "team" the actor's on, for collision
+// Actors on the same team don't have to collide
+typedef enum
+{
+	COLLISIONTEAM_NONE,
+	COLLISIONTEAM_GOOD,
+	COLLISIONTEAM_BAD
+} CollisionTeam;
+
+// Collision broad-phase: a uniform grid with one cell per map tile.
+// Each cell holds compact copies of the position, size, flags and team of
+// the collidable things on that tile, so that overlap queries don't have
+// to look up the things themselves.
+// Only characters and objects are stored; bullets and particles are never
+// collision targets.
+// Records in a cell are kept in the order they were added to the tile,
+// so queries find things in a stable order.
+typedef struct
+{
+	int x, y;
+	int w, h;
+	int flags;
+	CollisionTeam team;
+	ThingId thing;
+} SpatialRecord;
+
+typedef struct
+{
+	Vec2i Size;
+	CArray Cells;	// of CArray of SpatialRecord
+} SpatialHash;
+
+typedef struct
+{
+	const TTileItem *Item;	// the thing doing the colliding
+	Vec2i Pos;	// real position to test the item at
+	int Mask;	// only collide with things with any of these flags
+	CollisionTeam Team;
+	bool IsDogfight;
+} SpatialQuery;
+
+void SpatialHashInit(SpatialHash *h, const Vec2i size);
+void SpatialHashTerminate(SpatialHash *h);
+
+// Keep the records in sync with tile items;
+// call these whenever an item moves, or its flags or team change
+void SpatialHashAdd(SpatialHash *h, const TTileItem *t);
+void SpatialHashRemove(SpatialHash *h, const TTileItem *t);
+void SpatialHashUpdate(SpatialHash *h, const TTileItem *t);
+
+// Get the first thing colliding, or NULL if none
+TTileItem *SpatialHashGetFirst(const SpatialHash *h, const SpatialQuery *q);
+// Append all colliding things to a CArray of ThingId
+void SpatialHashGetAll(
+	const SpatialHash *h, const SpatialQuery *q, CArray *results);
+// Run many queries at once; for each query, store the first colliding
+// thing, or a ThingId with Id -1 if none
+void SpatialHashGetFirstBatch(
+	const SpatialHash *h, const SpatialQuery *queries, const int n,
+	ThingId *results);
+
+#endif
@@ -0,0 +1,199 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "thread_pool.h"
+
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "utils.h"
+
+
+static int GetNumProcessors(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	return 1;
+#endif
+}
+int ThreadPoolNumThreads(const int setting)
+{
+	if (setting > 0)
+	{
+		return setting;
+	}
+	static int numDefault = 0;
+	if (numDefault == 0)
+	{
+		const int n = GetNumProcessors();
+		numDefault = CLAMP(n, 1, THREAD_POOL_DEFAULT_MAX);
+	}
+	return numDefault;
+}
+
+
+static int WorkerMain(void *data);
+void ThreadPoolInit(ThreadPool *p, const int numThreads)
+{
+	memset(p, 0, sizeof *p);
+	p->NumThreads = 1;
+	CArrayInit(&p->Workers, sizeof(ThreadPoolWorker));
+	if (numThreads <= 1)
+	{
+		return;
+	}
+	p->Mutex = SDL_CreateMutex();
+	p->Start = SDL_CreateCond();
+	p->Done = SDL_CreateCond();
+	if (p->Mutex == NULL || p->Start == NULL || p->Done == NULL)
+	{
+		debug(D_NORMAL, "Cannot create thread pool: %s\n", SDL_GetError());
+		return;
+	}
+	// Workers are handed pointers into the array, so it must not move
+	CArrayReserve(&p->Workers, numThreads - 1);
+	for (int i = 1; i < numThreads; i++)
+	{
+		ThreadPoolWorker w;
+		w.Pool = p;
+		w.Index = i;
+		w.Thread = NULL;
+		CArrayPushBack(&p->Workers, &w);
+		ThreadPoolWorker *wp = CArrayGet(&p->Workers, i - 1);
+		wp->Thread = SDL_CreateThread(WorkerMain, wp);
+		if (wp->Thread == NULL)
+		{
+			debug(D_NORMAL, "Cannot create thread: %s\n", SDL_GetError());
+			p->Workers.size--;
+			break;
+		}
+	}
+	p->NumThreads = (int)p->Workers.size + 1;
+}
+void ThreadPoolTerminate(ThreadPool *p)
+{
+	if (p->Mutex != NULL)
+	{
+		SDL_LockMutex(p->Mutex);
+		p->Quit = true;
+		SDL_CondBroadcast(p->Start);
+		SDL_UnlockMutex(p->Mutex);
+	}
+	for (int i = 0; i < (int)p->Workers.size; i++)
+	{
+		ThreadPoolWorker *w = CArrayGet(&p->Workers, i);
+		SDL_WaitThread(w->Thread, NULL);
+	}
+	CArrayTerminate(&p->Workers);
+	if (p->Start != NULL)
+	{
+		SDL_DestroyCond(p->Start);
+	}
+	if (p->Done != NULL)
+	{
+		SDL_DestroyCond(p->Done);
+	}
+	if (p->Mutex != NULL)
+	{
+		SDL_DestroyMutex(p->Mutex);
+	}
+	memset(p, 0, sizeof *p);
+}
+
+static void RunStride(ThreadPool *p, const int worker)
+{
+	for (int i = worker; i < p->Count; i += p->NumThreads)
+	{
+		p->Func(p->Data, i, worker);
+	}
+}
+static int WorkerMain(void *data)
+{
+	ThreadPoolWorker *w = data;
+	ThreadPool *p = w->Pool;
+	unsigned int generation = 0;
+	SDL_LockMutex(p->Mutex);
+	for (;;)
+	{
+		while (!p->Quit && p->Generation == generation)
+		{
+			SDL_CondWait(p->Start, p->Mutex);
+		}
+		if (p->Quit)
+		{
+			break;
+		}
+		generation = p->Generation;
+		SDL_UnlockMutex(p->Mutex);
+		RunStride(p, w->Index);
+		SDL_LockMutex(p->Mutex);
+		p->Busy--;
+		if (p->Busy == 0)
+		{
+			SDL_CondSignal(p->Done);
+		}
+	}
+	SDL_UnlockMutex(p->Mutex);
+	return 0;
+}
+
+void ThreadPoolRun(
+	ThreadPool *p, const int count, ThreadPoolFunc func, void *data)
+{
+	if (p->Workers.size == 0)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			func(data, i, 0);
+		}
+		return;
+	}
+	SDL_LockMutex(p->Mutex);
+	p->Func = func;
+	p->Data = data;
+	p->Count = count;
+	p->Busy = (int)p->Workers.size;
+	p->Generation++;
+	SDL_CondBroadcast(p->Start);
+	SDL_UnlockMutex(p->Mutex);
+
+	RunStride(p, 0);
+
+	SDL_LockMutex(p->Mutex);
+	while (p->Busy > 0)
+	{
+		SDL_CondWait(p->Done, p->Mutex);
+	}
+	SDL_UnlockMutex(p->Mutex);
+}
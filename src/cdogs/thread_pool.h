@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __THREAD_POOL
+#define __THREAD_POOL
+
+#include <stdbool.h>
+
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+#include "c_array.h"
+
+// Fixed set of worker threads for running a loop's iterations in parallel.
+// Iterations are handed out in a fixed stride - worker w runs iterations
+// w, w + n, w + 2n... - so which worker runs which iteration only depends
+// on the number of threads, and the calling thread takes part as worker 0.
+// Runs block until all iterations are done.
+typedef void (*ThreadPoolFunc)(void *data, const int index, const int worker);
+struct ThreadPool;
+typedef struct
+{
+	struct ThreadPool *Pool;
+	int Index;
+	SDL_Thread *Thread;
+} ThreadPoolWorker;
+typedef struct ThreadPool
+{
+	int NumThreads;	// including the calling thread
+	CArray Workers;	// of ThreadPoolWorker, one per extra thread
+	SDL_mutex *Mutex;
+	SDL_cond *Start;
+	SDL_cond *Done;
+	// Current run; only changed while all the workers are idle
+	ThreadPoolFunc Func;
+	void *Data;
+	int Count;
+	unsigned int Generation;	// bumped to start a run
+	int Busy;	// workers yet to finish the current run
+	bool Quit;
+} ThreadPool;
+
+// Number of threads for a setting: the setting itself if it's positive,
+// otherwise one per processor up to THREAD_POOL_DEFAULT_MAX, as the loops
+// run on pools are too short to be worth splitting further
+#define THREAD_POOL_DEFAULT_MAX 4
+int ThreadPoolNumThreads(const int setting);
+
+// Create the extra threads; with one thread, runs happen in the caller
+void ThreadPoolInit(ThreadPool *p, const int numThreads);
+void ThreadPoolTerminate(ThreadPool *p);
+
+// Call func for each index in [0, count), and wait for them all
+void ThreadPoolRun(
+	ThreadPool *p, const int count, ThreadPoolFunc func, void *data);
+
+#endif
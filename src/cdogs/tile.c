@@ -50,36 +50,26 @@
 
 #include "actors.h"
 #include "objs.h"
-#include "triggers.h"
 
 
+// For tiles outside the map
+static CArray sNoThings;
+
 Tile TileNone(void)
 {
 	Tile t;
 	memset(&t, 0, sizeof t);
 	t.pic = &picNone;
+	t.picAlt = &picNone;
 	t.flags = MAPTILE_NO_WALK | MAPTILE_IS_NOTHING;
+	t.things = &sNoThings;
 	return t;
 }
-void TileInit(Tile *t)
+void TilePicsInit(TilePics *t)
 {
-	memset(t, 0, sizeof *t);
-	// lazy initialise the arrays of triggers
-	// it's very slow to do 128x128 mallocs!
 	t->pic = &picNone;
 	t->picAlt = picNone;
 }
-void TileDestroy(Tile *t)
-{
-	if (t->triggers.elemSize > 0)
-	{
-		CArrayTerminate(&t->triggers);
-	}
-	if (t->things.elemSize > 0)
-	{
-		CArrayTerminate(&t->things);
-	}
-}
 
 bool IsTileItemInsideTile(TTileItem *i, Vec2i tilePos)
 {
@@ -90,7 +80,7 @@ bool IsTileItemInsideTile(TTileItem *i, Vec2i tilePos)
 		i->y + i->h < (tilePos.y + 1) * TILE_HEIGHT;
 }
 
-bool TileCanSee(Tile *t)
+bool TileCanSee(const Tile *t)
 {
 	return !(t->flags & MAPTILE_NO_SEE);
 }
@@ -98,19 +88,19 @@ bool TileCanWalk(const Tile *t)
 {
 	return !(t->flags & MAPTILE_NO_WALK);
 }
-bool TileIsNormalFloor(Tile *t)
+bool TileIsNormalFloor(const Tile *t)
 {
 	return t->flags & MAPTILE_IS_NORMAL_FLOOR;
 }
-bool TileIsClear(Tile *t)
+bool TileIsClear(const Tile *t)
 {
-	return t->things.size == 0;
+	return t->things->size == 0;
 }
-bool TileHasCharacter(Tile *t)
+bool TileHasCharacter(const Tile *t)
 {
-	for (int i = 0; i < (int)t->things.size; i++)
+	for (int i = 0; i < (int)t->things->size; i++)
 	{
-		ThingId *tid = CArrayGet(&t->things, i);
+		const ThingId *tid = CArrayGet(t->things, i);
 		if (tid->Kind == KIND_CHARACTER)
 		{
 			return true;
@@ -119,13 +109,6 @@ bool TileHasCharacter(Tile *t)
 	return false;
 }
 
-void TileSetAlternateFloor(Tile *t, Pic *p)
-{
-	t->pic = p;
-	t->flags &= ~MAPTILE_IS_NORMAL_FLOOR;
-}
-
-
 TTileItem *ThingIdGetTileItem(ThingId *tid)
 {
 	TTileItem *ti = NULL;
@@ -135,14 +118,15 @@ TTileItem *ThingIdGetTileItem(ThingId *tid)
 		ti = &((TActor *)CArrayGet(&gActors, tid->Id))->tileItem;
 		break;
 	case KIND_PARTICLE:
-		ti = &((Particle *)CArrayGet(&gParticles, tid->Id))->tileItem;
+		ti = &((Particle *)CPoolGet(
+			&gParticles.Pool, tid->Id))->tileItem;
 		break;
 	case KIND_MOBILEOBJECT:
-		ti = &((TMobileObject *)CArrayGet(
+		ti = &((TMobileObject *)CPoolGet(
 			&gMobObjs, tid->Id))->tileItem;
 		break;
 	case KIND_OBJECT:
-		ti = &((TObject *)CArrayGet(&gObjs, tid->Id))->tileItem;
+		ti = &((TObject *)CPoolGet(&gObjs, tid->Id))->tileItem;
 		break;
 	default:
 		CASSERT(false, "unknown tile item to get");
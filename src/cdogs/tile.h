@@ -132,6 +132,8 @@ typedef void (*TileItemDrawFunc)(const Vec2i, const TileItemDrawFuncData *);
 typedef struct TileItem
 {
 	int x, y;
+	Vec2i LastPos;	// real position at the start of the sim tick
+	int ThingIndex;	// where this item is in its tile's things list
 	int w, h;
 	TileItemKind kind;
 	int id;	// Id of item (actor, mobobj or obj)
@@ -151,27 +153,32 @@ typedef struct
 	int Id;
 	TileItemKind Kind;
 } ThingId;
+// Pics used to draw a tile; stored apart from the other tile data
 typedef struct
 {
 	Pic *pic;
 	Pic picAlt;
+} TilePics;
+// A copy of one tile's data, gathered from the map's separate arrays
+// Use for reading several kinds of tile data at once, e.g. for drawing
+typedef struct
+{
+	Pic *pic;
+	const Pic *picAlt;
 	int flags;
 	bool isVisited;
-	CArray triggers;	// of Trigger *
-	CArray things;		// of ThingId
+	const CArray *things;	// of ThingId
 } Tile;
 
 
 Tile TileNone(void);
-void TileInit(Tile *t);
-void TileDestroy(Tile *t);
+void TilePicsInit(TilePics *t);
 bool IsTileItemInsideTile(TTileItem *i, Vec2i tilePos);
-bool TileCanSee(Tile *t);
+bool TileCanSee(const Tile *t);
 bool TileCanWalk(const Tile *t);
-bool TileIsNormalFloor(Tile *t);
-bool TileIsClear(Tile *t);
-bool TileHasCharacter(Tile *t);
-void TileSetAlternateFloor(Tile *t, Pic *p);
+bool TileIsNormalFloor(const Tile *t);
+bool TileIsClear(const Tile *t);
+bool TileHasCharacter(const Tile *t);
 
 TTileItem *ThingIdGetTileItem(ThingId *tid);
 
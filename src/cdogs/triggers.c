@@ -200,10 +200,11 @@ static void ActionRun(Action *a, CArray *mapTriggers)
 
 	case ACTION_CHANGETILE:
 		{
-			Tile *t= MapGetTile(&gMap, a->u.pos);
-			t->flags = a->a.tileFlags;
+			TilePics *t = MapGetTilePics(&gMap, a->u.pos);
+			MapSetTileFlags(&gMap, a->u.pos, a->a.tileFlags);
 			t->pic = a->tilePic;
 			t->picAlt = a->tilePicAlt;
+			MapMarkTilePicsChanged(&gMap, a->u.pos);
 		}
 		break;
 
@@ -226,7 +227,7 @@ static int ConditionsMet(CArray *conditions)
 		switch (c->condition)
 		{
 		case CONDITION_TILECLEAR:
-			if (!TileIsClear(MapGetTile(&gMap, c->pos)))
+			if (MapGetTileThings(&gMap, c->pos)->size > 0)
 			{
 				return 0;
 			}
@@ -0,0 +1,272 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "visibility.h"
+
+#include <string.h>
+
+#include "algorithms.h"
+
+VisibilityCache gVisibility;
+
+
+void VisibilityCacheInit(VisibilityCache *c)
+{
+	memset(c, 0, sizeof *c);
+	for (int i = 0; i < VISIBILITY_CACHE_SIZE; i++)
+	{
+		CArrayInit(&c->Views[i].Visible, sizeof(unsigned char));
+	}
+}
+void VisibilityCacheTerminate(VisibilityCache *c)
+{
+	for (int i = 0; i < VISIBILITY_CACHE_SIZE; i++)
+	{
+		CArrayTerminate(&c->Views[i].Visible);
+	}
+	memset(c, 0, sizeof *c);
+}
+
+bool VisibilityViewContains(const VisibilityView *v, const Vec2i tile)
+{
+	return
+		tile.x >= v->Origin.x && tile.x < v->Origin.x + v->Size.x &&
+		tile.y >= v->Origin.y && tile.y < v->Origin.y + v->Size.y;
+}
+bool VisibilityViewIsVisible(const VisibilityView *v, const Vec2i tile)
+{
+	if (!VisibilityViewContains(v, tile))
+	{
+		return false;
+	}
+	const int i =
+		(tile.y - v->Origin.y) * v->Size.x + tile.x - v->Origin.x;
+	return *(unsigned char *)CArrayGet(&v->Visible, i);
+}
+
+// The view is computed in window coordinates, where (0, 0) is the
+// window's origin, so that the rays are exactly the ones that used to be
+// cast across the draw buffer
+typedef struct
+{
+	Map *Map;
+	VisibilityView *View;
+	Vec2i Center;
+	int SightRange2;
+} LOSData;
+static bool IsInWindow(const VisibilityView *v, const Vec2i pos)
+{
+	return pos.x >= 0 && pos.x < v->Size.x && pos.y >= 0 && pos.y < v->Size.y;
+}
+// Tiles off the map don't block sight, like the empty tiles around the
+// map in the draw buffer
+static bool IsObstruction(const LOSData *data, const Vec2i pos)
+{
+	const Vec2i tile = Vec2iAdd(pos, data->View->Origin);
+	return MapIsTileIn(data->Map, tile) && BitGridGet(&data->Map->NoSee, tile);
+}
+static unsigned char *GetVisible(VisibilityView *v, const Vec2i pos)
+{
+	return CArrayGet(&v->Visible, pos.y * v->Size.x + pos.x);
+}
+static bool IsNextTileBlockedAndSetVisibility(void *data, Vec2i pos)
+{
+	LOSData *lData = data;
+	// Check sight range
+	if (lData->SightRange2 > 0 &&
+		DistanceSquared(lData->Center, pos) >= lData->SightRange2)
+	{
+		return true;
+	}
+	// Check window range
+	if (!IsInWindow(lData->View, pos))
+	{
+		return true;
+	}
+	*GetVisible(lData->View, pos) = 1;
+	// Check if this tile is an obstruction
+	return IsObstruction(lData, pos);
+}
+static bool IsTileVisibleNonObstruction(const LOSData *data, const Vec2i pos)
+{
+	return IsInWindow(data->View, pos) &&
+		!IsObstruction(data, pos) && *GetVisible(data->View, pos);
+}
+static bool IsNextToVisibleNonObstruction(const LOSData *data, const Vec2i pos)
+{
+	Vec2i d;
+	for (d.x = -1; d.x < 2; d.x++)
+	{
+		for (d.y = -1; d.y < 2; d.y++)
+		{
+			if (IsTileVisibleNonObstruction(data, Vec2iAdd(pos, d)))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+// Perform LOS by casting rays from the centre to the edges, terminating
+// whenever an obstruction or out-of-range is reached.
+static void Compute(VisibilityView *v, Map *map)
+{
+	LOSData data;
+	data.Map = map;
+	data.View = v;
+	data.Center = Vec2iMinus(v->Viewer, v->Origin);
+	data.SightRange2 = v->SightRange * v->SightRange;
+	CArrayClear(&v->Visible);
+	const unsigned char zero = 0;
+	for (int i = 0; i < v->Size.x * v->Size.y; i++)
+	{
+		CArrayPushBack(&v->Visible, &zero);
+	}
+
+	// First mark center tile and all adjacent tiles as visible
+	// +-+-+-+
+	// |V|V|V|
+	// +-+-+-+
+	// |V|C|V|
+	// +-+-+-+
+	// |V|V|V|  (C=center, V=visible)
+	// +-+-+-+
+	Vec2i end;
+	for (end.x = data.Center.x - 1; end.x < data.Center.x + 2; end.x++)
+	{
+		for (end.y = data.Center.y - 1; end.y < data.Center.y + 2; end.y++)
+		{
+			if (IsInWindow(v, end))
+			{
+				*GetVisible(v, end) = 1;
+			}
+		}
+	}
+
+	// Work out the perimeter of the LOS casts
+	Vec2i origin = Vec2iZero();
+	if (v->SightRange > 0)
+	{
+		// Limit the perimeter to the sight range
+		origin.x = MAX(origin.x, data.Center.x - v->SightRange);
+		origin.y = MAX(origin.y, data.Center.y - v->SightRange);
+	}
+	const Vec2i perimSize = Vec2iScale(Vec2iMinus(data.Center, origin), 2);
+
+	// Start from the top-left cell, and proceed clockwise around
+	end = origin;
+	HasClearLineData lineData;
+	lineData.IsBlocked = IsNextTileBlockedAndSetVisibility;
+	lineData.data = &data;
+	// Top edge
+	for (; end.x < origin.x + perimSize.x; end.x++)
+	{
+		HasClearLineXiaolinWu(data.Center, end, &lineData);
+	}
+	// right edge
+	for (; end.y < origin.y + perimSize.y; end.y++)
+	{
+		HasClearLineXiaolinWu(data.Center, end, &lineData);
+	}
+	// bottom edge
+	for (; end.x > origin.x; end.x--)
+	{
+		HasClearLineXiaolinWu(data.Center, end, &lineData);
+	}
+	// left edge
+	for (; end.y > origin.y; end.y--)
+	{
+		HasClearLineXiaolinWu(data.Center, end, &lineData);
+	}
+
+	// Second pass: make any non-visible obstructions that are adjacent to
+	// visible non-obstructions visible too
+	// This is to ensure runs of walls stay visible
+	for (end.y = origin.y; end.y < origin.y + perimSize.y; end.y++)
+	{
+		for (end.x = origin.x; end.x < origin.x + perimSize.x; end.x++)
+		{
+			if (!IsInWindow(v, end) || !IsObstruction(&data, end))
+			{
+				continue;
+			}
+			// Check sight range
+			if (data.SightRange2 > 0 &&
+				DistanceSquared(data.Center, end) >= data.SightRange2)
+			{
+				continue;
+			}
+			if (IsNextToVisibleNonObstruction(&data, end))
+			{
+				*GetVisible(v, end) = 1;
+			}
+		}
+	}
+}
+
+static bool IsMatch(
+	const VisibilityView *v, const Map *map, const Vec2i viewer,
+	const Vec2i origin, const Vec2i size, const int sightRange)
+{
+	return v->IsValid &&
+		Vec2iEqual(v->Viewer, viewer) &&
+		Vec2iEqual(v->Origin, origin) &&
+		Vec2iEqual(v->Size, size) &&
+		v->Revision == map->TileFlagsRevision &&
+		v->SightRange == sightRange;
+}
+const VisibilityView *VisibilityGet(
+	VisibilityCache *c, Map *map, const Vec2i viewer, const Vec2i origin,
+	const Vec2i size, const int sightRange)
+{
+	c->Clock++;
+	VisibilityView *oldest = &c->Views[0];
+	for (int i = 0; i < VISIBILITY_CACHE_SIZE; i++)
+	{
+		VisibilityView *v = &c->Views[i];
+		if (IsMatch(v, map, viewer, origin, size, sightRange))
+		{
+			v->LastUsed = c->Clock;
+			return v;
+		}
+		if (!v->IsValid ||
+			(oldest->IsValid && v->LastUsed < oldest->LastUsed))
+		{
+			oldest = v;
+		}
+	}
+
+	// Not cached; replace the least recently used view
+	VisibilityView *v = oldest;
+	v->IsValid = true;
+	v->Viewer = viewer;
+	v->Revision = map->TileFlagsRevision;
+	v->SightRange = sightRange;
+	v->Origin = origin;
+	v->Size = size;
+	v->LastUsed = c->Clock;
+	Compute(v, map);
+	return v;
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (c) 2014, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __VISIBILITY
+#define __VISIBILITY
+
+#include <stdbool.h>
+
+#include "c_array.h"
+#include "map.h"
+#include "vector.h"
+
+// Cache of fields of view, so that they aren't recomputed every frame
+// while viewers stay on the same tile.
+// A view is keyed on the viewer's tile, the map's tile flags revision
+// (bumped by doors opening and other tile changes), the sight range and
+// the window of tiles it covers; rays are cast from the viewer to the
+// window's edges, as DrawBufferLOS used to do across the draw buffer, so
+// the window changes what is visible near its edges.
+// Views are a pure function of their key, so what has been drawn never
+// changes what the game gets back.
+#define VISIBILITY_CACHE_SIZE 8
+typedef struct
+{
+	bool IsValid;
+	Vec2i Viewer;	// tile
+	int Revision;
+	int SightRange;	// in tiles; 0 for unlimited
+	Vec2i Origin;	// map tile of the window's first cell
+	Vec2i Size;	// of the window, in tiles
+	CArray Visible;	// of unsigned char, one per cell
+	unsigned int LastUsed;
+} VisibilityView;
+typedef struct
+{
+	VisibilityView Views[VISIBILITY_CACHE_SIZE];
+	unsigned int Clock;
+} VisibilityCache;
+extern VisibilityCache gVisibility;
+
+void VisibilityCacheInit(VisibilityCache *c);
+void VisibilityCacheTerminate(VisibilityCache *c);
+
+// Get the field of view from a tile, within the window of tiles starting
+// at origin; computes it if it's not in the cache.
+// This updates the cache, so call it only from the main thread; the AI
+// doesn't use it, as its line of sight checks are per pixel, not per tile.
+const VisibilityView *VisibilityGet(
+	VisibilityCache *c, Map *map, const Vec2i viewer, const Vec2i origin,
+	const Vec2i size, const int sightRange);
+// Whether the tile is covered by the view, i.e. within its window
+bool VisibilityViewContains(const VisibilityView *v, const Vec2i tile);
+bool VisibilityViewIsVisible(const VisibilityView *v, const Vec2i tile);
+
+#endif
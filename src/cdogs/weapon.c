@@ -57,6 +57,7 @@
 #include "game_events.h"
 #include "json_utils.h"
 #include "objs.h"
+#include "rng.h"
 #include "sounds.h"
 
 GunClasses gGunDescriptions;
@@ -427,8 +428,7 @@ void GunAddBullets(
 		double recoil = 0;
 		if (g->Recoil > 0)
 		{
-			recoil =
-				((double)rand() / RAND_MAX * g->Recoil) - g->Recoil / 2;
+			recoil = RngDouble(&gRngSim, -g->Recoil / 2, g->Recoil / 2);
 		}
 		double finalAngle = radians + spreadAngle + recoil;
 		GameEvent e;
@@ -438,7 +438,8 @@ void GunAddBullets(
 		e.u.AddBullet.MuzzlePos = fullPos;
 		e.u.AddBullet.MuzzleHeight = z;
 		e.u.AddBullet.Angle = finalAngle;
-		e.u.AddBullet.Elevation = RAND_INT(g->ElevationLow, g->ElevationHigh);
+		e.u.AddBullet.Elevation = RngRange(
+			&gRngSim, g->ElevationLow, g->ElevationHigh);
 		e.u.AddBullet.Flags = flags;
 		e.u.AddBullet.PlayerIndex = player;
 		e.u.AddBullet.UID = uid;
@@ -486,11 +487,11 @@ static void AddBrass(
 	e.u.AddParticle.Z = g->MuzzleHeight;
 	e.u.AddParticle.Vel = Vec2iScaleDiv(
 		GetFullVectorsForRadians(radians + PI / 2), 3);
-	e.u.AddParticle.Vel.x += (rand() % 128) - 64;
-	e.u.AddParticle.Vel.y += (rand() % 128) - 64;
-	e.u.AddParticle.Angle = RAND_DOUBLE(0, PI * 2);
-	e.u.AddParticle.DZ = (rand() % 6) + 6;
-	e.u.AddParticle.Spin = RAND_DOUBLE(-0.1, 0.1);
+	e.u.AddParticle.Vel.x += RngRange(&gRngCosmetic, -64, 64);
+	e.u.AddParticle.Vel.y += RngRange(&gRngCosmetic, -64, 64);
+	e.u.AddParticle.Angle = RngDouble(&gRngCosmetic, 0, PI * 2);
+	e.u.AddParticle.DZ = RngRange(&gRngCosmetic, 6, 12);
+	e.u.AddParticle.Spin = RngDouble(&gRngCosmetic, -0.1, 0.1);
 	GameEventsEnqueue(&gGameEvents, e);
 }
 
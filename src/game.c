@@ -56,11 +56,14 @@
 
 #include <SDL.h>
 
+#include <cdogs/activity.h>
 #include <cdogs/actors.h>
 #include <cdogs/ai.h>
 #include <cdogs/ai_coop.h>
+#include <cdogs/ai_utils.h>
 #include <cdogs/automap.h>
 #include <cdogs/config.h>
+#include <cdogs/demo.h>
 #include <cdogs/draw.h>
 #include <cdogs/events.h>
 #include <cdogs/game_events.h>
@@ -75,13 +78,15 @@
 #include <cdogs/pic_manager.h>
 #include <cdogs/pics.h>
 #include <cdogs/screen_shake.h>
+#include <cdogs/sim_checksum.h>
 #include <cdogs/triggers.h>
+#include <cdogs/visibility.h>
 
 #include <cdogs/drawtools.h> /* for Draw_Box and Draw_Point */
 
 #include "handle_game_events.h"
 
-#define MAX_FRAMESKIP	(FPS_FRAMELIMIT / 5)
+#define MAX_SIM_TICKS_PER_FRAME	(FPS_FRAMELIMIT / 5)
 
 #define SPLIT_PADDING 40
 
@@ -89,6 +94,86 @@
 #define MICROSECS_PER_SEC 1000000
 #define MILLISECS_PER_SEC 1000
 
+HeadlessOptions gHeadless = { false, 0 };
+
+// Per-subsystem simulation timers, reported when running headless
+typedef enum
+{
+	SIM_TIMER_PLAYERS,
+	SIM_TIMER_BAD_GUYS,
+	SIM_TIMER_ACTORS,
+	SIM_TIMER_MOBILE_OBJECTS,
+	SIM_TIMER_PARTICLES,
+	SIM_TIMER_WATCHES,
+	SIM_TIMER_EVENTS,
+	SIM_TIMER_OTHER,
+	SIM_TIMER_COUNT
+} SimTimer;
+static const char *simTimerNames[SIM_TIMER_COUNT] =
+{
+	"Players",
+	"CommandBadGuys",
+	"UpdateAllActors",
+	"UpdateMobileObjects",
+	"ParticlesUpdate",
+	"UpdateWatches",
+	"HandleGameEvents",
+	"Other"
+};
+typedef struct
+{
+	bool Enabled;
+	int Ticks;
+	Uint64 Start;
+	Uint64 Last;
+	Uint64 Elapsed[SIM_TIMER_COUNT];
+} SimTimers;
+static Uint64 GetMicroseconds(void)
+{
+#ifdef _MSC_VER
+	return (Uint64)SDL_GetTicks() * (MICROSECS_PER_SEC / MILLISECS_PER_SEC);
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (Uint64)tv.tv_sec * MICROSECS_PER_SEC + tv.tv_usec;
+#endif
+}
+static void SimTimersInit(SimTimers *t, const bool enabled)
+{
+	memset(t, 0, sizeof *t);
+	t->Enabled = enabled;
+	if (enabled)
+	{
+		t->Start = t->Last = GetMicroseconds();
+	}
+}
+// Attribute the time since the last lap to a subsystem
+static void SimTimersLap(SimTimers *t, const SimTimer timer)
+{
+	if (!t->Enabled)
+	{
+		return;
+	}
+	const Uint64 now = GetMicroseconds();
+	t->Elapsed[timer] += now - t->Last;
+	t->Last = now;
+}
+static void SimTimersPrint(const SimTimers *t)
+{
+	const Uint64 total = MAX(GetMicroseconds() - t->Start, 1);
+	printf("Headless: %d ticks in %.3fs (%.1f ticks/sec)\n",
+		t->Ticks, (double)total / MICROSECS_PER_SEC,
+		(double)t->Ticks * MICROSECS_PER_SEC / total);
+	for (int i = 0; i < SIM_TIMER_COUNT; i++)
+	{
+		printf("    %-20s %10.3fms %6.2f%% %8.2fus/tick\n",
+			simTimerNames[i],
+			(double)t->Elapsed[i] / MILLISECS_PER_SEC,
+			100.0 * t->Elapsed[i] / total,
+			(double)t->Elapsed[i] / MAX(t->Ticks, 1));
+	}
+}
+
 static void PlayerSpecialCommands(TActor *actor, const int cmd)
 {
 	int isDirectionCmd = cmd & (CMD_LEFT | CMD_RIGHT | CMD_UP | CMD_DOWN);
@@ -447,31 +532,418 @@ Vec2i GetPlayerCenter(GraphicsDevice *device, DrawBuffer *b, int player)
 	return center;
 }
 
+// Render interpolation: the real positions of moving things are saved at the
+// start of every sim tick, and each drawn frame blends between the saved
+// and current positions by how far we are into the next tick
+typedef void (*TileItemFunc)(TTileItem *t, void *data);
+static void ForEachMovingTileItem(TileItemFunc func, void *data)
+{
+	for (int i = 0; i < (int)gActors.size; i++)
+	{
+		TActor *a = CArrayGet(&gActors, i);
+		if (a->isInUse)
+		{
+			func(&a->tileItem, data);
+		}
+	}
+	for (int i = 0; i < CPoolLiveCount(&gMobObjs); i++)
+	{
+		TMobileObject *m = CPoolGetLive(&gMobObjs, i);
+		func(&m->tileItem, data);
+	}
+	for (int i = 0; i < CPoolLiveCount(&gParticles.Pool); i++)
+	{
+		Particle *p = CPoolGetLive(&gParticles.Pool, i);
+		func(&p->tileItem, data);
+	}
+}
+static void SaveLastPos(TTileItem *t, void *data)
+{
+	UNUSED(data);
+	t->LastPos = Vec2iNew(t->x, t->y);
+}
+typedef struct
+{
+	CArray *Saved;	// of Vec2i
+	int Index;
+	int Alpha;
+	int AlphaMax;
+} InterpolateData;
+static void InterpolatePos(TTileItem *t, void *data)
+{
+	InterpolateData *d = data;
+	Vec2i pos = Vec2iNew(t->x, t->y);
+	CArrayPushBack(d->Saved, &pos);
+	t->x = t->LastPos.x + (pos.x - t->LastPos.x) * d->Alpha / d->AlphaMax;
+	t->y = t->LastPos.y + (pos.y - t->LastPos.y) * d->Alpha / d->AlphaMax;
+}
+static void RestorePos(TTileItem *t, void *data)
+{
+	InterpolateData *d = data;
+	const Vec2i *pos = CArrayGet(d->Saved, d->Index);
+	t->x = pos->x;
+	t->y = pos->y;
+	d->Index++;
+}
+
+// The last view each player explored from
+typedef struct
+{
+	bool IsValid;
+	Vec2i Viewer;
+	Vec2i Start;	// of the window explored
+	int Revision;	// of the map's tile flags
+	int SightRange;
+} ExploredView;
+typedef struct
+{
+	DrawBuffer Buffer;
+	HUD Hud;
+	ScreenShake Shake;
+	HealthPickups HP;
+	SimTimers Timers;
+	int IsPaused;
+	int Ticks;	// number of sim ticks, used for slow motion
+	ExploredView Explored[MAX_PLAYERS];
+} GameLoopData;
+
+// Mark the tiles the players can see as visited; exploring is part of the
+// game, as objectives and health pickups depend on it, so it mustn't
+// depend on what gets drawn
+// Each player explores what the draw buffer would show at the default
+// 320x240 resolution, if the screen were centred on them
+#define EXPLORE_WIDTH 21
+#define EXPLORE_HEIGHT 22
+static Vec2i GetExploreStart(const Vec2i pos)
+{
+	// As DrawBufferSetFromMap
+	const Vec2i top = Vec2iNew(
+		pos.x - TILE_WIDTH * EXPLORE_WIDTH / 2,
+		pos.y - TILE_HEIGHT * EXPLORE_HEIGHT / 2);
+	Vec2i start = Vec2iNew(top.x / TILE_WIDTH, top.y / TILE_HEIGHT);
+	if (top.x < 0)
+	{
+		start.x--;
+	}
+	if (top.y < 0)
+	{
+		start.y--;
+	}
+	return start;
+}
+static void MarkPlayersViewsVisited(ExploredView *explored)
+{
+	const int sightRange = gConfig.Game.SightRange;
+	const Vec2i size = Vec2iNew(EXPLORE_WIDTH, EXPLORE_HEIGHT);
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (!IsPlayerAlive(i))
+		{
+			continue;
+		}
+		const TActor *p = CArrayGet(&gActors, gPlayerIds[i]);
+		const Vec2i pos = Vec2iFull2Real(p->Pos);
+		const Vec2i viewer = Vec2iToTile(pos);
+		const Vec2i start = GetExploreStart(pos);
+		// Visiting is permanent, so nothing new is explored until the
+		// view moves or the walls change
+		ExploredView *e = &explored[i];
+		if (e->IsValid &&
+			Vec2iEqual(e->Viewer, viewer) &&
+			Vec2iEqual(e->Start, start) &&
+			e->Revision == gMap.TileFlagsRevision &&
+			e->SightRange == sightRange)
+		{
+			continue;
+		}
+		e->IsValid = true;
+		e->Viewer = viewer;
+		e->Start = start;
+		e->Revision = gMap.TileFlagsRevision;
+		e->SightRange = sightRange;
+		const VisibilityView *view = VisibilityGet(
+			&gVisibility, &gMap, viewer, start, size, sightRange);
+		Vec2i v;
+		for (v.y = start.y; v.y < start.y + size.y; v.y++)
+		{
+			for (v.x = start.x; v.x < start.x + size.x; v.x++)
+			{
+				if (MapIsTileIn(&gMap, v) && VisibilityViewIsVisible(view, v))
+				{
+					MapMarkAsVisited(&gMap, v);
+				}
+			}
+		}
+	}
+}
+
 static void MissionUpdateObjectives(struct MissionOptions *mo, Map *map);
+// Run one fixed-length simulation tick, including sampling input
+// Returns whether the automap was shown, which blocks the game
+static bool GameTick(GameLoopData *data, const Uint32 ticksNow)
+{
+	int cmds[MAX_PLAYERS];
+	int cmdAll = 0;
+	int ticks = 1;
+	int i;
+	int hasUsedMap = 0;
+
+	memset(cmds, 0, sizeof cmds);
+	ForEachMovingTileItem(SaveLastPos, NULL);
+
+	if (gHeadless.Enabled)
+	{
+		// All players are AI; only check for quit requests
+		EventPoll(&gEventHandlers, ticksNow);
+		if (gEventHandlers.HasQuit)
+		{
+			gMission.isDone = true;
+		}
+	}
+	else
+	{
+		EventPoll(&gEventHandlers, ticksNow);
+		if (gEventHandlers.HasQuit)
+		{
+			gMission.isDone = true;
+		}
+		for (i = 0; i < MAX_PLAYERS; i++)
+		{
+			if (IsPlayerAlive(i))
+			{
+				cmds[i] = GetGameCmd(
+					&gEventHandlers,
+					&gConfig.Input,
+					&gPlayerDatas[i],
+					GetPlayerCenter(&gGraphicsDevice, &data->Buffer, i));
+				cmdAll |= cmds[i];
+			}
+		}
+		int isEscPressed = HandleKey(
+			cmdAll, &data->IsPaused, &hasUsedMap, data->Hud.showExit);
+		if (isEscPressed)
+		{
+			if (data->IsPaused)
+			{
+				GameEvent e;
+				e.Type = GAME_EVENT_MISSION_END;
+				GameEventsEnqueue(&gGameEvents, e);
+				// Also explicitly set done
+				// otherwise game will not quit immediately
+				gMission.isDone = true;
+			}
+			else
+			{
+				data->IsPaused = 1;
+			}
+		}
+	}
+
+	if (data->IsPaused)
+	{
+		return hasUsedMap;
+	}
+
+	// Demos hold the players' commands for every unpaused tick;
+	// AI players are left to decide again, which they will do the same way
+	if (gDemo.Mode == DEMO_MODE_RECORD)
+	{
+		DemoRecordTick(&gDemo, cmds);
+	}
+	else if (gDemo.Mode == DEMO_MODE_REPLAY && !DemoReplayTick(&gDemo, cmds))
+	{
+		// End of the recording for this mission
+		gMission.isDone = true;
+		return hasUsedMap;
+	}
+
+	if (!gConfig.Game.SlowMotion || (data->Ticks & 1) == 0)
+	{
+		SimTimersLap(&data->Timers, SIM_TIMER_OTHER);
+		AIProximityUpdate();
+		ActivityUpdate(&gActivity, ticks);
+		for (i = 0; i < gOptions.numPlayers; i++)
+		{
+			if (!IsPlayerAlive(i))
+			{
+				continue;
+			}
+			TActor *player = CArrayGet(&gActors, gPlayerIds[i]);
+			if (gPlayerDatas[i].inputDevice == INPUT_DEVICE_AI)
+			{
+				cmds[i] = AICoopGetCmd(player, ticks);
+			}
+			PlayerSpecialCommands(player, cmds[i]);
+			CommandActor(player, cmds[i], ticks);
+		}
+		SimTimersLap(&data->Timers, SIM_TIMER_PLAYERS);
+
+		if (gOptions.badGuys)
+		{
+			// The players have moved
+			AIProximityUpdate();
+			CommandBadGuys();
+		}
+		SimTimersLap(&data->Timers, SIM_TIMER_BAD_GUYS);
+
+		// If split screen never and players are too close to the
+		// edge of the screen, forcefully pull them towards the center
+		if (gConfig.Interface.Splitscreen == SPLITSCREEN_NEVER &&
+			IsSingleScreen(
+				&gGraphicsDevice.cachedConfig,
+				gConfig.Interface.Splitscreen))
+		{
+			int w = gGraphicsDevice.cachedConfig.Res.x;
+			int h = gGraphicsDevice.cachedConfig.Res.y;
+			Vec2i screen = Vec2iAdd(
+				PlayersGetMidpoint(), Vec2iNew(-w / 2, -h / 2));
+			for (i = 0; i < gOptions.numPlayers; i++)
+			{
+				if (!IsPlayerAlive(i))
+				{
+					continue;
+				}
+				TActor *p = CArrayGet(&gActors, gPlayerIds[i]);
+				int pad = SPLIT_PADDING;
+				GameEvent ei;
+				ei.Type = GAME_EVENT_ACTOR_IMPULSE;
+				ei.u.ActorImpulse.Id = p->tileItem.id;
+				ei.u.ActorImpulse.Vel = p->Vel;
+				if (screen.x + pad > p->tileItem.x &&
+					p->Vel.x < 256)
+				{
+					ei.u.ActorImpulse.Vel.x = 256 - p->Vel.x;
+				}
+				else if (screen.x + w - pad < p->tileItem.x &&
+					p->Vel.x > -256)
+				{
+					ei.u.ActorImpulse.Vel.x = -256 - p->Vel.x;
+				}
+				if (screen.y + pad > p->tileItem.y &&
+					p->Vel.y < 256)
+				{
+					ei.u.ActorImpulse.Vel.y = 256 - p->Vel.y;
+				}
+				else if (screen.y + h - pad < p->tileItem.y &&
+					p->Vel.y > -256)
+				{
+					ei.u.ActorImpulse.Vel.y = -256 - p->Vel.y;
+				}
+				if (!Vec2iEqual(ei.u.ActorImpulse.Vel, p->Vel))
+				{
+					GameEventsEnqueue(&gGameEvents, ei);
+				}
+			}
+		}
+
+		SimTimersLap(&data->Timers, SIM_TIMER_OTHER);
+		UpdateAllActors();
+		SimTimersLap(&data->Timers, SIM_TIMER_ACTORS);
+		// Seeking bullets need the actors where they are now
+		AIProximityUpdate();
+		UpdateMobileObjects(ticks);
+		SimTimersLap(&data->Timers, SIM_TIMER_MOBILE_OBJECTS);
+		ParticlesUpdate(&gParticles, ticks);
+		SimTimersLap(&data->Timers, SIM_TIMER_PARTICLES);
+
+		UpdateWatches(&gMap.triggers);
+		SimTimersLap(&data->Timers, SIM_TIMER_WATCHES);
+
+		HealthPickupsUpdate(&data->HP, ticks);
+		MarkPlayersViewsVisited(data->Explored);
+
+		bool isMissionComplete =
+			GetNumPlayersAlive() > 0 && IsMissionComplete(&gMission);
+		if (gMission.state == MISSION_STATE_PLAY && isMissionComplete)
+		{
+			GameEvent e;
+			e.Type = GAME_EVENT_MISSION_PICKUP;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+		if (gMission.state == MISSION_STATE_PICKUP &&
+			!isMissionComplete)
+		{
+			GameEvent e;
+			e.Type = GAME_EVENT_MISSION_INCOMPLETE;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+		if (gMission.state == MISSION_STATE_PICKUP &&
+			gMission.pickupTime + PICKUP_LIMIT <= gMission.time)
+		{
+			GameEvent e;
+			e.Type = GAME_EVENT_MISSION_END;
+			GameEventsEnqueue(&gGameEvents, e);
+		}
+
+		SimTimersLap(&data->Timers, SIM_TIMER_OTHER);
+		HandleGameEvents(
+			&gGameEvents, &data->Hud, &data->Shake, &data->HP,
+			&gEventHandlers);
+		SimTimersLap(&data->Timers, SIM_TIMER_EVENTS);
+	}
+
+	gMission.time += ticks;
+	data->Shake = ScreenShakeUpdate(data->Shake, ticks);
+
+	if (HasObjectives(gCampaign.Entry.Mode))
+	{
+		MissionUpdateObjectives(&gMission, &gMap);
+	}
+
+	// Check that all players have been destroyed
+	// Note: there's a period of time where players are dying
+	// Wait until after this period before ending the game
+	bool allPlayersDestroyed = true;
+	for (i = 0; i < gOptions.numPlayers; i++)
+	{
+		if (gPlayerIds[i] != -1)
+		{
+			allPlayersDestroyed = false;
+			break;
+		}
+	}
+	if (allPlayersDestroyed)
+	{
+		GameEvent e;
+		e.Type = GAME_EVENT_MISSION_END;
+		GameEventsEnqueue(&gGameEvents, e);
+	}
+	SimChecksumsTick(&gSimChecksums);
+	SimTimersLap(&data->Timers, SIM_TIMER_OTHER);
+	data->Timers.Ticks++;
+	data->Ticks++;
+
+	return hasUsedMap;
+}
+
 int gameloop(void)
 {
-	DrawBuffer buffer;
-	int is_esc_pressed = 0;
-	int isPaused = 0;
-	HUD hud;
+	GameLoopData data;
 	Vec2i lastPosition = Vec2iZero();
+	const Uint32 ticksPerSimTick = 1000 / FPS_FRAMELIMIT;
 	Uint32 ticksNow;
 	Uint32 ticksThen;
-	Uint32 ticksElapsed = 0;
+	Uint32 ticksAccumulated = 0;
 	Uint32 ticksElapsedDraw = 0;
-	int frames = 0;
-	int framesSkipped = 0;
-	ScreenShake shake = ScreenShakeZero();
-	HealthPickups hp;
+	Uint32 ticksNextFrame;
+	CArray savedPositions;
 
-	DrawBufferInit(&buffer, Vec2iNew(X_TILES, Y_TILES), &gGraphicsDevice);
-	HUDInit(&hud, &gConfig.Interface, &gGraphicsDevice, &gMission);
+	memset(&data, 0, sizeof data);
+	data.Shake = ScreenShakeZero();
+	DrawBufferInit(&data.Buffer, Vec2iNew(X_TILES, Y_TILES), &gGraphicsDevice);
+	HUDInit(&data.Hud, &gConfig.Interface, &gGraphicsDevice, &gMission);
 	GameEventsInit(&gGameEvents);
-	HealthPickupsInit(&hp, &gMap);
+	AIFlowFieldsInit();
+	AIProximityInit();
+	VisibilityCacheInit(&gVisibility);
+	AIThreadsInit();
+	HealthPickupsInit(&data.HP, &gMap);
+	CArrayInit(&savedPositions, sizeof(Vec2i));
 
 	if (MusicGetStatus(&gSoundDevice) != MUSIC_OK)
 	{
-		HUDDisplayMessage(&hud, MusicGetErrorMessage(&gSoundDevice), 140);
+		HUDDisplayMessage(
+			&data.Hud, MusicGetErrorMessage(&gSoundDevice), 140);
 	}
 
 	gMission.time = 0;
@@ -489,238 +961,78 @@ int gameloop(void)
 
 	// Check if mission is done already
 	MissionSetMessageIfComplete(&gMission);
+	SimTimersInit(&data.Timers, gHeadless.Enabled);
 	ticksNow = SDL_GetTicks();
+	ticksNextFrame = ticksNow;
 	while (!gMission.isDone)
 	{
-		int cmds[MAX_PLAYERS];
-		int cmdAll = 0;
-		int ticks = 1;
-		int i;
-		int hasUsedMap = 0;
 		ticksThen = ticksNow;
 		ticksNow = SDL_GetTicks();
-		ticksElapsed += ticksNow - ticksThen;
-		ticksElapsedDraw += ticksNow - ticksThen;
-		if (ticksElapsed < 1000 / FPS_FRAMELIMIT)
+		if (gHeadless.Enabled)
 		{
+			// Run one tick per loop, as fast as possible, never drawing
+			GameTick(&data, ticksNow);
+			if (gHeadless.MaxTicks > 0 &&
+				data.Timers.Ticks >= gHeadless.MaxTicks)
+			{
+				gMission.isDone = true;
+			}
+			continue;
+		}
+		if (ticksNow == ticksThen)
+		{
+			// Nothing new to simulate or draw yet
 			SDL_Delay(1);
-			debug(D_VERBOSE, "Delaying 1 ticksNow %u elapsed %u\n", ticksNow, ticksElapsed);
 			continue;
 		}
+		ticksAccumulated += ticksNow - ticksThen;
+		ticksElapsedDraw += ticksNow - ticksThen;
 
 #ifndef RUN_WITHOUT_APP_FOCUS
 		MusicSetPlaying(&gSoundDevice, SDL_GetAppState() & SDL_APPINPUTFOCUS);
 #endif
-		// Only process input every 2 frames
-		if ((frames & 1) == 0)
-		{
-			EventPoll(&gEventHandlers, ticksNow);
-			if (gEventHandlers.HasQuit)
-			{
-				gMission.isDone = true;
-			}
-			for (i = 0; i < MAX_PLAYERS; i++)
-			{
-				if (IsPlayerAlive(i))
-				{
-					cmds[i] = GetGameCmd(
-						&gEventHandlers,
-						&gConfig.Input,
-						&gPlayerDatas[i],
-						GetPlayerCenter(&gGraphicsDevice, &buffer, i));
-					cmdAll |= cmds[i];
-				}
-			}
-			Uint32 ticksBeforeMap = SDL_GetTicks();
-			is_esc_pressed = HandleKey(
-				cmdAll, &isPaused, &hasUsedMap, hud.showExit);
-			if (is_esc_pressed)
-			{
-				if (isPaused)
-				{
-					GameEvent e;
-					e.Type = GAME_EVENT_MISSION_END;
-					GameEventsEnqueue(&gGameEvents, e);
-					// Also explicitly set done
-					// otherwise game will not quit immediately
-					gMission.isDone = true;
-				}
-				else
-				{
-					isPaused = 1;
-				}
-			}
-			if (hasUsedMap)
-			{
-				// Map keeps the game paused, reset the time elapsed counter
-				ticksNow += SDL_GetTicks() - ticksBeforeMap;
-			}
-		}
 
-		if (!isPaused)
+		// Run as many fixed sim ticks as real time has elapsed;
+		// if we fall too far behind, drop the backlog rather than spiral
+		int simTicks = 0;
+		while (ticksAccumulated >= ticksPerSimTick && !gMission.isDone)
 		{
-			if (!gConfig.Game.SlowMotion || (frames & 1) == 0)
+			if (simTicks == MAX_SIM_TICKS_PER_FRAME)
 			{
-				for (i = 0; i < gOptions.numPlayers; i++)
-				{
-					if (!IsPlayerAlive(i))
-					{
-						continue;
-					}
-					TActor *player = CArrayGet(&gActors, gPlayerIds[i]);
-					if (gPlayerDatas[i].inputDevice == INPUT_DEVICE_AI)
-					{
-						cmds[i] = AICoopGetCmd(player, ticks);
-					}
-					PlayerSpecialCommands(player, cmds[i]);
-					CommandActor(player, cmds[i], ticks);
-				}
-
-				if (gOptions.badGuys)
-				{
-					CommandBadGuys(ticks);
-				}
-				
-				// If split screen never and players are too close to the
-				// edge of the screen, forcefully pull them towards the center
-				if (gConfig.Interface.Splitscreen == SPLITSCREEN_NEVER &&
-					IsSingleScreen(
-						&gGraphicsDevice.cachedConfig,
-						gConfig.Interface.Splitscreen))
-				{
-					int w = gGraphicsDevice.cachedConfig.Res.x;
-					int h = gGraphicsDevice.cachedConfig.Res.y;
-					Vec2i screen = Vec2iAdd(
-						PlayersGetMidpoint(), Vec2iNew(-w / 2, -h / 2));
-					for (i = 0; i < gOptions.numPlayers; i++)
-					{
-						if (!IsPlayerAlive(i))
-						{
-							continue;
-						}
-						TActor *p = CArrayGet(&gActors, gPlayerIds[i]);
-						int pad = SPLIT_PADDING;
-						GameEvent ei;
-						ei.Type = GAME_EVENT_ACTOR_IMPULSE;
-						ei.u.ActorImpulse.Id = p->tileItem.id;
-						ei.u.ActorImpulse.Vel = p->Vel;
-						if (screen.x + pad > p->tileItem.x &&
-							p->Vel.x < 256)
-						{
-							ei.u.ActorImpulse.Vel.x = 256 - p->Vel.x;
-						}
-						else if (screen.x + w - pad < p->tileItem.x &&
-							p->Vel.x > -256)
-						{
-							ei.u.ActorImpulse.Vel.x = -256 - p->Vel.x;
-						}
-						if (screen.y + pad > p->tileItem.y &&
-							p->Vel.y < 256)
-						{
-							ei.u.ActorImpulse.Vel.y = 256 - p->Vel.y;
-						}
-						else if (screen.y + h - pad < p->tileItem.y &&
-							p->Vel.y > -256)
-						{
-							ei.u.ActorImpulse.Vel.y = -256 - p->Vel.y;
-						}
-						if (!Vec2iEqual(ei.u.ActorImpulse.Vel, p->Vel))
-						{
-							GameEventsEnqueue(&gGameEvents, ei);
-						}
-					}
-				}
-				
-				UpdateAllActors(ticks);
-				UpdateMobileObjects(ticks);
-				ParticlesUpdate(&gParticles, ticks);
-
-				UpdateWatches(&gMap.triggers);
-
-				HealthPickupsUpdate(&hp, ticks);
-
-				bool isMissionComplete =
-					GetNumPlayersAlive() > 0 && IsMissionComplete(&gMission);
-				if (gMission.state == MISSION_STATE_PLAY && isMissionComplete)
-				{
-					GameEvent e;
-					e.Type = GAME_EVENT_MISSION_PICKUP;
-					GameEventsEnqueue(&gGameEvents, e);
-				}
-				if (gMission.state == MISSION_STATE_PICKUP &&
-					!isMissionComplete)
-				{
-					GameEvent e;
-					e.Type = GAME_EVENT_MISSION_INCOMPLETE;
-					GameEventsEnqueue(&gGameEvents, e);
-				}
-				if (gMission.state == MISSION_STATE_PICKUP &&
-					gMission.pickupTime + PICKUP_LIMIT <= gMission.time)
-				{
-					GameEvent e;
-					e.Type = GAME_EVENT_MISSION_END;
-					GameEventsEnqueue(&gGameEvents, e);
-				}
-
-				HandleGameEvents(
-					&gGameEvents, &hud, &shake, &hp, &gEventHandlers);
+				ticksAccumulated %= ticksPerSimTick;
+				break;
 			}
-
-			gMission.time += ticks;
-
-			if (HasObjectives(gCampaign.Entry.Mode))
-			{
-				MissionUpdateObjectives(&gMission, &gMap);
-			}
-
-			// Check that all players have been destroyed
-			// Note: there's a period of time where players are dying
-			// Wait until after this period before ending the game
-			bool allPlayersDestroyed = true;
-			for (i = 0; i < gOptions.numPlayers; i++)
-			{
-				if (gPlayerIds[i] != -1)
-				{
-					allPlayersDestroyed = false;
-					break;
-				}
-			}
-			if (allPlayersDestroyed)
+			if (GameTick(&data, ticksNow))
 			{
-				GameEvent e;
-				e.Type = GAME_EVENT_MISSION_END;
-				GameEventsEnqueue(&gGameEvents, e);
+				// Map keeps the game paused, reset the time elapsed counter
+				ticksNow = SDL_GetTicks();
+				ticksAccumulated = 0;
+				break;
 			}
+			ticksAccumulated -= ticksPerSimTick;
+			simTicks++;
 		}
 
-		ticksElapsed -= 1000 / FPS_FRAMELIMIT;
-		frames++;
-		if (frames > FPS_FRAMELIMIT)
-		{
-			frames = 0;
-		}
-		// frame skip
-		if (ticksElapsed > 1000 / FPS_FRAMELIMIT &&
-			framesSkipped < MAX_FRAMESKIP)
-		{
-			framesSkipped++;
-			continue;
-		}
-		framesSkipped = 0;
-
 		// Don't update HUD if paused, only draw
-		if (!isPaused)
+		if (!data.IsPaused)
 		{
-			shake = ScreenShakeUpdate(shake, ticks);
-
-			HUDUpdate(&hud, ticksElapsedDraw);
+			HUDUpdate(&data.Hud, ticksElapsedDraw);
 		}
 
-		lastPosition = DrawScreen(&buffer, lastPosition, shake);
+		// Draw things part way between the last two sim states
+		InterpolateData interp;
+		interp.Saved = &savedPositions;
+		interp.Index = 0;
+		interp.Alpha = data.IsPaused ? ticksPerSimTick : ticksAccumulated;
+		interp.AlphaMax = ticksPerSimTick;
+		CArrayClear(&savedPositions);
+		ForEachMovingTileItem(InterpolatePos, &interp);
+		lastPosition = DrawScreen(&data.Buffer, lastPosition, data.Shake);
+		ForEachMovingTileItem(RestorePos, &interp);
 
-		debug(D_VERBOSE, "frames... %d\n", frames);
+		debug(D_VERBOSE, "sim ticks... %d\n", simTicks);
 
-		HUDDraw(&hud, isPaused);
+		HUDDraw(&data.Hud, data.IsPaused);
 		if (GameIsMouseUsed(gPlayerDatas))
 		{
 			MouseDraw(&gEventHandlers.mouse);
@@ -729,10 +1041,38 @@ int gameloop(void)
 		BlitFlip(&gGraphicsDevice, &gConfig.Graphics);
 
 		ticksElapsedDraw = 0;
+
+		// The screen is a software surface, so flipping doesn't wait for
+		// vsync; rather than draw again straight away, sleep until the
+		// next frame is due. This is independent of the sim rate, so that
+		// drawing can still interpolate between sim ticks.
+		if (gConfig.Graphics.MaxFPS > 0)
+		{
+			ticksNextFrame += 1000 / gConfig.Graphics.MaxFPS;
+			const Uint32 ticksDrawn = SDL_GetTicks();
+			if ((Sint32)(ticksNextFrame - ticksDrawn) > 0)
+			{
+				SDL_Delay(ticksNextFrame - ticksDrawn);
+			}
+			else
+			{
+				// Running behind; don't try to catch up
+				ticksNextFrame = ticksDrawn;
+			}
+		}
+	}
+	if (gHeadless.Enabled)
+	{
+		SimTimersPrint(&data.Timers);
 	}
+	CArrayTerminate(&savedPositions);
+	AIThreadsTerminate();
+	VisibilityCacheTerminate(&gVisibility);
+	AIProximityTerminate();
+	AIFlowFieldsTerminate();
 	GameEventsTerminate(&gGameEvents);
-	HUDTerminate(&hud);
-	DrawBufferTerminate(&buffer);
+	HUDTerminate(&data.Hud);
+	DrawBufferTerminate(&data.Buffer);
 
 	return
 		gMission.state == MISSION_STATE_PICKUP &&
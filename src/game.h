@@ -22,6 +22,17 @@
 #ifndef __GAME
 #define __GAME
 
+#include <stdbool.h>
+
+// Headless mode runs the simulation as fast as possible, without drawing,
+// sound or frame delays; used for benchmarking and soak testing
+typedef struct
+{
+	bool Enabled;
+	int MaxTicks;	// stop each mission after this many ticks; 0 = no limit
+} HeadlessOptions;
+extern HeadlessOptions gHeadless;
+
 int gameloop(void);
 
 #endif
@@ -34,6 +34,9 @@
 #include <cdogs/triggers.h>
 
 
+static bool HandleGameEventBatch(
+	const GameEventStore *store, const GameEventType type,
+	const int start, const int end);
 static void HandleGameEvent(
 	GameEvent *e,
 	HUD *hud,
@@ -41,19 +44,96 @@ static void HandleGameEvent(
 	HealthPickups *hp,
 	EventHandlers *eventHandlers);
 void HandleGameEvents(
-	CArray *store,
+	GameEventStore *store,
 	HUD *hud,
 	ScreenShake *shake,
 	HealthPickups *hp,
 	EventHandlers *eventHandlers)
 {
-	for (int i = 0; i < (int)store->size; i++)
+	// Events are handled in the order they were queued, including events
+	// queued while handling; consecutive events of the same type are
+	// handled together where possible
+	int i = 0;
+	while (i < GameEventsCount(store))
 	{
-		GameEvent *e = CArrayGet(store, i);
-		HandleGameEvent(e, hud, shake, hp, eventHandlers);
+		const GameEventType type = GameEventsType(store, i);
+		int end = i + 1;
+		while (end < GameEventsCount(store) &&
+			GameEventsType(store, end) == type)
+		{
+			end++;
+		}
+		if (!HandleGameEventBatch(store, type, i, end))
+		{
+			for (; i < end; i++)
+			{
+				// Copy out since handling may queue more events,
+				// which can move the payloads
+				GameEvent e;
+				GameEventsGet(store, i, &e);
+				HandleGameEvent(&e, hud, shake, hp, eventHandlers);
+			}
+		}
+		i = end;
 	}
 	GameEventsClear(store);
 }
+static bool IsPoolRemoveCurrent(const CPool *p, const PoolRemove *r)
+{
+	return
+		CPoolIsLive(p, r->Id) && CPoolGeneration(p, r->Id) == r->Generation;
+}
+// Handle a run of events of the same type, for the common high-volume
+// events whose handlers don't queue more events, so the payloads can be
+// read in place
+// Returns whether the events were handled
+static bool HandleGameEventBatch(
+	const GameEventStore *store, const GameEventType type,
+	const int start, const int end)
+{
+	switch (type)
+	{
+		case GAME_EVENT_SOUND_AT:
+			for (int i = start; i < end; i++)
+			{
+				const SoundAt *s = GameEventsPayload(store, i);
+				if (s->Sound)
+				{
+					SoundPlayAt(&gSoundDevice, s->Sound, s->Pos);
+				}
+			}
+			return true;
+		case GAME_EVENT_MOBILE_OBJECT_REMOVE:
+			for (int i = start; i < end; i++)
+			{
+				const PoolRemove *r = GameEventsPayload(store, i);
+				if (IsPoolRemoveCurrent(&gMobObjs, r))
+				{
+					MobObjDestroy(r->Id);
+				}
+			}
+			return true;
+		case GAME_EVENT_PARTICLE_REMOVE:
+			for (int i = start; i < end; i++)
+			{
+				const PoolRemove *r = GameEventsPayload(store, i);
+				if (IsPoolRemoveCurrent(&gParticles.Pool, r))
+				{
+					ParticleDestroy(&gParticles, r->Id);
+				}
+			}
+			return true;
+		case GAME_EVENT_ADD_PARTICLE:
+			for (int i = start; i < end; i++)
+			{
+				const AddParticle *a = GameEventsPayload(store, i);
+				ParticleAdd(&gParticles, *a);
+			}
+			return true;
+		default:
+			return false;
+	}
+}
 static void HandleGameEvent(
 	GameEvent *e,
 	HUD *hud,
@@ -67,13 +147,6 @@ static void HandleGameEvent(
 			Score(&gPlayerDatas[e->u.Score.PlayerIndex], e->u.Score.Score);
 			HUDAddScoreUpdate(hud, e->u.Score.PlayerIndex, e->u.Score.Score);
 			break;
-		case GAME_EVENT_SOUND_AT:
-			if (e->u.SoundAt.Sound)
-			{
-				SoundPlayAt(
-					&gSoundDevice, e->u.SoundAt.Sound, e->u.SoundAt.Pos);
-			}
-			break;
 		case GAME_EVENT_SCREEN_SHAKE:
 			*shake = ScreenShakeAdd(
 				*shake, e->u.ShakeAmount, gConfig.Graphics.ShakeMultiplier);
@@ -100,18 +173,9 @@ static void HandleGameEvent(
 					hud, e->u.PickupPlayer, HEALTH_PICKUP_HEAL_AMOUNT);
 			}
 			break;
-		case GAME_EVENT_MOBILE_OBJECT_REMOVE:
-			MobObjDestroy(e->u.MobileObjectRemoveId);
-			break;
-		case GAME_EVENT_PARTICLE_REMOVE:
-			ParticleDestroy(&gParticles, e->u.ParticleRemoveId);
-			break;
 		case GAME_EVENT_ADD_BULLET:
 			BulletAdd(e->u.AddBullet);
 			break;
-		case GAME_EVENT_ADD_PARTICLE:
-			ParticleAdd(&gParticles, e->u.AddParticle);
-			break;
 		case GAME_EVENT_HIT_CHARACTER:
 			ActorTakeHit(
 				CArrayGet(&gActors, e->u.HitCharacter.TargetId),
@@ -138,10 +202,11 @@ static void HandleGameEvent(
 			break;
 		case GAME_EVENT_TRIGGER:
 			{
-				const Tile *t = MapGetTile(&gMap, e->u.Trigger.TilePos);
-				for (int i = 0; i < (int)t->triggers.size; i++)
+				const CArray *triggers =
+					MapGetTileTriggers(&gMap, e->u.Trigger.TilePos);
+				for (int i = 0; i < (int)triggers->size; i++)
 				{
-					Trigger **tp = CArrayGet(&t->triggers, i);
+					Trigger **tp = CArrayGet(triggers, i);
 					if ((*tp)->id == e->u.Trigger.Id)
 					{
 						TriggerActivate(*tp, &gMap.triggers);
@@ -30,12 +30,13 @@
 
 #include <cdogs/c_array.h>
 #include <cdogs/events.h>
+#include <cdogs/game_events.h>
 #include <cdogs/health_pickup.h>
 #include <cdogs/hud.h>
 #include <cdogs/screen_shake.h>
 
 void HandleGameEvents(
-	CArray *store,
+	GameEventStore *store,
 	HUD *hud,
 	ScreenShake *shake,
 	HealthPickups *hp,
@@ -0,0 +1,97 @@
+#include <cbehave/cbehave.h>
+
+#include <bit_grid.h>
+
+
+FEATURE(1, "Bit grid")
+	SCENARIO("Set and get across words")
+	{
+		BitGrid g;
+		GIVEN("a grid wider than a word, with some bits set")
+			BitGridInit(&g, Vec2iNew(70, 3));
+			BitGridSet(&g, Vec2iNew(0, 0), true);
+			BitGridSet(&g, Vec2iNew(31, 1), true);
+			BitGridSet(&g, Vec2iNew(32, 1), true);
+			BitGridSet(&g, Vec2iNew(69, 2), true);
+			BitGridSet(&g, Vec2iNew(5, 2), true);
+			BitGridSet(&g, Vec2iNew(5, 2), false);
+		GIVEN_END
+
+		THEN("only the set bits should be true");
+			SHOULD_BE_TRUE(BitGridGet(&g, Vec2iNew(0, 0)));
+			SHOULD_BE_TRUE(BitGridGet(&g, Vec2iNew(31, 1)));
+			SHOULD_BE_TRUE(BitGridGet(&g, Vec2iNew(32, 1)));
+			SHOULD_BE_TRUE(BitGridGet(&g, Vec2iNew(69, 2)));
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(5, 2)));
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(0, 1)));
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(33, 1)));
+		THEN_END
+		THEN("cells outside the grid should be false");
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(-1, 0)));
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(70, 2)));
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(0, 3)));
+		THEN_END
+		BitGridTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Rectangle queries")
+	{
+		BitGrid g;
+		GIVEN("a grid with a bit set either side of a word boundary")
+			BitGridInit(&g, Vec2iNew(70, 4));
+			BitGridSet(&g, Vec2iNew(30, 1), true);
+			BitGridSet(&g, Vec2iNew(33, 2), true);
+		GIVEN_END
+
+		THEN("rectangles covering the bits should find them");
+			SHOULD_BE_TRUE(BitGridAnyInRect(
+				&g, Vec2iNew(30, 1), Vec2iNew(30, 1)));
+			SHOULD_BE_TRUE(BitGridAnyInRect(
+				&g, Vec2iNew(31, 0), Vec2iNew(40, 3)));
+			SHOULD_BE_TRUE(BitGridAnyInRect(
+				&g, Vec2iNew(-5, -5), Vec2iNew(100, 100)));
+		THEN_END
+		THEN("rectangles missing the bits should not");
+			SHOULD_BE_FALSE(BitGridAnyInRect(
+				&g, Vec2iNew(31, 0), Vec2iNew(32, 3)));
+			SHOULD_BE_FALSE(BitGridAnyInRect(
+				&g, Vec2iNew(0, 3), Vec2iNew(69, 3)));
+			SHOULD_BE_FALSE(BitGridAnyInRect(
+				&g, Vec2iNew(34, 0), Vec2iNew(69, 3)));
+			SHOULD_BE_FALSE(BitGridAnyInRect(
+				&g, Vec2iNew(80, 0), Vec2iNew(90, 3)));
+		THEN_END
+		BitGridTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Set all")
+	{
+		BitGrid g;
+		GIVEN("a grid with all bits set")
+			BitGridInit(&g, Vec2iNew(40, 2));
+			BitGridSetAll(&g, true);
+		GIVEN_END
+
+		THEN("every cell should be true");
+			SHOULD_BE_TRUE(BitGridGet(&g, Vec2iNew(0, 0)));
+			SHOULD_BE_TRUE(BitGridGet(&g, Vec2iNew(39, 1)));
+		THEN_END
+		THEN("cells outside the grid should still be false");
+			SHOULD_BE_FALSE(BitGridGet(&g, Vec2iNew(40, 1)));
+		THEN_END
+		BitGridTerminate(&g);
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+	
+	return cbehave_runner("Bit grid features are:", features);
+}
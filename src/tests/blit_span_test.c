@@ -0,0 +1,319 @@
+#include <cbehave/cbehave.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <blit_span.h>
+#include <rng.h>
+
+// Long enough for whole vectors and leftovers, at any alignment
+#define SPAN_MAX 37
+#define SPAN_OFFSETS 3
+#define BUF_SIZE (SPAN_MAX + SPAN_OFFSETS)
+// Stretching writes several pixels per source pixel
+#define STRETCH_MAX 5
+#define DST_SIZE (BUF_SIZE * STRETCH_MAX)
+
+// Source pixels with plenty of fully zero and zero-alpha ones
+static void FillSrc(Rng *r, Uint32 *buf)
+{
+	for (int i = 0; i < BUF_SIZE; i++)
+	{
+		switch (RngInt(r, 4))
+		{
+		case 0: buf[i] = 0; break;
+		case 1: buf[i] = RngNext(r) & 0x00FFFFFF; break;
+		default: buf[i] = RngNext(r); break;
+		}
+	}
+}
+static void FillDst(Rng *r, Uint32 *buf)
+{
+	for (int i = 0; i < DST_SIZE; i++)
+	{
+		buf[i] = RngNext(r);
+	}
+}
+
+typedef enum
+{
+	SPAN_TRANSPARENT,
+	SPAN_MASKED,
+	SPAN_TINT,
+	SPAN_BRIGHTEN,
+	SPAN_STRETCH
+} SpanType;
+typedef struct
+{
+	SpanType Type;
+	Uint32 Mask;
+	const BlitTint *Tint;
+	bool IsTransparent;
+	const BlitBrightness *Brightness;
+	int Scale;
+} SpanArgs;
+static void RunSpan(
+	const BlitSpanFuncs *f, const SpanArgs *a,
+	Uint32 *dst, const Uint32 *src, const int n)
+{
+	switch (a->Type)
+	{
+	case SPAN_TRANSPARENT: f->Transparent(dst, src, n, a->Mask); break;
+	case SPAN_MASKED: f->Masked(dst, src, n, a->Mask, a->IsTransparent); break;
+	case SPAN_TINT: f->Tint(dst, src, n, a->Tint, a->IsTransparent); break;
+	case SPAN_BRIGHTEN: f->Brighten(dst, src, n, a->Brightness); break;
+	case SPAN_STRETCH: f->Stretch(dst, src, n, a->Scale); break;
+	}
+}
+// Whether every supported implementation gives the same pixels as the
+// scalar one, for all span lengths and offsets, including the pixels just
+// outside the span
+static bool IsSameAsScalar(Rng *r, const SpanArgs *a)
+{
+	const BlitSpanFuncs *scalar = BlitSpanGetFuncs(BLIT_SPAN_SCALAR);
+	for (int impl = BLIT_SPAN_SCALAR + 1; impl < BLIT_SPAN_COUNT; impl++)
+	{
+		const BlitSpanFuncs *f = BlitSpanGetFuncs((BlitSpanImpl)impl);
+		if (f == NULL)
+		{
+			continue;
+		}
+		for (int n = 0; n <= SPAN_MAX; n++)
+		{
+			for (int offset = 0; offset < SPAN_OFFSETS; offset++)
+			{
+				Uint32 src[BUF_SIZE], expected[DST_SIZE], actual[DST_SIZE];
+				FillSrc(r, src);
+				FillDst(r, expected);
+				memcpy(actual, expected, sizeof actual);
+				RunSpan(scalar, a, expected + offset, src + offset, n);
+				RunSpan(f, a, actual + offset, src + offset, n);
+				if (memcmp(expected, actual, sizeof actual) != 0)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+
+FEATURE(1, "SIMD blitters")
+	SCENARIO("Transparent copy")
+	{
+		Rng r;
+		GIVEN("random pixels")
+			RngSeed(&r, 1, 1);
+		GIVEN_END
+
+		bool isSame = true;
+		WHEN("I copy them with each alpha mask")
+			const Uint32 amasks[] = { 0xFF000000, 0x000000FF };
+			for (int i = 0; i < 2; i++)
+			{
+				SpanArgs a;
+				memset(&a, 0, sizeof a);
+				a.Type = SPAN_TRANSPARENT;
+				a.Mask = amasks[i];
+				isSame = isSame && IsSameAsScalar(&r, &a);
+			}
+		WHEN_END
+
+		THEN("all implementations should give the same pixels");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Masked multiply")
+	{
+		Rng r;
+		GIVEN("random pixels")
+			RngSeed(&r, 2, 1);
+		GIVEN_END
+
+		bool isSame = true;
+		WHEN("I multiply them by masks, with and without transparency")
+			Uint32 masks[] = { 0xFFFFFFFF, 0, 0xFF606060, 0 };
+			masks[3] = RngNext(&r);
+			for (int i = 0; i < 4; i++)
+			{
+				SpanArgs a;
+				memset(&a, 0, sizeof a);
+				a.Type = SPAN_MASKED;
+				a.Mask = masks[i];
+				a.IsTransparent = false;
+				isSame = isSame && IsSameAsScalar(&r, &a);
+				a.IsTransparent = true;
+				isSame = isSame && IsSameAsScalar(&r, &a);
+			}
+		WHEN_END
+
+		THEN("all implementations should give the same pixels");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Masked multiply by white")
+	{
+		Uint32 src[4] = { 0x12345678, 0xFFFFFFFF, 0, 0x80FF0001 };
+		Uint32 dst[4];
+		GIVEN("some pixels")
+			memset(dst, 0, sizeof dst);
+		GIVEN_END
+
+		WHEN("I multiply them by white")
+			gBlitSpan.Masked(dst, src, 4, 0xFFFFFFFF, false);
+		WHEN_END
+
+		THEN("they should be copied unchanged");
+			SHOULD_MEM_EQUAL(dst, src, sizeof dst);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Tint")
+	{
+		Rng r;
+		GIVEN("random pixels")
+			RngSeed(&r, 3, 1);
+		GIVEN_END
+
+		bool isSame = true;
+		WHEN("I tint them, in two pixel layouts")
+			// Hue kept, hue forced, gray, and saturation changed
+			const HSV tints[] =
+			{
+				{ -1.0, 1.0, 1.0 },
+				{ -1.0, 1.0, 0.75 },
+				{ 0.0, 1.0, 1.0 },
+				{ 120.0, 0.33, 2.0 },
+				{ 300, 1.0, 1.0 },
+				{ -1.0, 0.0, 1.0 },
+				{ -1.0, 0.4, 1.3 },
+				{ -1.0, 1.5, 0.9 }
+			};
+			for (int i = 0; i < 8; i++)
+			{
+				BlitTint t;
+				SpanArgs a;
+				memset(&a, 0, sizeof a);
+				a.Type = SPAN_TINT;
+				a.Tint = &t;
+				BlitTintInit(&t, tints[i], 0xFF000000, 16, 8, 0);
+				a.IsTransparent = false;
+				isSame = isSame && IsSameAsScalar(&r, &a);
+				a.IsTransparent = true;
+				isSame = isSame && IsSameAsScalar(&r, &a);
+				BlitTintInit(&t, tints[i], 0x000000FF, 8, 16, 24);
+				isSame = isSame && IsSameAsScalar(&r, &a);
+			}
+		WHEN_END
+
+		THEN("all implementations should give the same pixels");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Brighten")
+	{
+		Rng r;
+		GIVEN("random pixels")
+			RngSeed(&r, 4, 1);
+		GIVEN_END
+
+		bool isSame = true;
+		WHEN("I brighten them by each brightness, and some too bright")
+			for (int brightness = -10; brightness <= 20; brightness++)
+			{
+				BlitBrightness b;
+				SpanArgs a;
+				memset(&a, 0, sizeof a);
+				a.Type = SPAN_BRIGHTEN;
+				a.Brightness = &b;
+				BlitBrightnessInit(&b, brightness);
+				isSame = isSame && IsSameAsScalar(&r, &a);
+			}
+		WHEN_END
+
+		THEN("all implementations should give the same pixels");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Brightness lookup")
+	{
+		bool isSame = true;
+		WHEN("I make the brightness lookup for each brightness")
+			for (int brightness = -10; brightness <= 10; brightness++)
+			{
+				BlitBrightness b;
+				BlitBrightnessInit(&b, brightness);
+				for (Uint32 c = 0; c < 256; c++)
+				{
+					// Saturated multiply
+					const Uint32 pp = c * b.M / 0xFF;
+					isSame = isSame &&
+						b.Lut[c] == ((pp | -!!(pp >> 8)) & 0xFF);
+				}
+			}
+		WHEN_END
+
+		THEN("each byte should be multiplied and saturated");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Brightness identity")
+	{
+		BlitBrightness b;
+		GIVEN("zero brightness")
+			BlitBrightnessInit(&b, 0);
+		GIVEN_END
+
+		THEN("the pixels should be unchanged");
+			SHOULD_BE_TRUE(BlitBrightnessIsIdentity(&b));
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Stretch")
+	{
+		Rng r;
+		GIVEN("random pixels")
+			RngSeed(&r, 5, 1);
+		GIVEN_END
+
+		bool isSame = true;
+		WHEN("I stretch them by each scale")
+			for (int scale = 1; scale <= STRETCH_MAX; scale++)
+			{
+				SpanArgs a;
+				memset(&a, 0, sizeof a);
+				a.Type = SPAN_STRETCH;
+				a.Scale = scale;
+				isSame = isSame && IsSameAsScalar(&r, &a);
+			}
+		WHEN_END
+
+		THEN("all implementations should give the same pixels");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("SIMD blitters features are:", features);
+}
@@ -0,0 +1,105 @@
+#include <cbehave/cbehave.h>
+
+#include <c_pool.h>
+
+
+FEATURE(1, "Pool add and remove")
+	SCENARIO("Reuse removed slots")
+	{
+		CPool p;
+		GIVEN("a pool with some elements, one of which is removed")
+			CPoolInit(&p, sizeof(int));
+			for (int i = 0; i < 5; i++)
+			{
+				*(int *)CPoolGet(&p, CPoolAdd(&p)) = i;
+			}
+			CPoolRemove(&p, 2);
+		GIVEN_END
+		unsigned int oldGeneration = CPoolGeneration(&p, 2);
+
+		int id;
+		WHEN("I add an element")
+			id = CPoolAdd(&p);
+		WHEN_END
+
+		THEN("the removed slot should be reused and zeroed, without growing the pool");
+			SHOULD_INT_EQUAL(id, 2);
+			SHOULD_INT_EQUAL(*(int *)CPoolGet(&p, id), 0);
+			SHOULD_INT_EQUAL((int)p.items.size, 5);
+			SHOULD_INT_EQUAL(CPoolLiveCount(&p), 5);
+			SHOULD_INT_EQUAL((int)CPoolGeneration(&p, 2), (int)oldGeneration);
+		THEN_END
+		CPoolTerminate(&p);
+	}
+	SCENARIO_END
+	SCENARIO("Removing bumps the generation")
+	{
+		CPool p;
+		GIVEN("a pool with an element")
+			CPoolInit(&p, sizeof(int));
+			CPoolAdd(&p);
+		GIVEN_END
+		unsigned int oldGeneration = CPoolGeneration(&p, 0);
+
+		WHEN("I remove the element")
+			CPoolRemove(&p, 0);
+		WHEN_END
+
+		THEN("the slot should be free and have a new generation");
+			SHOULD_INT_EQUAL(CPoolIsLive(&p, 0), 0);
+			SHOULD_INT_EQUAL((int)CPoolGeneration(&p, 0), (int)oldGeneration + 1);
+			SHOULD_INT_EQUAL(CPoolLiveCount(&p), 0);
+		THEN_END
+		CPoolTerminate(&p);
+	}
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(2, "Pool dense iteration")
+	SCENARIO("Iterate live elements only")
+	{
+		CPool p;
+		GIVEN("a pool with some elements removed")
+			CPoolInit(&p, sizeof(int));
+			for (int i = 0; i < 6; i++)
+			{
+				*(int *)CPoolGet(&p, CPoolAdd(&p)) = i;
+			}
+			CPoolRemove(&p, 1);
+			CPoolRemove(&p, 4);
+		GIVEN_END
+
+		int sum = 0;
+		int count = 0;
+		WHEN("I iterate over the live elements")
+			for (int i = 0; i < CPoolLiveCount(&p); i++)
+			{
+				sum += *(int *)CPoolGetLive(&p, i);
+				count++;
+			}
+		WHEN_END
+
+		THEN("only the live elements should be visited");
+			SHOULD_INT_EQUAL(count, 4);
+			SHOULD_INT_EQUAL(sum, 0 + 2 + 3 + 5);
+			for (int i = 0; i < CPoolLiveCount(&p); i++)
+			{
+				SHOULD_INT_EQUAL(CPoolIsLive(&p, CPoolLiveId(&p, i)), 1);
+				SHOULD_INT_EQUAL(CPoolLiveIndex(&p, CPoolLiveId(&p, i)), i);
+			}
+		THEN_END
+		CPoolTerminate(&p);
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)},
+		{feature_idx(2)}
+	};
+	
+	return cbehave_runner("CPool features are:", features);
+}
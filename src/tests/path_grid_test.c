@@ -0,0 +1,184 @@
+#include <cbehave/cbehave.h>
+
+#include <path_grid.h>
+
+#include <string.h>
+
+
+// Test maps, '#' are walls
+typedef struct
+{
+	const char **Rows;
+} TestMap;
+static bool IsTestMapTileOk(const TestMap *m, const Vec2i tile)
+{
+	return m->Rows[tile.y][tile.x] != '#';
+}
+static bool IsTileOk(void *data, Vec2i tile)
+{
+	return IsTestMapTileOk(data, tile);
+}
+static Vec2i TestMapSize(const TestMap *m)
+{
+	int h = 0;
+	while (m->Rows[h] != NULL)
+	{
+		h++;
+	}
+	return Vec2iNew((int)strlen(m->Rows[0]), h);
+}
+static bool IsPathValid(const TestMap *m, const CArray *path)
+{
+	for (int i = 0; i < (int)path->size; i++)
+	{
+		const Vec2i *v = CArrayGet(path, i);
+		if (!IsTestMapTileOk(m, *v))
+		{
+			return false;
+		}
+		if (i > 0)
+		{
+			const Vec2i *prev = CArrayGet(path, i - 1);
+			if (abs(v->x - prev->x) > 1 || abs(v->y - prev->y) > 1)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+FEATURE(1, "Grid pathfinding")
+	SCENARIO("Path in open space")
+	{
+		const char *rows[] =
+		{
+			"......",
+			"......",
+			"......",
+			NULL
+		};
+		TestMap m = { rows };
+		PathGrid g;
+		CArray path;
+		GIVEN("an open map")
+			PathGridInit(&g, TestMapSize(&m));
+			CArrayInit(&path, sizeof(Vec2i));
+		GIVEN_END
+
+		bool found;
+		WHEN("I find a path along a row")
+			found = PathGridFind(
+				&g, Vec2iNew(0, 1), Vec2iNew(5, 1), IsTileOk, &m, &path);
+		WHEN_END
+
+		THEN("the path should go straight from start to goal");
+			SHOULD_INT_EQUAL(found, 1);
+			SHOULD_INT_EQUAL((int)path.size, 6);
+			SHOULD_INT_EQUAL(((Vec2i *)CArrayGet(&path, 0))->x, 0);
+			SHOULD_INT_EQUAL(((Vec2i *)CArrayGet(&path, 5))->x, 5);
+			SHOULD_INT_EQUAL(IsPathValid(&m, &path), 1);
+		THEN_END
+		CArrayTerminate(&path);
+		PathGridTerminate(&g);
+	}
+	SCENARIO_END
+	SCENARIO("Path around walls, repeatedly")
+	{
+		const char *rows[] =
+		{
+			"..#...",
+			"..#.#.",
+			"..#.#.",
+			"....#.",
+			NULL
+		};
+		TestMap m = { rows };
+		PathGrid g;
+		CArray path;
+		GIVEN("a map with walls")
+			PathGridInit(&g, TestMapSize(&m));
+			CArrayInit(&path, sizeof(Vec2i));
+		GIVEN_END
+
+		bool found1, found2;
+		int size1;
+		WHEN("I find the same path twice")
+			found1 = PathGridFind(
+				&g, Vec2iNew(0, 0), Vec2iNew(5, 3), IsTileOk, &m, &path);
+			size1 = (int)path.size;
+			found2 = PathGridFind(
+				&g, Vec2iNew(0, 0), Vec2iNew(5, 3), IsTileOk, &m, &path);
+		WHEN_END
+
+		THEN("both searches should find the same valid path around the walls");
+			SHOULD_INT_EQUAL(found1, 1);
+			SHOULD_INT_EQUAL(found2, 1);
+			SHOULD_INT_EQUAL((int)path.size, size1);
+			SHOULD_INT_EQUAL(IsPathValid(&m, &path), 1);
+			const Vec2i *end = CArrayGet(&path, (int)path.size - 1);
+			SHOULD_INT_EQUAL(end->x, 5);
+			SHOULD_INT_EQUAL(end->y, 3);
+		THEN_END
+		CArrayTerminate(&path);
+		PathGridTerminate(&g);
+	}
+	SCENARIO_END
+	SCENARIO("No path")
+	{
+		const char *rows[] =
+		{
+			"..#...",
+			"..#...",
+			"..#...",
+			NULL
+		};
+		TestMap m = { rows };
+		PathGrid g;
+		CArray path;
+		GIVEN("a map split by a wall")
+			PathGridInit(&g, TestMapSize(&m));
+			CArrayInit(&path, sizeof(Vec2i));
+		GIVEN_END
+
+		bool found;
+		WHEN("I find a path across the wall")
+			found = PathGridFind(
+				&g, Vec2iNew(0, 0), Vec2iNew(5, 2), IsTileOk, &m, &path);
+		WHEN_END
+
+		THEN("no path should be found");
+			SHOULD_INT_EQUAL(found, 0);
+			SHOULD_INT_EQUAL((int)path.size, 0);
+		THEN_END
+		CArrayTerminate(&path);
+		PathGridTerminate(&g);
+	}
+	SCENARIO_END
+	SCENARIO("Empty map")
+	{
+		PathGrid g;
+		bool isInit;
+		WHEN("I set up a grid for an empty map")
+			isInit = PathGridInit(&g, Vec2iNew(0, 3));
+		WHEN_END
+
+		THEN("the grid should not be set up");
+			SHOULD_INT_EQUAL(isInit, 0);
+			SHOULD_INT_EQUAL(PathGridIsInit(&g, Vec2iNew(0, 3)), 0);
+		THEN_END
+		PathGridTerminate(&g);
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+	
+	return cbehave_runner("Grid pathfinding features are:", features);
+}
@@ -0,0 +1,143 @@
+#include <cbehave/cbehave.h>
+
+#include <proximity.h>
+
+#include <stdlib.h>
+
+#include <utils.h>
+
+
+static bool IsEven(void *data, int id)
+{
+	UNUSED(data);
+	return (id % 2) == 0;
+}
+// Linear search, for comparison
+static int FindClosestLinear(
+	const Vec2i *positions, const int n, const Vec2i from,
+	ProximityFilterFunc filter)
+{
+	int closest = -1;
+	int minDistance = 0;
+	for (int i = 0; i < n; i++)
+	{
+		if (filter != NULL && !filter(NULL, i))
+		{
+			continue;
+		}
+		const int distance = CHEBYSHEV_DISTANCE(
+			from.x, from.y, positions[i].x, positions[i].y);
+		if (closest < 0 || distance < minDistance)
+		{
+			closest = i;
+			minDistance = distance;
+		}
+	}
+	return closest;
+}
+
+
+FEATURE(1, "Proximity grid")
+	SCENARIO("Empty grid")
+	{
+		ProximityGrid g;
+		GIVEN("an empty grid")
+			ProximityGridInit(&g, Vec2iNew(4, 4), Vec2iNew(10, 10));
+			ProximityGridBuild(&g);
+		GIVEN_END
+
+		int closest;
+		WHEN("I find the closest item")
+			closest = ProximityGridFindClosest(
+				&g, Vec2iNew(5, 5), NULL, NULL, NULL);
+		WHEN_END
+
+		THEN("nothing should be found");
+			SHOULD_INT_EQUAL(closest, -1);
+		THEN_END
+		ProximityGridTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Closest item")
+	{
+		ProximityGrid g;
+		GIVEN("a grid with items near and far")
+			ProximityGridInit(&g, Vec2iNew(4, 4), Vec2iNew(10, 10));
+			ProximityGridAdd(&g, 0, Vec2iNew(35, 35));
+			ProximityGridAdd(&g, 1, Vec2iNew(12, 9));
+			ProximityGridAdd(&g, 2, Vec2iNew(9, 9));
+			ProximityGridBuild(&g);
+		GIVEN_END
+
+		int closest;
+		int distance;
+		int closestFar;
+		WHEN("I find the closest item, from near and far")
+			closest = ProximityGridFindClosest(
+				&g, Vec2iNew(11, 11), NULL, NULL, &distance);
+			closestFar = ProximityGridFindClosest(
+				&g, Vec2iNew(100, 100), NULL, NULL, NULL);
+		WHEN_END
+
+		THEN("the closest should be found, with ties to the lowest id");
+			SHOULD_INT_EQUAL(closest, 1);
+			SHOULD_INT_EQUAL(distance, 2);
+			SHOULD_INT_EQUAL(closestFar, 0);
+		THEN_END
+		ProximityGridTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Same as a linear search")
+	{
+		#define NUM_ITEMS 200
+		ProximityGrid g;
+		Vec2i positions[NUM_ITEMS];
+		GIVEN("a grid with many random items")
+			srand(1);
+			ProximityGridInit(&g, Vec2iNew(8, 6), Vec2iNew(16, 12));
+			for (int i = 0; i < NUM_ITEMS; i++)
+			{
+				positions[i] = Vec2iNew(rand() % 128, rand() % 72);
+				ProximityGridAdd(&g, i, positions[i]);
+			}
+			ProximityGridBuild(&g);
+		GIVEN_END
+
+		int mismatches = 0;
+		WHEN("I query from many random positions, with and without filter")
+			for (int i = 0; i < 500; i++)
+			{
+				const Vec2i from =
+					Vec2iNew(rand() % 160 - 16, rand() % 100 - 14);
+				if (ProximityGridFindClosest(&g, from, NULL, NULL, NULL) !=
+					FindClosestLinear(positions, NUM_ITEMS, from, NULL))
+				{
+					mismatches++;
+				}
+				if (ProximityGridFindClosest(&g, from, IsEven, NULL, NULL) !=
+					FindClosestLinear(positions, NUM_ITEMS, from, IsEven))
+				{
+					mismatches++;
+				}
+			}
+		WHEN_END
+
+		THEN("the results should be the same");
+			SHOULD_INT_EQUAL(mismatches, 0);
+		THEN_END
+		ProximityGridTerminate(&g);
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+	
+	return cbehave_runner("Proximity grid features are:", features);
+}
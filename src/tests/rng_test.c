@@ -0,0 +1,120 @@
+#include <cbehave/cbehave.h>
+
+#include <stdbool.h>
+
+#include <rng.h>
+
+
+FEATURE(1, "Random number streams")
+	SCENARIO("Same seed and stream")
+	{
+		Rng r1, r2;
+		GIVEN("two generators with the same seed and stream")
+			RngSeed(&r1, 42, 1);
+			RngSeed(&r2, 42, 1);
+		GIVEN_END
+
+		bool isSame = true;
+		WHEN("I draw numbers from both")
+			for (int i = 0; i < 100; i++)
+			{
+				if (RngNext(&r1) != RngNext(&r2))
+				{
+					isSame = false;
+				}
+			}
+		WHEN_END
+
+		THEN("they should give the same numbers");
+			SHOULD_BE_TRUE(isSame);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Separate streams")
+	{
+		Rng r1, r2, r1Copy;
+		GIVEN("two generators with the same seed but different streams")
+			RngSeed(&r1, 42, 1);
+			RngSeed(&r2, 42, 2);
+			r1Copy = r1;
+		GIVEN_END
+
+		int same = 0;
+		bool isUnaffected = true;
+		WHEN("I draw numbers from both")
+			for (int i = 0; i < 100; i++)
+			{
+				const uint32_t n1 = RngNext(&r1);
+				if (n1 == RngNext(&r2))
+				{
+					same++;
+				}
+				if (n1 != RngNext(&r1Copy))
+				{
+					isUnaffected = false;
+				}
+			}
+		WHEN_END
+
+		THEN("they should give different numbers, unaffected by each other");
+			SHOULD_INT_EQUAL(same, 0);
+			SHOULD_BE_TRUE(isUnaffected);
+		THEN_END
+	}
+	SCENARIO_END
+
+	SCENARIO("Ranges")
+	{
+		Rng r;
+		GIVEN("a generator")
+			RngSeed(&r, 7, 1);
+		GIVEN_END
+
+		bool isInRange = true;
+		int counts[5] = { 0, 0, 0, 0, 0 };
+		WHEN("I draw many numbers in ranges")
+			for (int i = 0; i < 5000; i++)
+			{
+				const int n = RngRange(&r, -2, 3);
+				if (n < -2 || n >= 3)
+				{
+					isInRange = false;
+				}
+				else
+				{
+					counts[n + 2]++;
+				}
+				const double d = RngDouble(&r, -0.5, 0.5);
+				if (d < -0.5 || d >= 0.5)
+				{
+					isInRange = false;
+				}
+			}
+		WHEN_END
+
+		THEN("they should all be in range, and cover it");
+			SHOULD_BE_TRUE(isInRange);
+			for (int i = 0; i < 5; i++)
+			{
+				SHOULD_BE_TRUE(counts[i] > 800);
+			}
+		THEN_END
+		THEN("empty ranges should give their low end");
+			SHOULD_INT_EQUAL(RngRange(&r, 4, 4), 4);
+			SHOULD_INT_EQUAL(RngRange(&r, 4, 2), 4);
+			SHOULD_INT_EQUAL(RngInt(&r, 0), 0);
+		THEN_END
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+
+	return cbehave_runner("Random number streams features are:", features);
+}
@@ -0,0 +1,217 @@
+#include <cbehave/cbehave.h>
+
+#include <room_graph.h>
+
+#include <string.h>
+
+
+// Test maps, '#' are walls and 'R' are red doors
+#define RED_KEY 1
+typedef struct
+{
+	const char **Rows;
+} TestMap;
+static int GetTile(void *data, Vec2i tile)
+{
+	const TestMap *m = data;
+	switch (m->Rows[tile.y][tile.x])
+	{
+	case '#':
+		return ROOM_GRAPH_BLOCKED;
+	case 'R':
+		return RED_KEY;
+	default:
+		return 0;
+	}
+}
+static Vec2i TestMapSize(const TestMap *m)
+{
+	int h = 0;
+	while (m->Rows[h] != NULL)
+	{
+		h++;
+	}
+	return Vec2iNew((int)strlen(m->Rows[0]), h);
+}
+
+
+FEATURE(1, "Room graph")
+	SCENARIO("Areas in open space")
+	{
+		const char *rows[] =
+		{
+			"........................................",
+			"........................................",
+			NULL
+		};
+		TestMap m = { rows };
+		RoomGraph g;
+		RoomGraphSearch s;
+		CArray areas;
+		GIVEN("an open map spanning three clusters")
+			RoomGraphInit(&g);
+			RoomGraphSearchInit(&s);
+			CArrayInit(&areas, sizeof(int));
+		GIVEN_END
+
+		bool found;
+		WHEN("I build the graph and find a path from end to end")
+			RoomGraphBuild(&g, TestMapSize(&m), 0, GetTile, &m);
+			found = RoomGraphFind(
+				&g, &s,
+				RoomGraphGetArea(&g, Vec2iNew(0, 0)),
+				RoomGraphGetArea(&g, Vec2iNew(39, 1)),
+				0, &areas);
+		WHEN_END
+
+		THEN("there should be one area per cluster, all on the path");
+			SHOULD_INT_EQUAL((int)g.Areas.size, 3);
+			SHOULD_INT_EQUAL(found, 1);
+			SHOULD_INT_EQUAL((int)areas.size, 3);
+			SHOULD_INT_EQUAL(
+				*(int *)CArrayGet(&areas, 0),
+				RoomGraphGetArea(&g, Vec2iNew(0, 0)));
+			SHOULD_INT_EQUAL(
+				*(int *)CArrayGet(&areas, 2),
+				RoomGraphGetArea(&g, Vec2iNew(39, 0)));
+		THEN_END
+		CArrayTerminate(&areas);
+		RoomGraphSearchTerminate(&s);
+		RoomGraphTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Walls split areas")
+	{
+		const char *rows[] =
+		{
+			"..#...",
+			"..#...",
+			"..#...",
+			NULL
+		};
+		TestMap m = { rows };
+		RoomGraph g;
+		RoomGraphSearch s;
+		CArray areas;
+		GIVEN("a map split by a wall")
+			RoomGraphInit(&g);
+			RoomGraphSearchInit(&s);
+			CArrayInit(&areas, sizeof(int));
+		GIVEN_END
+
+		bool found;
+		WHEN("I find a path across the wall")
+			RoomGraphBuild(&g, TestMapSize(&m), 0, GetTile, &m);
+			found = RoomGraphFind(
+				&g, &s,
+				RoomGraphGetArea(&g, Vec2iNew(0, 0)),
+				RoomGraphGetArea(&g, Vec2iNew(5, 2)),
+				0, &areas);
+		WHEN_END
+
+		THEN("there should be two areas and no path");
+			SHOULD_INT_EQUAL((int)g.Areas.size, 2);
+			SHOULD_INT_EQUAL(RoomGraphGetArea(&g, Vec2iNew(2, 1)), -1);
+			SHOULD_INT_EQUAL(found, 0);
+			SHOULD_INT_EQUAL((int)areas.size, 0);
+		THEN_END
+		CArrayTerminate(&areas);
+		RoomGraphSearchTerminate(&s);
+		RoomGraphTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Locked doors")
+	{
+		const char *rows[] =
+		{
+			"..#...",
+			"..R...",
+			"..#...",
+			NULL
+		};
+		TestMap m = { rows };
+		RoomGraph g;
+		RoomGraphSearch s;
+		CArray areas;
+		GIVEN("two rooms joined by a red door")
+			RoomGraphInit(&g);
+			RoomGraphSearchInit(&s);
+			CArrayInit(&areas, sizeof(int));
+			RoomGraphBuild(&g, TestMapSize(&m), 0, GetTile, &m);
+		GIVEN_END
+
+		bool foundWithoutKey;
+		bool foundWithKey;
+		WHEN("I find paths through the door without and with the key")
+			const int from = RoomGraphGetArea(&g, Vec2iNew(0, 0));
+			const int to = RoomGraphGetArea(&g, Vec2iNew(5, 2));
+			foundWithoutKey = RoomGraphFind(&g, &s, from, to, 0, &areas);
+			foundWithKey = RoomGraphFind(&g, &s, from, to, RED_KEY, &areas);
+		WHEN_END
+
+		THEN("the door should be its own area, needing the key");
+			SHOULD_INT_EQUAL((int)g.Areas.size, 3);
+			SHOULD_INT_EQUAL(foundWithoutKey, 0);
+			SHOULD_INT_EQUAL(foundWithKey, 1);
+			SHOULD_INT_EQUAL((int)areas.size, 3);
+			SHOULD_INT_EQUAL(
+				*(int *)CArrayGet(&areas, 1),
+				RoomGraphGetArea(&g, Vec2iNew(2, 1)));
+		THEN_END
+		CArrayTerminate(&areas);
+		RoomGraphSearchTerminate(&s);
+		RoomGraphTerminate(&g);
+	}
+	SCENARIO_END
+
+	SCENARIO("Corridors")
+	{
+		const char *rows[] =
+		{
+			"..#...",
+			"......",
+			"######",
+			"......",
+			NULL
+		};
+		TestMap m = { rows };
+		RoomGraph g;
+		RoomGraphSearch s;
+		GIVEN("a map with two separate areas")
+			RoomGraphInit(&g);
+			RoomGraphSearchInit(&s);
+			RoomGraphBuild(&g, TestMapSize(&m), 0, GetTile, &m);
+		GIVEN_END
+
+		CArray areas;
+		WHEN("I set the corridor to the top area")
+			CArrayInit(&areas, sizeof(int));
+			const int area = RoomGraphGetArea(&g, Vec2iNew(0, 0));
+			CArrayPushBack(&areas, &area);
+			RoomGraphSetCorridor(&g, &s, &areas);
+		WHEN_END
+
+		THEN("only tiles in the top area should be in the corridor");
+			SHOULD_INT_EQUAL(RoomGraphIsInCorridor(&g, &s, Vec2iNew(5, 1)), 1);
+			SHOULD_INT_EQUAL(RoomGraphIsInCorridor(&g, &s, Vec2iNew(5, 3)), 0);
+			SHOULD_INT_EQUAL(RoomGraphIsInCorridor(&g, &s, Vec2iNew(2, 0)), 0);
+			SHOULD_INT_EQUAL(RoomGraphIsInCorridor(&g, &s, Vec2iNew(-1, 0)), 0);
+		THEN_END
+		CArrayTerminate(&areas);
+		RoomGraphSearchTerminate(&s);
+		RoomGraphTerminate(&g);
+	}
+	SCENARIO_END
+FEATURE_END
+
+int main(void)
+{
+	cbehave_feature features[] =
+	{
+		{feature_idx(1)}
+	};
+	
+	return cbehave_runner("Room graph features are:", features);
+}